@@ -45,22 +45,66 @@
 #include <pcl/point_types.h>
 #include <pcl/point_cloud.h>
 #include <pcl_ros/point_cloud.h>
+#include <scan_tools_common/scan_binning.h>
+#include <scan_tools_common/scan_geometry.h>
 
 namespace scan_tools {
 
 class LaserOrthoProjector
 {
-  typedef pcl::PointXYZ           PointT;
-  typedef pcl::PointCloud<PointT> PointCloudT;
-
   typedef geometry_msgs::PoseStamped PoseMsg;
   typedef sensor_msgs::Imu ImuMsg;
 
   public:
 
-    LaserOrthoProjector (ros::NodeHandle nh, ros::NodeHandle nh_private);
+    typedef pcl::PointXYZ           PointT;
+    typedef pcl::PointCloud<PointT> PointCloudT;
+
+    /**
+     * @param subscribe_scans  If false, the projector neither subscribes to
+     *                         scans nor publishes clouds; scans are
+     *                         projected by calling project() directly,
+     *                         e.g. from an in-process pipeline.
+     */
+    LaserOrthoProjector (ros::NodeHandle nh, ros::NodeHandle nh_private,
+                         bool subscribe_scans = true);
     virtual ~ LaserOrthoProjector ();
 
+    /**
+     * Projects scan_msg into the ortho frame, using the latest attitude.
+     *
+     * @returns False if the scan has to be skipped (no transform yet).
+     */
+    bool project (const sensor_msgs::LaserScan::ConstPtr& scan_msg, PointCloudT& cloud);
+
+    /**
+     * Projects scan_msg into the ortho frame like project(), and bins the
+     * points into scan_ortho by their angle around the ortho origin, as
+     * configured by the ~scan/ parameters.
+     *
+     * @returns False if the scan has to be skipped (no transform yet).
+     */
+    bool projectToScan (const sensor_msgs::LaserScan::ConstPtr& scan_msg,
+                        sensor_msgs::LaserScan& scan_ortho);
+
+    /**
+     * Projects the valid beams of scan_msg into the ortho frame, dropping
+     * those whose endpoint lies below min_height or above max_height
+     * there (e.g. floor hits while the platform pitches).
+     *
+     * @param geometry  cosine and sine of each beam angle
+     * @returns The number of beams dropped for their height.
+     */
+    static unsigned int projectScan (const sensor_msgs::LaserScan& scan_msg,
+                                     const tf::Transform& ortho_to_laser,
+                                     const ScanGeometry& geometry,
+                                     PointCloudT& cloud,
+                                     double min_height = -std::numeric_limits<double>::infinity(),
+                                     double max_height =  std::numeric_limits<double>::infinity());
+
+    // The ortho frame of a base pose: its x and y, and its yaw only
+    static void getOrthoTf (const tf::Transform& world_to_base, tf::Transform& world_to_ortho);
+
   private:
 
     // **** ROS-related
@@ -69,6 +113,7 @@ class LaserOrthoProjector
     ros::NodeHandle nh_private_;
 
     ros::Publisher cloud_publisher_;
+    ros::Publisher scan_publisher_;
 
     ros::Subscriber scan_subscriber_;
     ros::Subscriber imu_subscriber_;
@@ -87,22 +132,41 @@ class LaserOrthoProjector
     bool use_pose_;
     bool use_imu_;
 
+    bool publish_cloud_;
+    bool publish_scan_;
+
+    double scan_angle_min_;
+    double scan_angle_max_;
+    double scan_angle_increment_;
+    double scan_range_min_;
+    double scan_range_max_;   // 0 for the range_max of the input scans
+
+    double min_height_;       // of beam endpoints in the ortho frame
+    double max_height_;
+
     // **** state variables
 
     bool initialized_;
 
-    std::vector<double> a_sin_;
-    std::vector<double> a_cos_;
+    ScanGeometryPtr geometry_;  // sin and cos of the beam angles, shared
 
     PointT nan_point_;
 
     tf::Transform base_to_laser_; // static, cached
     tf::Transform ortho_to_laser_; // computed from b2l, w2b, w2o
 
+    uint64_t beams_count_;            // projected so far
+    uint64_t height_dropped_count_;   // of which outside of the height band
+
+    ScanBinningBuffers binning_buffers_;
+    sensor_msgs::LaserScan::Ptr scan_ortho_msg_;
+
     void scanCallback (const sensor_msgs::LaserScan::ConstPtr& scan_msg);
     void poseCallback (const PoseMsg::ConstPtr& pose_msg);
     void imuCallback  (const ImuMsg::ConstPtr& imu_msg);
-    void getOrthoTf(const tf::Transform& world_to_base, tf::Transform& world_to_ortho);
+    bool prepare (const sensor_msgs::LaserScan::ConstPtr& scan_msg);
+    void countDropped (const sensor_msgs::LaserScan& scan_msg, unsigned int dropped);
+    unsigned int binToScan (const sensor_msgs::LaserScan& scan_msg, sensor_msgs::LaserScan& scan_ortho);
     bool getBaseToLaserTf (const sensor_msgs::LaserScan::ConstPtr& scan_msg);
     void createCache (const sensor_msgs::LaserScan::ConstPtr& scan_msg);
 
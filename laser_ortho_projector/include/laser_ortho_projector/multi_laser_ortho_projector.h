@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LASER_ORTHO_PROJECTOR_MULTI_LASER_ORTHO_PROJECTOR_H
+#define LASER_ORTHO_PROJECTOR_MULTI_LASER_ORTHO_PROJECTOR_H
+
+#include <boost/thread/mutex.hpp>
+
+#include "laser_ortho_projector/laser_ortho_projector.h"
+
+namespace scan_tools {
+
+/**
+ * Projects the scans of several lasers into the ortho frame, like one
+ * LaserOrthoProjector per laser would, but with a single pose or imu
+ * subscription and attitude shared by all lasers. The scans of different
+ * lasers are projected concurrently, given a multi-threaded spinner or
+ * nodelet manager.
+ */
+class MultiLaserOrthoProjector
+{
+  typedef geometry_msgs::PoseStamped PoseMsg;
+  typedef sensor_msgs::Imu ImuMsg;
+
+  public:
+
+    typedef LaserOrthoProjector::PointT      PointT;
+    typedef LaserOrthoProjector::PointCloudT PointCloudT;
+
+    MultiLaserOrthoProjector (ros::NodeHandle nh, ros::NodeHandle nh_private);
+    virtual ~MultiLaserOrthoProjector ();
+
+  private:
+
+    // Only touched by the callback of its laser, except for cloud
+    struct Input
+    {
+      std::string topic;
+      ros::Subscriber scan_subscriber;
+      ros::Publisher  cloud_publisher;
+
+      bool initialized;
+      tf::Transform base_to_laser;  // static, cached
+      ScanGeometryPtr geometry;     // sin and cos of the beam angles, shared
+
+      PointCloudT::ConstPtr cloud;  // waiting to be merged, under merge_mutex_
+      ros::Time stamp;              // of cloud
+
+      uint64_t beams_count;
+      uint64_t height_dropped_count;
+    };
+
+    // **** ROS-related
+
+    ros::NodeHandle nh_;
+    ros::NodeHandle nh_private_;
+
+    ros::Subscriber imu_subscriber_;
+    ros::Subscriber pose_subscriber_;
+    ros::Publisher  merged_publisher_;
+
+    tf::TransformListener tf_listener_;
+    tf::TransformBroadcaster tf_broadcaster_;
+
+    // **** paramaters
+
+    std::string world_frame_;
+    std::string base_frame_;
+    std::string ortho_frame_;
+
+    bool publish_tf_;
+    bool use_pose_;
+    bool use_imu_;
+    bool publish_cloud_;
+    bool publish_merged_;
+
+    double min_height_;
+    double max_height_;
+    double slop_;
+
+    // **** state variables
+
+    std::vector<Input> inputs_;
+
+    boost::mutex attitude_mutex_;
+    tf::Transform ortho_to_base_;   // latest attitude, shared by all lasers
+
+    boost::mutex merge_mutex_;
+
+    // **** member functions
+
+    void scanCallback (const sensor_msgs::LaserScan::ConstPtr& scan_msg, unsigned int index);
+    void poseCallback (const PoseMsg::ConstPtr& pose_msg);
+    void imuCallback  (const ImuMsg::ConstPtr& imu_msg);
+    void setAttitude  (const tf::Transform& world_to_base, const ros::Time& stamp);
+    bool getBaseToLaserTf (Input& input, const sensor_msgs::LaserScan::ConstPtr& scan_msg);
+    bool synchronized () const;
+    void mergeClouds ();
+    void tokenize (const std::string& str, std::vector<std::string>& tokens);
+};
+
+} // namespace scan_tools
+
+#endif // LASER_ORTHO_PROJECTOR_MULTI_LASER_ORTHO_PROJECTOR_H
@@ -30,17 +30,25 @@
 #include "laser_ortho_projector/laser_ortho_projector.h"
 
 #include <pcl_conversions/pcl_conversions.h>
+#include <scan_tools_common/reuse_message.h>
+#include <scan_tools_common/trace.h>
 
 namespace scan_tools {
 
-LaserOrthoProjector::LaserOrthoProjector (ros::NodeHandle nh, ros::NodeHandle nh_private):
+LaserOrthoProjector::LaserOrthoProjector (ros::NodeHandle nh, ros::NodeHandle nh_private,
+                                          bool subscribe_scans):
   nh_(nh),
   nh_private_(nh_private)
 {
   ROS_INFO ("Starting LaserOrthoProjector");
 
+  Tracer::instance().advertise(nh_);
+
   initialized_ = false;
 
+  beams_count_ = 0;
+  height_dropped_count_ = 0;
+
   // set initial orientation to 0
 
   ortho_to_laser_.setIdentity();
@@ -63,17 +71,44 @@ LaserOrthoProjector::LaserOrthoProjector (ros::NodeHandle nh, ros::NodeHandle nh
     use_pose_ = true;
   if (!nh_private_.getParam ("use_imu", use_imu_))
     use_imu_ = false;
+  if (!nh_private_.getParam ("publish_cloud", publish_cloud_))
+    publish_cloud_ = true;
+  if (!nh_private_.getParam ("publish_scan", publish_scan_))
+    publish_scan_ = false;
+
+  if (!nh_private_.getParam ("scan/angle_min", scan_angle_min_))
+    scan_angle_min_ = -M_PI;
+  if (!nh_private_.getParam ("scan/angle_max", scan_angle_max_))
+    scan_angle_max_ = M_PI;
+  if (!nh_private_.getParam ("scan/angle_increment", scan_angle_increment_))
+    scan_angle_increment_ = M_PI / 720.0;
+  if (!nh_private_.getParam ("scan/range_min", scan_range_min_))
+    scan_range_min_ = 0.0;
+  if (!nh_private_.getParam ("scan/range_max", scan_range_max_))
+    scan_range_max_ = 0.0;
+
+  // no height band by default
+  if (!nh_private_.getParam ("min_height", min_height_))
+    min_height_ = -std::numeric_limits<double>::infinity();
+  if (!nh_private_.getParam ("max_height", max_height_))
+    max_height_ = std::numeric_limits<double>::infinity();
 
   if (use_imu_ && use_pose_)
     ROS_FATAL("use_imu and use_pose params cannot both be true");
   if (!use_imu_ && !use_pose_)
     ROS_FATAL("use_imu and use_pose params cannot both be false");
 
+  ROS_ASSERT_MSG(scan_angle_increment_ > 0.0 && scan_angle_max_ > scan_angle_min_,
+    "scan/angle_increment must be > 0, and scan/angle_max > scan/angle_min");
+
 
   // **** subscribe to laser scan messages
 
-  scan_subscriber_ = nh_.subscribe(
-    "scan", 10, &LaserOrthoProjector::scanCallback, this);
+  if (subscribe_scans)
+  {
+    scan_subscriber_ = nh_.subscribe(
+      "scan", 10, &LaserOrthoProjector::scanCallback, this);
+  }
 
   if (use_pose_)
   {
@@ -88,13 +123,24 @@ LaserOrthoProjector::LaserOrthoProjector (ros::NodeHandle nh, ros::NodeHandle nh
 
   // **** advertise orthogonal scan
 
-  cloud_publisher_ = nh_.advertise<PointCloudT>(
-    "cloud_ortho", 10);
+  if (subscribe_scans && publish_cloud_)
+  {
+    cloud_publisher_ = nh_.advertise<PointCloudT>(
+      "cloud_ortho", 10);
+  }
+  if (subscribe_scans && publish_scan_)
+  {
+    scan_publisher_ = nh_.advertise<sensor_msgs::LaserScan>(
+      "scan_ortho", 10);
+  }
 }
 
 LaserOrthoProjector::~LaserOrthoProjector()
 {
-
+  if (beams_count_ > 0 && height_dropped_count_ > 0)
+    ROS_INFO("Dropped %llu of %llu beams (%.1f%%) outside of the height band",
+      (unsigned long long)height_dropped_count_, (unsigned long long)beams_count_,
+      100.0 * height_dropped_count_ / beams_count_);
 }
 
 void LaserOrthoProjector::imuCallback(const ImuMsg::ConstPtr& imu_msg)
@@ -156,15 +202,113 @@ void LaserOrthoProjector::getOrthoTf(const tf::Transform& world_to_base, tf::Tra
 } 
 
 void LaserOrthoProjector::scanCallback(const sensor_msgs::LaserScan::ConstPtr& scan_msg)
+{
+  SCAN_TOOLS_TRACE("LaserOrthoProjector::scanCallback", scan_msg->header.stamp, scan_msg->header.frame_id);
+
+  if (!prepare(scan_msg)) return;
+
+  // **** build and publish projected cloud
+
+  if (publish_cloud_)
+  {
+    PointCloudT::Ptr cloud = 
+      boost::shared_ptr<PointCloudT>(new PointCloudT());
+
+    pcl_conversions::toPCL(scan_msg->header, cloud->header);
+    cloud->header.frame_id = ortho_frame_;
+
+    unsigned int dropped = projectScan(*scan_msg, ortho_to_laser_, *geometry_, *cloud,
+                                       min_height_, max_height_);
+    cloud_publisher_.publish (cloud);
+
+    countDropped(*scan_msg, dropped);
+  }
+
+  // **** build and publish projected scan, in place of a cloud to scan node
+
+  if (publish_scan_)
+  {
+    sensor_msgs::LaserScan::Ptr scan_ortho = reuseMessage(scan_ortho_msg_);
+
+    unsigned int dropped = binToScan(*scan_msg, *scan_ortho);
+    scan_publisher_.publish (scan_ortho);
+
+    if (!publish_cloud_) countDropped(*scan_msg, dropped);
+  }
+}
+
+bool LaserOrthoProjector::project(const sensor_msgs::LaserScan::ConstPtr& scan_msg,
+                                  PointCloudT& cloud)
+{
+  if (!prepare(scan_msg)) return false;
+
+  pcl_conversions::toPCL(scan_msg->header, cloud.header);
+  cloud.header.frame_id = ortho_frame_;
+
+  unsigned int dropped = projectScan(*scan_msg, ortho_to_laser_, *geometry_, cloud,
+                                     min_height_, max_height_);
+  countDropped(*scan_msg, dropped);
+
+  return true;
+}
+
+bool LaserOrthoProjector::projectToScan(const sensor_msgs::LaserScan::ConstPtr& scan_msg,
+                                        sensor_msgs::LaserScan& scan_ortho)
+{
+  if (!prepare(scan_msg)) return false;
+
+  unsigned int dropped = binToScan(*scan_msg, scan_ortho);
+  countDropped(*scan_msg, dropped);
+
+  return true;
+}
+
+void LaserOrthoProjector::countDropped(const sensor_msgs::LaserScan& scan_msg,
+                                       unsigned int dropped)
+{
+  beams_count_ += scan_msg.ranges.size();
+  height_dropped_count_ += dropped;
+
+  if (dropped > 0)
+    ROS_DEBUG("Dropped %u of %d beams outside of the height band",
+      dropped, (int)scan_msg.ranges.size());
+}
+
+unsigned int LaserOrthoProjector::binToScan(const sensor_msgs::LaserScan& scan_msg,
+                                            sensor_msgs::LaserScan& scan_ortho)
+{
+  unsigned int bins =
+    (unsigned int)((scan_angle_max_ - scan_angle_min_) / scan_angle_increment_ + 0.5) + 1;
+
+  scan_ortho.header          = scan_msg.header;
+  scan_ortho.header.frame_id = ortho_frame_;
+  scan_ortho.angle_min       = scan_angle_min_;
+  scan_ortho.angle_increment = scan_angle_increment_;
+  scan_ortho.angle_max       = scan_angle_min_ + scan_angle_increment_ * (bins - 1);
+  scan_ortho.range_min       = scan_range_min_;
+  scan_ortho.range_max       = scan_range_max_ > 0.0 ? scan_range_max_ : scan_msg.range_max;
+  scan_ortho.time_increment  = 0.0;
+  scan_ortho.scan_time       = scan_msg.scan_time;
+
+  scan_ortho.ranges.assign(bins, std::numeric_limits<float>::infinity());
+  scan_ortho.intensities.assign(scan_msg.intensities.empty() ? 0 : bins, 0.0);
+
+  return binScan(scan_msg, planarProjection(ortho_to_laser_), *geometry_,
+                 scan_ortho, binning_buffers_, min_height_, max_height_);
+}
+
+// Everything a scan needs before it can be projected
+bool LaserOrthoProjector::prepare(const sensor_msgs::LaserScan::ConstPtr& scan_msg)
 {
   if(!initialized_)
   {
     initialized_ = getBaseToLaserTf(scan_msg);
 
-    if (initialized_) createCache(scan_msg);
-    else return;
+    if (!initialized_) return false;
   }
 
+  createCache(scan_msg);    // O(1) if the geometry is unchanged
+
   if(!use_pose_)
   {
     // obtain transform between fixed and base frame
@@ -180,7 +324,7 @@ void LaserOrthoProjector::scanCallback(const sensor_msgs::LaserScan::ConstPtr& s
     {
       // transform unavailable - skip scan
       ROS_WARN("Skipping scan %s", ex.what());
-      return;
+      return false;
     }
 
     // calculate world to ortho frame transform
@@ -188,36 +332,52 @@ void LaserOrthoProjector::scanCallback(const sensor_msgs::LaserScan::ConstPtr& s
     getOrthoTf(world_to_base_tf, world_to_ortho);
   }
 
-  // **** build and publish projected cloud
+  return true;
+}
+
+unsigned int LaserOrthoProjector::projectScan (const sensor_msgs::LaserScan& scan_msg,
+                                               const tf::Transform& ortho_to_laser,
+                                               const ScanGeometry& geometry,
+                                               PointCloudT& cloud,
+                                               double min_height, double max_height)
+{
+  const double* a_cos = geometry.cos();
+  const double* a_sin = geometry.sin();
 
-  PointCloudT::Ptr cloud = 
-    boost::shared_ptr<PointCloudT>(new PointCloudT());
+  unsigned int dropped = 0;
 
-  pcl_conversions::toPCL(scan_msg->header, cloud->header);
-  cloud->header.frame_id = ortho_frame_;
+  cloud.points.clear();
+  cloud.points.reserve(scan_msg.ranges.size());
 
-  for (unsigned int i = 0; i < scan_msg->ranges.size(); i++)
+  for (unsigned int i = 0; i < scan_msg.ranges.size(); i++)
   {
-    double r = scan_msg->ranges[i];
+    double r = scan_msg.ranges[i];
 
-    if (r > scan_msg->range_min)
+    if (r > scan_msg.range_min)
     {
-      tf::Vector3 p(r * a_cos_[i], r * a_sin_[i], 0.0);
-      p = ortho_to_laser_ * p;
+      tf::Vector3 p(r * a_cos[i], r * a_sin[i], 0.0);
+      p = ortho_to_laser * p;
+
+      // the true endpoint, before it is flattened
+      if (!(p.getZ() >= min_height && p.getZ() <= max_height))
+      {
+        dropped++;
+        continue;
+      }
 
       PointT point;
       point.x = p.getX();
       point.y = p.getY();
       point.z = 0.0;
-      cloud->points.push_back(point);
+      cloud.points.push_back(point);
     }
   }
 
-  cloud->width = cloud->points.size();
-  cloud->height = 1;
-  cloud->is_dense = true; // no nan's present 
+  cloud.width = cloud.points.size();
+  cloud.height = 1;
+  cloud.is_dense = true; // no nan's present 
 
-  cloud_publisher_.publish (cloud);
+  return dropped;
 }
 
 bool LaserOrthoProjector::getBaseToLaserTf (const sensor_msgs::LaserScan::ConstPtr& scan_msg)
@@ -242,15 +402,8 @@ bool LaserOrthoProjector::getBaseToLaserTf (const sensor_msgs::LaserScan::ConstP
 
 void LaserOrthoProjector::createCache (const sensor_msgs::LaserScan::ConstPtr& scan_msg)
 {
-  a_cos_.clear();
-  a_sin_.clear();
-
-  for (unsigned int i = 0; i < scan_msg->ranges.size(); ++i)
-  {
-    double angle = scan_msg->angle_min + i * scan_msg->angle_increment;
-    a_cos_.push_back(cos(angle));
-    a_sin_.push_back(sin(angle));
-  }
+  ScanGeometryCache::update(geometry_, scan_msg->angle_min,
+                            scan_msg->angle_increment, scan_msg->ranges.size());
 }
 
 } //namespace scan_tools
@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "laser_ortho_projector/multi_laser_ortho_projector.h"
+
+#include <boost/bind.hpp>
+#include <pcl_conversions/pcl_conversions.h>
+#include <scan_tools_common/trace.h>
+
+namespace scan_tools {
+
+MultiLaserOrthoProjector::MultiLaserOrthoProjector (ros::NodeHandle nh, ros::NodeHandle nh_private):
+  nh_(nh),
+  nh_private_(nh_private)
+{
+  ROS_INFO ("Starting MultiLaserOrthoProjector");
+
+  Tracer::instance().advertise(nh_);
+
+  // set initial orientation to 0
+
+  ortho_to_base_.setIdentity();
+
+  // **** parameters
+
+  if (!nh_private_.getParam ("fixed_frame", world_frame_))
+    world_frame_ = "/world";
+  if (!nh_private_.getParam ("base_frame", base_frame_))
+    base_frame_ = "/base_link";
+  if (!nh_private_.getParam ("ortho_frame", ortho_frame_))
+    ortho_frame_ = "/base_ortho";
+  if (!nh_private_.getParam ("publish_tf", publish_tf_))
+    publish_tf_ = false;
+  if (!nh_private_.getParam ("use_pose", use_pose_))
+    use_pose_ = true;
+  if (!nh_private_.getParam ("use_imu", use_imu_))
+    use_imu_ = false;
+  if (!nh_private_.getParam ("publish_cloud", publish_cloud_))
+    publish_cloud_ = true;
+  if (!nh_private_.getParam ("publish_merged", publish_merged_))
+    publish_merged_ = false;
+  if (!nh_private_.getParam ("slop", slop_))
+    slop_ = 0.05;
+
+  // no height band by default
+  if (!nh_private_.getParam ("min_height", min_height_))
+    min_height_ = -std::numeric_limits<double>::infinity();
+  if (!nh_private_.getParam ("max_height", max_height_))
+    max_height_ = std::numeric_limits<double>::infinity();
+
+  std::string topics_string;
+  if (!nh_private_.getParam ("topics", topics_string))
+    topics_string = "scan_front scan_rear";
+
+  if (use_imu_ && use_pose_)
+    ROS_FATAL("use_imu and use_pose params cannot both be true");
+  if (!use_imu_ && !use_pose_)
+    ROS_FATAL("use_imu and use_pose params cannot both be false");
+
+  std::vector<std::string> topics;
+  tokenize(topics_string, topics);
+
+  ROS_ASSERT_MSG(!topics.empty(), "MultiLaserOrthoProjector: no input topics given");
+
+  // **** subscribe to the shared attitude
+
+  if (use_pose_)
+  {
+    pose_subscriber_ = nh_.subscribe(
+      "pose", 10, &MultiLaserOrthoProjector::poseCallback, this);
+  }
+  if (use_imu_)
+  {
+    imu_subscriber_ = nh_.subscribe(
+      "imu/data", 10, &MultiLaserOrthoProjector::imuCallback, this);
+  }
+
+  // **** advertise orthogonal clouds
+
+  if (publish_merged_)
+  {
+    merged_publisher_ = nh_.advertise<PointCloudT>(
+      "cloud_ortho", 10);
+  }
+
+  // **** subscribe to laser scan messages, one input per laser
+
+  inputs_.resize(topics.size());
+  for (unsigned int i = 0; i < topics.size(); i++)
+  {
+    Input& input = inputs_[i];
+
+    input.topic = topics[i];
+    input.initialized = false;
+    input.beams_count = 0;
+    input.height_dropped_count = 0;
+
+    if (publish_cloud_)
+    {
+      input.cloud_publisher = nh_.advertise<PointCloudT>(
+        topics[i] + "/cloud_ortho", 10);
+    }
+  }
+
+  // only once inputs_ is complete, as callbacks may start right away
+  for (unsigned int i = 0; i < inputs_.size(); i++)
+  {
+    inputs_[i].scan_subscriber = nh_.subscribe<sensor_msgs::LaserScan>(
+      inputs_[i].topic, 10, boost::bind(&MultiLaserOrthoProjector::scanCallback, this, _1, i));
+  }
+
+  ROS_INFO("Projecting %d lasers into the %s frame",
+    (int)inputs_.size(), ortho_frame_.c_str());
+}
+
+MultiLaserOrthoProjector::~MultiLaserOrthoProjector()
+{
+  ROS_INFO("Destroying MultiLaserOrthoProjector");
+
+  for (unsigned int i = 0; i < inputs_.size(); i++)
+  {
+    const Input& input = inputs_[i];
+
+    if (input.beams_count > 0 && input.height_dropped_count > 0)
+      ROS_INFO("%s: dropped %llu of %llu beams (%.1f%%) outside of the height band",
+        input.topic.c_str(),
+        (unsigned long long)input.height_dropped_count, (unsigned long long)input.beams_count,
+        100.0 * input.height_dropped_count / input.beams_count);
+  }
+}
+
+void MultiLaserOrthoProjector::imuCallback(const ImuMsg::ConstPtr& imu_msg)
+{
+  // obtain world to base frame transform from the imu message
+  tf::Transform world_to_base;
+  world_to_base.setIdentity();
+
+  tf::Quaternion q;
+  tf::quaternionMsgToTF(imu_msg->orientation, q);
+  world_to_base.setRotation(q);
+
+  setAttitude(world_to_base, imu_msg->header.stamp);
+}
+
+void MultiLaserOrthoProjector::poseCallback(const PoseMsg::ConstPtr& pose_msg)
+{
+  // obtain world to base frame transform from the pose message
+  tf::Transform world_to_base;
+  tf::poseMsgToTF(pose_msg->pose, world_to_base);
+
+  setAttitude(world_to_base, pose_msg->header.stamp);
+}
+
+void MultiLaserOrthoProjector::setAttitude(const tf::Transform& world_to_base,
+                                           const ros::Time& stamp)
+{
+  // calculate world to ortho frame transform
+  tf::Transform world_to_ortho;
+  LaserOrthoProjector::getOrthoTf(world_to_base, world_to_ortho);
+
+  if (publish_tf_)
+  {
+    tf::StampedTransform world_to_ortho_tf(
+      world_to_ortho, stamp, world_frame_, ortho_frame_);
+    tf_broadcaster_.sendTransform(world_to_ortho_tf);
+  }
+
+  // the laser part is applied per scan, with the laser's own transform
+  boost::mutex::scoped_lock lock(attitude_mutex_);
+  ortho_to_base_ = world_to_ortho.inverse() * world_to_base;
+}
+
+// Callbacks of different lasers run concurrently; those of one laser do
+// not, so an Input needs no lock of its own.
+void MultiLaserOrthoProjector::scanCallback(const sensor_msgs::LaserScan::ConstPtr& scan_msg,
+                                            unsigned int index)
+{
+  SCAN_TOOLS_TRACE("MultiLaserOrthoProjector::scanCallback", scan_msg->header.stamp, scan_msg->header.frame_id);
+
+  Input& input = inputs_[index];
+
+  if (!input.initialized)
+  {
+    input.initialized = getBaseToLaserTf(input, scan_msg);
+
+    if (!input.initialized) return;
+  }
+
+  ScanGeometryCache::update(input.geometry, scan_msg->angle_min,
+                            scan_msg->angle_increment, scan_msg->ranges.size());
+
+  tf::Transform ortho_to_laser;
+  {
+    boost::mutex::scoped_lock lock(attitude_mutex_);
+    ortho_to_laser = ortho_to_base_ * input.base_to_laser;
+  }
+
+  // **** build and publish projected cloud
+
+  PointCloudT::Ptr cloud =
+    boost::shared_ptr<PointCloudT>(new PointCloudT());
+
+  pcl_conversions::toPCL(scan_msg->header, cloud->header);
+  cloud->header.frame_id = ortho_frame_;
+
+  unsigned int dropped = LaserOrthoProjector::projectScan(
+    *scan_msg, ortho_to_laser, *input.geometry, *cloud, min_height_, max_height_);
+
+  input.beams_count += scan_msg->ranges.size();
+  input.height_dropped_count += dropped;
+
+  if (publish_cloud_) input.cloud_publisher.publish(cloud);
+
+  // **** hand it over to be merged
+
+  if (publish_merged_)
+  {
+    boost::mutex::scoped_lock lock(merge_mutex_);
+
+    input.cloud = cloud;
+    input.stamp = scan_msg->header.stamp;
+
+    if (synchronized()) mergeClouds();
+  }
+}
+
+// True once every input has a cloud, all within slop of each other. A
+// cloud that is too old stays until its laser sends a newer one.
+bool MultiLaserOrthoProjector::synchronized() const
+{
+  ros::Time earliest, latest;
+
+  for (unsigned int i = 0; i < inputs_.size(); i++)
+  {
+    if (!inputs_[i].cloud) return false;
+
+    const ros::Time& stamp = inputs_[i].stamp;
+    if (i == 0 || stamp < earliest) earliest = stamp;
+    if (i == 0 || stamp > latest)   latest   = stamp;
+  }
+
+  return (latest - earliest).toSec() <= slop_;
+}
+
+void MultiLaserOrthoProjector::mergeClouds()
+{
+  PointCloudT::Ptr merged =
+    boost::shared_ptr<PointCloudT>(new PointCloudT());
+
+  size_t size = 0;
+  for (unsigned int i = 0; i < inputs_.size(); i++)
+    size += inputs_[i].cloud->points.size();
+  merged->points.reserve(size);
+
+  // the earliest stamp, like the merged scans of the laser_scan_merger
+  unsigned int earliest = 0;
+  for (unsigned int i = 0; i < inputs_.size(); i++)
+  {
+    const PointCloudT& cloud = *inputs_[i].cloud;
+    merged->points.insert(merged->points.end(), cloud.points.begin(), cloud.points.end());
+
+    if (inputs_[i].stamp < inputs_[earliest].stamp) earliest = i;
+  }
+
+  merged->header = inputs_[earliest].cloud->header;
+  merged->width = merged->points.size();
+  merged->height = 1;
+  merged->is_dense = true;
+
+  for (unsigned int i = 0; i < inputs_.size(); i++)
+    inputs_[i].cloud.reset();
+
+  merged_publisher_.publish(merged);
+}
+
+bool MultiLaserOrthoProjector::getBaseToLaserTf (Input& input,
+                                                 const sensor_msgs::LaserScan::ConstPtr& scan_msg)
+{
+  tf::StampedTransform base_to_laser_tf;
+  try
+  {
+    tf_listener_.waitForTransform(
+      base_frame_, scan_msg->header.frame_id, scan_msg->header.stamp, ros::Duration(1.0));
+    tf_listener_.lookupTransform (
+      base_frame_, scan_msg->header.frame_id, scan_msg->header.stamp, base_to_laser_tf);
+  }
+  catch (tf::TransformException ex)
+  {
+    ROS_WARN("MultiLaserOrthoProjector: Could not get initial transform of %s (%s)",
+      input.topic.c_str(), ex.what());
+    return false;
+  }
+  input.base_to_laser = base_to_laser_tf;
+
+  return true;
+}
+
+void MultiLaserOrthoProjector::tokenize(const std::string& str, std::vector<std::string>& tokens)
+{
+  std::string::size_type last_pos = str.find_first_not_of(" ", 0);
+  std::string::size_type pos = str.find_first_of(" ", last_pos);
+
+  while (std::string::npos != pos || std::string::npos != last_pos)
+  {
+    tokens.push_back(str.substr(last_pos, pos - last_pos));
+    last_pos = str.find_first_not_of(" ", pos);
+    pos = str.find_first_of(" ", last_pos);
+  }
+}
+
+} //namespace scan_tools
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LASER_SCAN_MATCHER_COMPACT_SCAN_H
+#define LASER_SCAN_MATCHER_COMPACT_SCAN_H
+
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <scan_tools_common/scan_geometry.h>
+
+#include <csm/csm_all.h>  // csm defines min and max, but Eigen complains
+#undef min
+#undef max
+
+namespace scan_tools
+{
+
+/**
+ * Compact storage for a single scan.
+ *
+ * Only the ranges are stored, as floats; a negative range marks an
+ * invalid beam. Intensities and weights are optional and stored only
+ * when set. Bearings are implicit for regularly spaced scans.
+ * Everything else (bearings, cartesian points and the CSM laser data)
+ * is materialized on first use and dropped when the ranges change.
+ *
+ * A CSM LDP allocates about twenty per-beam arrays, mostly doubles
+ * (~160 bytes per beam), whereas a stored CompactScan costs 4 bytes
+ * per beam, so the LDP should only be materialized right before it
+ * is handed to CSM, and released afterwards.
+ */
+class CompactScan : private boost::noncopyable
+{
+  public:
+
+    CompactScan();
+    ~CompactScan();
+
+    /**
+     * Resize for regularly spaced beams. Bearings are implicit.
+     */
+    void setRegular(unsigned int n, float angle_min, float angle_increment);
+
+    /**
+     * Resize for beams with arbitrary bearings, which have to be
+     * filled in through mutableBearings().
+     */
+    void setIrregular(unsigned int n);
+
+    unsigned int size() const { return ranges_.size(); }
+    bool regular() const { return regular_; }
+    float angleMin() const { return angle_min_; }
+    float angleIncrement() const { return angle_increment_; }
+
+    const float* ranges() const { return ranges_.data(); }
+
+    // Write access to the ranges; drops all derived fields
+    float* mutableRanges();
+
+    // Write access to the bearings of an irregular scan; drops all derived fields
+    float* mutableBearings();
+
+    // Optional per-beam intensities and correspondence weights; null if not set
+    const float* intensities() const { return intensities_.empty() ? 0 : intensities_.data(); }
+    const float* weights() const { return weights_.empty() ? 0 : weights_.data(); }
+
+    // Write access to the intensities, allocated on first use
+    float* mutableIntensities();
+
+    /**
+     * Write access to the correspondence weights, allocated on first use.
+     * Weights are relative, in (0, 1]; the LDP gets readings_sigma set
+     * to 1/sqrt(weight), for CSM's use_sigma_weights.
+     */
+    float* mutableWeights();
+
+    // Bearings of all beams, materialized on first use
+    const float* theta() const;
+
+    // Cartesian points of all beams in the laser frame, materialized on first use
+    const float* x() const;
+    const float* y() const;
+
+    /**
+     * The scan as CSM laser data, materialized on first use and owned
+     * by the CompactScan. Stays valid until the ranges change or
+     * releaseLDP() is called.
+     */
+    LDP ldp();
+
+    void releaseLDP();
+
+    void swap(CompactScan& other);
+
+    // Current memory footprint in bytes, excluding a materialized LDP
+    size_t memoryUsage() const;
+
+  private:
+
+    void invalidate();
+    void computeCartesian() const;
+
+    bool  regular_;
+    float angle_min_;
+    float angle_increment_;
+
+    std::vector<float> ranges_;
+    std::vector<float> intensities_;  // empty unless set
+    std::vector<float> weights_;      // empty unless set
+
+    // **** derived fields
+
+    mutable std::vector<float> theta_; // always valid for irregular scans
+    mutable bool theta_valid_;
+
+    mutable std::vector<float> x_;
+    mutable std::vector<float> y_;
+    mutable bool xy_valid_;
+
+    mutable ScanGeometryPtr geometry_; // sin and cos of regular scans, shared
+
+    LDP ldp_;
+};
+
+} // namespace scan_tools
+
+#endif // LASER_SCAN_MATCHER_COMPACT_SCAN_H
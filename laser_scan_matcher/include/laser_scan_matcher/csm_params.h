@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LASER_SCAN_MATCHER_CSM_PARAMS_H
+#define LASER_SCAN_MATCHER_CSM_PARAMS_H
+
+#include <csm/csm_all.h>  // csm defines min and max, but Eigen complains
+#undef min
+#undef max
+
+namespace scan_tools
+{
+
+/**
+ * Reads the CSM parameters, falling back to the defaults of the scan
+ * matcher. Comments copied from algos.h (by Andrea Censi).
+ *
+ * ParamSource is anything with getParam(const std::string&, T&) for
+ * double and int, returning false if the parameter is not set, such as
+ * ros::NodeHandle.
+ */
+template <typename ParamSource>
+void loadCSMParams(const ParamSource& params, sm_params& input)
+{
+  // Maximum angular displacement between scans
+  if (!params.getParam ("max_angular_correction_deg", input.max_angular_correction_deg))
+    input.max_angular_correction_deg = 45.0;
+
+  // Maximum translation between scans (m)
+  if (!params.getParam ("max_linear_correction", input.max_linear_correction))
+    input.max_linear_correction = 0.50;
+
+  // Maximum ICP cycle iterations
+  if (!params.getParam ("max_iterations", input.max_iterations))
+    input.max_iterations = 10;
+
+  // A threshold for stopping (m)
+  if (!params.getParam ("epsilon_xy", input.epsilon_xy))
+    input.epsilon_xy = 0.000001;
+
+  // A threshold for stopping (rad)
+  if (!params.getParam ("epsilon_theta", input.epsilon_theta))
+    input.epsilon_theta = 0.000001;
+
+  // Maximum distance for a correspondence to be valid
+  if (!params.getParam ("max_correspondence_dist", input.max_correspondence_dist))
+    input.max_correspondence_dist = 0.3;
+
+  // Noise in the scan (m)
+  if (!params.getParam ("sigma", input.sigma))
+    input.sigma = 0.010;
+
+  // Use smart tricks for finding correspondences.
+  if (!params.getParam ("use_corr_tricks", input.use_corr_tricks))
+    input.use_corr_tricks = 1;
+
+  // Restart: Restart if error is over threshold
+  if (!params.getParam ("restart", input.restart))
+    input.restart = 0;
+
+  // Restart: Threshold for restarting
+  if (!params.getParam ("restart_threshold_mean_error", input.restart_threshold_mean_error))
+    input.restart_threshold_mean_error = 0.01;
+
+  // Restart: displacement for restarting. (m)
+  if (!params.getParam ("restart_dt", input.restart_dt))
+    input.restart_dt = 1.0;
+
+  // Restart: displacement for restarting. (rad)
+  if (!params.getParam ("restart_dtheta", input.restart_dtheta))
+    input.restart_dtheta = 0.1;
+
+  // Max distance for staying in the same clustering
+  if (!params.getParam ("clustering_threshold", input.clustering_threshold))
+    input.clustering_threshold = 0.25;
+
+  // Number of neighbour rays used to estimate the orientation
+  if (!params.getParam ("orientation_neighbourhood", input.orientation_neighbourhood))
+    input.orientation_neighbourhood = 20;
+
+  // If 0, it's vanilla ICP
+  if (!params.getParam ("use_point_to_line_distance", input.use_point_to_line_distance))
+    input.use_point_to_line_distance = 1;
+
+  // Discard correspondences based on the angles
+  if (!params.getParam ("do_alpha_test", input.do_alpha_test))
+    input.do_alpha_test = 0;
+
+  // Discard correspondences based on the angles - threshold angle, in degrees
+  if (!params.getParam ("do_alpha_test_thresholdDeg", input.do_alpha_test_thresholdDeg))
+    input.do_alpha_test_thresholdDeg = 20.0;
+
+  // Percentage of correspondences to consider: if 0.9,
+  // always discard the top 10% of correspondences with more error
+  if (!params.getParam ("outliers_maxPerc", input.outliers_maxPerc))
+    input.outliers_maxPerc = 0.90;
+
+  // Parameters describing a simple adaptive algorithm for discarding.
+  //  1) Order the errors.
+  //  2) Choose the percentile according to outliers_adaptive_order.
+  //     (if it is 0.7, get the 70% percentile)
+  //  3) Define an adaptive threshold multiplying outliers_adaptive_mult
+  //     with the value of the error at the chosen percentile.
+  //  4) Discard correspondences over the threshold.
+  //  This is useful to be conservative; yet remove the biggest errors.
+  if (!params.getParam ("outliers_adaptive_order", input.outliers_adaptive_order))
+    input.outliers_adaptive_order = 0.7;
+
+  if (!params.getParam ("outliers_adaptive_mult", input.outliers_adaptive_mult))
+    input.outliers_adaptive_mult = 2.0;
+
+  // If you already have a guess of the solution, you can compute the polar angle
+  // of the points of one scan in the new position. If the polar angle is not a monotone
+  // function of the readings index, it means that the surface is not visible in the
+  // next position. If it is not visible, then we don't use it for matching.
+  if (!params.getParam ("do_visibility_test", input.do_visibility_test))
+    input.do_visibility_test = 0;
+
+  // no two points in laser_sens can have the same corr.
+  if (!params.getParam ("outliers_remove_doubles", input.outliers_remove_doubles))
+    input.outliers_remove_doubles = 1;
+
+  // If 1, computes the covariance of ICP using the method http://purl.org/censi/2006/icpcov
+  if (!params.getParam ("do_compute_covariance", input.do_compute_covariance))
+    input.do_compute_covariance = 0;
+
+  // Checks that find_correspondences_tricks gives the right answer
+  if (!params.getParam ("debug_verify_tricks", input.debug_verify_tricks))
+    input.debug_verify_tricks = 0;
+
+  // If 1, the field 'true_alpha' (or 'alpha') in the first scan is used to compute the
+  // incidence beta, and the factor (1/cos^2(beta)) used to weight the correspondence.");
+  if (!params.getParam ("use_ml_weights", input.use_ml_weights))
+    input.use_ml_weights = 0;
+
+  // If 1, the field 'readings_sigma' in the second scan is used to weight the
+  // correspondence by 1/sigma^2
+  if (!params.getParam ("use_sigma_weights", input.use_sigma_weights))
+    input.use_sigma_weights = 0;
+}
+
+} // namespace scan_tools
+
+#endif // LASER_SCAN_MATCHER_CSM_PARAMS_H
@@ -41,6 +41,8 @@
 #include <ros/ros.h>
 #include <sensor_msgs/Imu.h>
 #include <sensor_msgs/LaserScan.h>
+#include <sensor_msgs/MultiEchoLaserScan.h>
+#include <sensor_msgs/PointCloud2.h>
 #include <geometry_msgs/PoseStamped.h>
 #include <geometry_msgs/Pose2D.h>
 #include <geometry_msgs/PoseWithCovarianceStamped.h>
@@ -50,11 +52,25 @@
 #include <tf/transform_datatypes.h>
 #include <tf/transform_listener.h>
 #include <tf/transform_broadcaster.h>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <deque>
 #include <pcl/point_types.h>
 #include <pcl/point_cloud.h>
-#include <pcl/filters/voxel_grid.h>
 #include <pcl_ros/point_cloud.h>
 
+#include <laser_scan_matcher/compact_scan.h>
+#include <laser_scan_matcher/csm_params.h>
+#include <laser_scan_matcher/reflector_landmarks.h>
+#include <laser_scan_matcher/scan_conversion.h>
+#include <scan_tools_common/realtime.h>
+#include <scan_tools_common/reuse_message.h>
+#include <scan_tools_common/scan_binning.h>
+#include <scan_tools_common/scan_geometry.h>
+#include <scan_tools_common/shadow_filter.h>
+#include <scan_tools_common/shm_scan_ring.h>
+#include <scan_tools_common/temporal_filter.h>
+
 #include <csm/csm_all.h>  // csm defines min and max, but Eigen complains
 #undef min
 #undef max
@@ -66,13 +82,40 @@ class LaserScanMatcher
 {
   public:
 
-    LaserScanMatcher(ros::NodeHandle nh, ros::NodeHandle nh_private);
+    /**
+     * @param subscribe_scans  If false, the matcher does not subscribe to
+     *                         scans or clouds, and is fed by calling
+     *                         scanCallback(), cloudCallback() or
+     *                         pclCloudCallback() directly,
+     *                         e.g. from an in-process pipeline.
+     */
+    LaserScanMatcher(ros::NodeHandle nh, ros::NodeHandle nh_private,
+                     bool subscribe_scans = true);
     ~LaserScanMatcher();
 
+    bool useCloudInput() const { return use_cloud_input_; }
+
+    typedef CloudSlicer::PointCloudT PointCloudT;
+
+    void scanCallback (const sensor_msgs::LaserScan::ConstPtr& scan_msg);
+    void cloudCallback (const sensor_msgs::PointCloud2::ConstPtr& cloud);
+
+    // in-process clouds are sliced directly, without a PointCloud2 round trip
+    void pclCloudCallback (const PointCloudT::ConstPtr& cloud);
+
   private:
 
-    typedef pcl::PointXYZ           PointT;
-    typedef pcl::PointCloud<PointT> PointCloudT;
+    // Result of a scan match, handed over to the (possibly asynchronous)
+    // publishing of the covariance and pose messages
+    struct PoseOutput
+    {
+      ros::Time time;
+      tf::Transform transform;
+      tf::Transform keyframe_base_in_fixed;
+      bool icp_covariance;
+      double xy_cov[4];
+      double yaw_cov;
+    };
 
     // **** ros
 
@@ -95,23 +138,40 @@ class LaserScanMatcher
     ros::Publisher  pose_stamped_publisher_;
     ros::Publisher  pose_with_covariance_publisher_;
     ros::Publisher  pose_with_covariance_stamped_publisher_;
+    ros::Publisher  dynamic_scan_publisher_;
 
     // **** parameters
 
     std::string base_frame_;
     std::string fixed_frame_;
-    double cloud_range_min_;
-    double cloud_range_max_;
-    double cloud_res_;
+    std::string laser_frame_;
+    CloudSliceParams cloud_params_;
     bool publish_tf_;
     bool publish_pose_;
     bool publish_pose_with_covariance_;
     bool publish_pose_stamped_;
     bool publish_pose_with_covariance_stamped_;
+    bool publish_async_;
+    RealtimeParams realtime_params_;
     std::vector<double> position_covariance_;
     std::vector<double> orientation_covariance_;
 
     bool use_cloud_input_;
+    bool use_multi_echo_input_;
+    bool use_shm_input_;
+
+    bool use_intensity_weights_;
+    double intensity_weight_ref_;
+    double min_point_weight_;
+    double incidence_max_neighbor_dist_;
+    double multi_echo_max_spread_;
+    double multi_echo_weight_;
+
+    bool filter_shadows_;
+    bool filter_temporal_;
+
+    bool mask_dynamic_;
+    double dynamic_min_gap_;
 
     double kf_dist_linear_;
     double kf_dist_linear_sq_;
@@ -152,34 +212,117 @@ class LaserScanMatcher
 
     geometry_msgs::Twist latest_vel_msg_;
 
-    std::vector<double> a_cos_;
-    std::vector<double> a_sin_;
+    ScanGeometryPtr geometry_;  // sin and cos of the beam angles, shared
+
+    CloudSlicer cloud_slicer_;
+    ShmScanReader shm_reader_;
+    std::vector<unsigned char> multi_echo_spread_;
+    ShadowFilter shadow_filter_;
+    TemporalFilter temporal_filter_;
+    ScanBinningBuffers dynamic_buffers_;  // the scan projected into the keyframe
+    std::vector<int32_t> dynamic_flags_;
+
+    long icp_iterations_sum_;    // convergence statistics
+    int icp_count_;
 
     bool add_imu_roll_pitch_;
 
+    // **** reflector landmarks
+
+    bool use_reflectors_;
+    bool reflector_first_guess_;
+    bool reflector_map_update_;
+    int reflector_min_matches_;
+    double reflector_association_dist_;
+    double reflector_max_disagreement_;
+    std::string reflector_map_file_;
+    ReflectorParams reflector_params_;
+
+    ReflectorMap reflector_map_;
+    std::vector<Reflector> curr_reflectors_;
+    std::vector<unsigned char> reflector_mask_;
+
     sm_params input_;
     sm_result output_;
-    LDP prev_ldp_scan_;
+
+    CompactScan keyframe_scan_; // the keyframe keeps its LDP materialized
+    CompactScan curr_scan_;     // reused for every incoming scan
+
+    // scans are processed here if realtime_params_ are enabled, otherwise
+    // by the spinner threads
+    boost::shared_ptr<CallbackThread> processing_thread_;
+
+    // **** output publishing
+
+    boost::thread publisher_thread_;
+    boost::mutex publisher_mutex_;
+    boost::condition_variable publisher_condition_;
+    std::deque<PoseOutput> publisher_queue_;
+    bool publisher_shutdown_;
+
+    // output messages, reused once no subscriber holds on to them
+    geometry_msgs::Pose2D::Ptr pose_msg_;
+    geometry_msgs::PoseStamped::Ptr pose_stamped_msg_;
+    geometry_msgs::PoseWithCovariance::Ptr pose_with_covariance_msg_;
+    geometry_msgs::PoseWithCovarianceStamped::Ptr pose_with_covariance_stamped_msg_;
+    sensor_msgs::LaserScan::Ptr dynamic_scan_msg_;
+
+    JitterStats latency_stats_;     // scan stamp to tf, ms
+    JitterStats processing_stats_;  // processScan, ms
+    JitterStats dynamic_stats_;     // beams masked as dynamic, %
 
     // **** methods
 
     void initParams();
-    void processScan(LDP& curr_ldp_scan, const ros::Time& time);
+    void processScan(CompactScan& curr_scan, const ros::Time& time);
 
-    void laserScanToLDP(const sensor_msgs::LaserScan::ConstPtr& scan_msg,
-                              LDP& ldp);
-    void PointCloudToLDP(const PointCloudT::ConstPtr& cloud,
-                               LDP& ldp);
+    // The LDP itself is only materialized at the CSM boundary, see CompactScan
+    void laserScanToLDP(const LaserScanView& scan_view, CompactScan& scan);
+    // False if the cloud cannot be sliced into a scan
+    bool PointCloudToLDP(const sensor_msgs::PointCloud2::ConstPtr& cloud,
+                               CompactScan& scan);
+    bool PointCloudToLDP(const PointCloudT& cloud, CompactScan& scan);
 
-    void scanCallback (const sensor_msgs::LaserScan::ConstPtr& scan_msg);
-    void cloudCallback (const PointCloudT::ConstPtr& cloud);
+    void multiEchoScanToLDP(const sensor_msgs::MultiEchoLaserScan::ConstPtr& scan_msg,
+                                  CompactScan& scan);
+
+    // Invalidates the veiling points of scan
+    void filterShadows(CompactScan& scan);
+
+    // Invalidates the returns of scan that disagree with the last scans
+    void filterTemporal(CompactScan& scan);
+
+    // Invalidates the beams of scan that end in front of the keyframe,
+    // given the predicted pose of scan in the keyframe; they stay invalid
+    // if scan becomes the next keyframe
+    void maskDynamic(CompactScan& scan,
+                     const tf::Transform& keyframe_laser_offset,
+                     const ros::Time& time);
+
+    // Publishes the beams flagged by the last maskDynamic() on dynamic_scan
+    void publishDynamic(const CompactScan& scan, const ros::Time& time);
+
+    // Correspondence weights from the intensities and incidence angles
+    void computePointWeights(CompactScan& scan);
+
+    void multiEchoScanCallback (const sensor_msgs::MultiEchoLaserScan::ConstPtr& scan_msg);
+    void shmScanCallback (const scan_tools_common::ShmScanRef::ConstPtr& ref);
 
     void odomCallback(const nav_msgs::Odometry::ConstPtr& odom_msg);
     void imuCallback (const sensor_msgs::Imu::ConstPtr& imu_msg);
     void velCallback (const geometry_msgs::Twist::ConstPtr& twist_msg);
     void velStmpCallback(const geometry_msgs::TwistStamped::ConstPtr& twist_msg);
 
-    void createCache (const sensor_msgs::LaserScan::ConstPtr& scan_msg);
+    void createCache (float angle_min, float angle_increment, unsigned int size,
+                      float range_min, float range_max);
+
+    /**
+     * Converts a scan into curr_scan_, and into the keyframe if it is the
+     * first one; also extracts its reflectors.
+     *
+     * @returns False if the scan has to be skipped.
+     */
+    bool prepareScan(const LaserScanView& scan_view);
 
     /**
      * Cache the static transform between the base and laser.
@@ -192,6 +335,26 @@ class LaserScanMatcher
 
     bool newKeyframeNeeded(const tf::Transform& d);
 
+    void publishPoseOutput(const PoseOutput& pose_output);
+    void publisherThread();
+
+    static void fillCovariance(const Eigen::Matrix2f& xy_cov, double yaw_cov,
+                               boost::array<double, 36>& covariance);
+
+    /**
+     * Estimate the pose of the laser in the fixed frame from the
+     * reflectors of the current scan.
+     *
+     * @param[in]  pred_base_in_fixed  The predicted pose of the base.
+     * @param[out] laser_in_fixed      The estimated pose of the laser.
+     *
+     * @returns True if enough reflectors were associated, false otherwise.
+     */
+    bool getReflectorPose(const tf::Transform& pred_base_in_fixed,
+                          tf::Transform& laser_in_fixed);
+
+    void updateReflectorMap();
+
     tf::Transform getPrediction(const ros::Time& stamp);
 
     void createTfFromXYTheta(double x, double y, double theta, tf::Transform& t);
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LASER_SCAN_MATCHER_REFLECTOR_LANDMARKS_H
+#define LASER_SCAN_MATCHER_REFLECTOR_LANDMARKS_H
+
+#include <string>
+#include <vector>
+
+namespace scan_tools
+{
+
+// A retroreflector observed in a single scan, in the laser frame
+struct Reflector
+{
+  double x;
+  double y;
+  int    beams;   // number of beams in the high-intensity cluster
+};
+
+// A persistent reflector landmark, in the fixed frame
+struct ReflectorLandmark
+{
+  double x;
+  double y;
+  int    observations;
+};
+
+struct ReflectorParams
+{
+  double intensity_threshold; // min intensity of a reflector beam
+  int    min_beams;           // min beams in a cluster
+  double max_width;           // max extent of a cluster (m)
+  double max_gap;             // max range jump inside a cluster (m)
+};
+
+/**
+ * Finds clusters of consecutive high-intensity beams and returns
+ * their centroids in the laser frame.
+ *
+ * The beam classification is done in a single branch-free pass over
+ * the ranges and intensities; clusters are then collected from the
+ * resulting mask. If the beams cover the full circle, a cluster may run
+ * from the last beam into the first.
+ */
+void extractReflectors(const float* ranges,
+                       const float* intensities,
+                       const double* a_cos,
+                       const double* a_sin,
+                       unsigned int n,
+                       double range_min,
+                       double range_max,
+                       bool full_circle,
+                       const ReflectorParams& params,
+                       std::vector<unsigned char>& mask,
+                       std::vector<Reflector>& reflectors);
+
+/**
+ * Landmarks of retroreflectors in the fixed frame.
+ *
+ * A reflector without a landmark first becomes a candidate. Candidates
+ * are refined like landmarks, but only used for matching once observed
+ * min_observations times. At most max_candidates are kept; when a new
+ * one does not fit, the candidate seen least recently is dropped, so
+ * spurious reflections do not pile up.
+ */
+class ReflectorMap
+{
+  public:
+
+    ReflectorMap(int min_observations = 5, unsigned int max_candidates = 100);
+
+    void setMinObservations(int min_observations) { min_observations_ = min_observations; }
+    void setMaxCandidates(unsigned int max_candidates);
+
+    /**
+     * Loads landmarks from a text file with one "x y observations"
+     * triple per line. Lines starting with '#' are ignored.
+     *
+     * @returns True if the file could be read, false otherwise.
+     */
+    bool load(const std::string& filename);
+
+    bool save(const std::string& filename) const;
+
+    const std::vector<ReflectorLandmark>& landmarks() const { return landmarks_; }
+
+    unsigned int candidateCount() const { return candidates_.size(); }
+
+    /**
+     * Associates each reflector with its nearest landmark, using the
+     * laser pose (x, y, theta) in the fixed frame as the guess. Each
+     * landmark goes to the closest reflector; the others fall back to
+     * their next nearest landmark.
+     *
+     * @param[out] matches Landmark index for each reflector, or -1.
+     *
+     * @returns The number of associated reflectors.
+     */
+    int associate(const std::vector<Reflector>& reflectors,
+                  double x, double y, double theta,
+                  double max_dist,
+                  std::vector<int>& matches) const;
+
+    /**
+     * Refines matched landmarks, given the laser pose in the fixed frame.
+     * Unmatched reflectors refine the nearest candidate within max_dist,
+     * or become new candidates.
+     */
+    void update(const std::vector<Reflector>& reflectors,
+                const std::vector<int>& matches,
+                double x, double y, double theta,
+                double max_dist);
+
+  private:
+
+    struct Candidate
+    {
+      ReflectorLandmark landmark;
+      unsigned long last_seen;  // update() count
+    };
+
+    int min_observations_;
+    unsigned int max_candidates_;
+
+    std::vector<ReflectorLandmark> landmarks_;
+    std::vector<Candidate> candidates_;
+    unsigned long updates_;
+};
+
+/**
+ * Computes the laser pose in the fixed frame from associated
+ * reflectors, using the closed-form least squares solution for a 2D
+ * rigid transform.
+ *
+ * @returns False if fewer than min_matches reflectors are associated.
+ */
+bool estimateReflectorPose(const std::vector<Reflector>& reflectors,
+                           const ReflectorMap& map,
+                           const std::vector<int>& matches,
+                           int min_matches,
+                           double& x, double& y, double& theta);
+
+} // namespace scan_tools
+
+#endif // LASER_SCAN_MATCHER_REFLECTOR_LANDMARKS_H
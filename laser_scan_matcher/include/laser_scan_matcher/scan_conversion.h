@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LASER_SCAN_MATCHER_SCAN_CONVERSION_H
+#define LASER_SCAN_MATCHER_SCAN_CONVERSION_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sensor_msgs/LaserScan.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+
+#include <laser_scan_matcher/compact_scan.h>
+#include <scan_tools_common/laser_scan_view.h>
+
+namespace scan_tools
+{
+
+/**
+ * Fill a regular CompactScan with the ranges of a LaserScan, or of a view
+ * of one. Ranges outside of (range_min, range_max) are marked invalid.
+ */
+void laserScanToCompactScan(const sensor_msgs::LaserScan& scan_msg, CompactScan& scan);
+void laserScanToCompactScan(const LaserScanView& scan_view, CompactScan& scan);
+
+struct CloudSliceParams
+{
+  CloudSliceParams();
+
+  double range_min;       // points outside of the range band are invalid
+  double range_max;
+  double res;             // min. spacing of consecutive points, if not binned
+  int ring;               // ring to keep, < 0 to keep all
+  std::string ring_field; // name of the ring field
+  double z_min;           // height band to keep, in the cloud frame
+  double z_max;
+  double angle_increment; // if > 0, bin by bearing with this resolution
+};
+
+/**
+ * Turns a PointCloud2 into a 2D scan, reading only the fields it needs
+ * through their offsets.
+ *
+ * Optionally only a single ring and/or a height band of a 3D cloud is
+ * kept. The points are then either binned by bearing into a regular
+ * scan (closest point per bin), or used in cloud order, spaced by at
+ * least params.res.
+ */
+class CloudSlicer
+{
+  public:
+
+    typedef pcl::PointCloud<pcl::PointXYZ> PointCloudT;
+
+    /**
+     * @returns False if the cloud lacks a required field, has one of
+     *          an unsupported type or beyond point_step, is big endian,
+     *          or holds less data than its size and steps claim; the
+     *          scan is left empty.
+     */
+    bool slice(const sensor_msgs::PointCloud2& cloud,
+               const CloudSliceParams& params,
+               CompactScan& scan);
+
+    /**
+     * Same for an in-process pcl cloud, without serializing it first.
+     *
+     * @returns False if a ring is requested, pcl::PointXYZ has none;
+     *          the scan is left empty.
+     */
+    bool slice(const PointCloudT& cloud,
+               const CloudSliceParams& params,
+               CompactScan& scan);
+
+  private:
+
+    // Location of a field within the points of a PointCloud2
+    struct Field
+    {
+      int offset;       // -1 if the field does not exist
+      uint8_t datatype; // sensor_msgs::PointField type
+    };
+
+    // Point accessors for sliceImpl()
+    struct CloudMsgPoints;
+    struct PclPoints;
+
+    static Field findField(const sensor_msgs::PointCloud2& cloud, const std::string& name);
+    static double readField(const uint8_t* point, const Field& field);
+
+    // Bytes of a sensor_msgs::PointField type, 0 if unsupported
+    static unsigned int fieldSize(uint8_t datatype);
+
+    // Whether field exists, has a supported type and lies within a point
+    static bool fieldFits(const Field& field, unsigned int point_step);
+
+    template <class Points>
+    void sliceImpl(const Points& points, const CloudSliceParams& params, CompactScan& scan);
+
+    std::vector<float> x_; // points kept for the current scan, reused
+    std::vector<float> y_;
+};
+
+} // namespace scan_tools
+
+#endif // LASER_SCAN_MATCHER_SCAN_CONVERSION_H
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <laser_scan_matcher/compact_scan.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace scan_tools
+{
+
+CompactScan::CompactScan():
+  regular_(true),
+  angle_min_(0.0),
+  angle_increment_(0.0),
+  theta_valid_(false),
+  xy_valid_(false),
+  ldp_(0)
+{
+
+}
+
+CompactScan::~CompactScan()
+{
+  releaseLDP();
+}
+
+void CompactScan::setRegular(unsigned int n, float angle_min, float angle_increment)
+{
+  regular_ = true;
+  angle_min_ = angle_min;
+  angle_increment_ = angle_increment;
+  ranges_.resize(n);
+  intensities_.clear();
+  weights_.clear();
+  invalidate();
+}
+
+void CompactScan::setIrregular(unsigned int n)
+{
+  regular_ = false;
+  angle_min_ = 0.0;
+  angle_increment_ = 0.0;
+  ranges_.resize(n);
+  theta_.resize(n);
+  intensities_.clear();
+  weights_.clear();
+  invalidate();
+}
+
+float* CompactScan::mutableRanges()
+{
+  invalidate();
+  return ranges_.data();
+}
+
+float* CompactScan::mutableBearings()
+{
+  invalidate();
+  return theta_.data();
+}
+
+float* CompactScan::mutableIntensities()
+{
+  intensities_.resize(ranges_.size());
+  return intensities_.data();
+}
+
+float* CompactScan::mutableWeights()
+{
+  releaseLDP();
+  weights_.resize(ranges_.size());
+  return weights_.data();
+}
+
+void CompactScan::invalidate()
+{
+  theta_valid_ = !regular_;
+  xy_valid_ = false;
+  releaseLDP();
+}
+
+const float* CompactScan::theta() const
+{
+  if (!theta_valid_)
+  {
+    unsigned int n = ranges_.size();
+    theta_.resize(n);
+    for (unsigned int i = 0; i < n; ++i)
+      theta_[i] = angle_min_ + i * angle_increment_;
+    theta_valid_ = true;
+  }
+  return theta_.data();
+}
+
+void CompactScan::computeCartesian() const
+{
+  unsigned int n = ranges_.size();
+
+  x_.resize(n);
+  y_.resize(n);
+
+  if (regular_)
+  {
+    ScanGeometryCache::update(geometry_, angle_min_, angle_increment_, n);
+    const float* c = geometry_->cosFloat();
+    const float* s = geometry_->sinFloat();
+
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      x_[i] = ranges_[i] * c[i];
+      y_[i] = ranges_[i] * s[i];
+    }
+  }
+  else
+  {
+    const float* t = theta();
+
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      x_[i] = ranges_[i] * cosf(t[i]);
+      y_[i] = ranges_[i] * sinf(t[i]);
+    }
+  }
+
+  xy_valid_ = true;
+}
+
+const float* CompactScan::x() const
+{
+  if (!xy_valid_) computeCartesian();
+  return x_.data();
+}
+
+const float* CompactScan::y() const
+{
+  if (!xy_valid_) computeCartesian();
+  return y_.data();
+}
+
+LDP CompactScan::ldp()
+{
+  if (ldp_) return ldp_;
+
+  unsigned int n = ranges_.size();
+  const float* t = theta();
+
+  ldp_ = ld_alloc_new(n);
+
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    if (ranges_[i] >= 0.0)
+    {
+      ldp_->valid[i] = 1;
+      ldp_->readings[i] = ranges_[i];
+    }
+    else
+    {
+      ldp_->valid[i] = 0;
+      ldp_->readings[i] = -1;  // for invalid range
+    }
+
+    ldp_->theta[i]   = t[i];
+    ldp_->cluster[i] = -1;
+  }
+
+  if (!weights_.empty())
+  {
+    for (unsigned int i = 0; i < n; ++i)
+      ldp_->readings_sigma[i] = 1.0 / sqrt(std::max(weights_[i], 1e-6f));
+  }
+
+  if (n > 0)
+  {
+    ldp_->min_theta = ldp_->theta[0];
+    ldp_->max_theta = ldp_->theta[n-1];
+  }
+
+  ldp_->odometry[0] = 0.0;
+  ldp_->odometry[1] = 0.0;
+  ldp_->odometry[2] = 0.0;
+
+  ldp_->true_pose[0] = 0.0;
+  ldp_->true_pose[1] = 0.0;
+  ldp_->true_pose[2] = 0.0;
+
+  return ldp_;
+}
+
+void CompactScan::releaseLDP()
+{
+  if (ldp_)
+  {
+    ld_free(ldp_);
+    ldp_ = 0;
+  }
+}
+
+void CompactScan::swap(CompactScan& other)
+{
+  std::swap(regular_, other.regular_);
+  std::swap(angle_min_, other.angle_min_);
+  std::swap(angle_increment_, other.angle_increment_);
+  ranges_.swap(other.ranges_);
+  intensities_.swap(other.intensities_);
+  weights_.swap(other.weights_);
+  theta_.swap(other.theta_);
+  std::swap(theta_valid_, other.theta_valid_);
+  x_.swap(other.x_);
+  y_.swap(other.y_);
+  std::swap(xy_valid_, other.xy_valid_);
+  geometry_.swap(other.geometry_);
+  std::swap(ldp_, other.ldp_);
+}
+
+size_t CompactScan::memoryUsage() const
+{
+  size_t bytes = sizeof(*this);
+  bytes += ranges_.capacity() * sizeof(float);
+  bytes += intensities_.capacity() * sizeof(float);
+  bytes += weights_.capacity() * sizeof(float);
+  bytes += theta_.capacity() * sizeof(float);
+  bytes += x_.capacity() * sizeof(float);
+  bytes += y_.capacity() * sizeof(float);
+  return bytes;
+}
+
+} // namespace scan_tools
@@ -37,22 +37,29 @@
 
 #include <laser_scan_matcher/laser_scan_matcher.h>
 #include <pcl_conversions/pcl_conversions.h>
-#include <boost/assign.hpp>
+#include <scan_tools_common/trace.h>
 #include <tf/transform_datatypes.h>
+#include <limits>
 
 namespace scan_tools
 {
 
-LaserScanMatcher::LaserScanMatcher(ros::NodeHandle nh, ros::NodeHandle nh_private):
+LaserScanMatcher::LaserScanMatcher(ros::NodeHandle nh, ros::NodeHandle nh_private,
+                                   bool subscribe_scans):
   nh_(nh),
   nh_private_(nh_private),
   initialized_(false),
   received_imu_(false),
   received_odom_(false),
-  received_vel_(false)
+  received_vel_(false),
+  icp_iterations_sum_(0),
+  icp_count_(0),
+  publisher_shutdown_(false)
 {
   ROS_INFO("Starting LaserScanMatcher");
 
+  Tracer::instance().advertise(nh_);
+
   // **** init parameters
 
   initParams();
@@ -97,16 +104,50 @@ LaserScanMatcher::LaserScanMatcher(ros::NodeHandle nh, ros::NodeHandle nh_privat
       "pose_with_covariance_stamped", 5);
   }
 
+  if (mask_dynamic_)
+  {
+    dynamic_scan_publisher_ = nh_.advertise<sensor_msgs::LaserScan>(
+      "dynamic_scan", 5);
+  }
+
+  if (publish_async_)
+  {
+    publisher_thread_ = boost::thread(
+      boost::bind(&LaserScanMatcher::publisherThread, this));
+  }
+
   // *** subscribers
 
-  if (use_cloud_input_)
+  // scans go to their own thread if it needs a different scheduling
+  ros::NodeHandle nh_scans(nh_);
+  if (subscribe_scans && realtime_params_.enabled())
   {
-    cloud_subscriber_ = nh_.subscribe(
+    processing_thread_.reset(new CallbackThread(realtime_params_, "scan_matcher"));
+    nh_scans.setCallbackQueue(processing_thread_->queue());
+  }
+
+  if (!subscribe_scans)
+  {
+    ROS_INFO("Not subscribing to scans, expecting them in-process");
+  }
+  else if (use_cloud_input_)
+  {
+    cloud_subscriber_ = nh_scans.subscribe(
       "cloud", 1, &LaserScanMatcher::cloudCallback, this);
   }
+  else if (use_multi_echo_input_)
+  {
+    scan_subscriber_ = nh_scans.subscribe(
+      "multi_echo_scan", 1, &LaserScanMatcher::multiEchoScanCallback, this);
+  }
+  else if (use_shm_input_)
+  {
+    scan_subscriber_ = nh_scans.subscribe(
+      "scan_shm", 1, &LaserScanMatcher::shmScanCallback, this);
+  }
   else
   {
-    scan_subscriber_ = nh_.subscribe(
+    scan_subscriber_ = nh_scans.subscribe(
       "scan", 1, &LaserScanMatcher::scanCallback, this);
   }
 
@@ -129,11 +170,61 @@ LaserScanMatcher::LaserScanMatcher(ros::NodeHandle nh, ros::NodeHandle nh_privat
       vel_subscriber_ = nh_.subscribe(
         "vel", 1, &LaserScanMatcher::velCallback, this);
   }
+
+  // **** reflector landmark map from a previous run
+
+  if (use_reflectors_ && !reflector_map_file_.empty())
+  {
+    if (reflector_map_.load(reflector_map_file_))
+      ROS_INFO("Loaded %d reflector landmarks from %s",
+        (int)reflector_map_.landmarks().size(), reflector_map_file_.c_str());
+    else
+      ROS_WARN("Could not load reflector map %s, starting with an empty map",
+        reflector_map_file_.c_str());
+  }
 }
 
 LaserScanMatcher::~LaserScanMatcher()
 {
   ROS_INFO("Destroying LaserScanMatcher");
+
+  scan_subscriber_.shutdown();
+  cloud_subscriber_.shutdown();
+  processing_thread_.reset();
+
+  if (publish_async_)
+  {
+    {
+      boost::mutex::scoped_lock lock(publisher_mutex_);
+      publisher_shutdown_ = true;
+    }
+    publisher_condition_.notify_one();
+    publisher_thread_.join();
+  }
+
+  if (latency_stats_.count() > 0)
+    ROS_INFO("Scan to tf latency: mean %.3f ms, std dev %.3f ms, max %.3f ms over %d scans",
+      latency_stats_.mean(), latency_stats_.stdDev(), latency_stats_.max(),
+      latency_stats_.count());
+
+  if (processing_stats_.count() > 0)
+    ROS_INFO("Scan processing time: mean %.3f ms, std dev %.3f ms, max %.3f ms",
+      processing_stats_.mean(), processing_stats_.stdDev(), processing_stats_.max());
+
+  if (icp_count_ > 0)
+    ROS_INFO("Average ICP iterations: %.2f over %d scans",
+      (double)icp_iterations_sum_ / icp_count_, icp_count_);
+
+  // compare the ICP iterations with and without masking
+  if (dynamic_stats_.count() > 0)
+    ROS_INFO("Dynamic masking: mean %.2f%%, std dev %.2f%%, max %.2f%% of the beams",
+      dynamic_stats_.mean(), dynamic_stats_.stdDev(), dynamic_stats_.max());
+
+  if (use_reflectors_ && reflector_map_update_ && !reflector_map_file_.empty())
+  {
+    if (!reflector_map_.save(reflector_map_file_))
+      ROS_WARN("Could not save reflector map %s", reflector_map_file_.c_str());
+  }
 }
 
 void LaserScanMatcher::initParams()
@@ -152,15 +243,33 @@ void LaserScanMatcher::initParams()
 
   if (use_cloud_input_)
   {
-    if (!nh_private_.getParam ("cloud_range_min", cloud_range_min_))
-      cloud_range_min_ = 0.1;
-    if (!nh_private_.getParam ("cloud_range_max", cloud_range_max_))
-      cloud_range_max_ = 50.0;
-    if (!nh_private_.getParam ("cloud_res", cloud_res_))
-      cloud_res_ = 0.05;
-
-    input_.min_reading = cloud_range_min_;
-    input_.max_reading = cloud_range_max_;
+    if (!nh_private_.getParam ("cloud_range_min", cloud_params_.range_min))
+      cloud_params_.range_min = 0.1;
+    if (!nh_private_.getParam ("cloud_range_max", cloud_params_.range_max))
+      cloud_params_.range_max = 50.0;
+    if (!nh_private_.getParam ("cloud_res", cloud_params_.res))
+      cloud_params_.res = 0.05;
+
+    // **** slicing of 3D clouds: only points of one ring and/or within a
+    // height band (in the cloud frame) are used. A negative ring disables
+    // the ring selection.
+    if (!nh_private_.getParam ("cloud_ring", cloud_params_.ring))
+      cloud_params_.ring = -1;
+    if (!nh_private_.getParam ("cloud_ring_field", cloud_params_.ring_field))
+      cloud_params_.ring_field = "ring";
+    if (!nh_private_.getParam ("cloud_z_min", cloud_params_.z_min))
+      cloud_params_.z_min = -std::numeric_limits<double>::max();
+    if (!nh_private_.getParam ("cloud_z_max", cloud_params_.z_max))
+      cloud_params_.z_max = std::numeric_limits<double>::max();
+
+    // if > 0, points are binned by bearing into a regular scan with this
+    // angular resolution, keeping the closest point per bin. Otherwise,
+    // points are used in cloud order, spaced by at least cloud_res.
+    if (!nh_private_.getParam ("cloud_angle_increment", cloud_params_.angle_increment))
+      cloud_params_.angle_increment = 0.0;
+
+    input_.min_reading = cloud_params_.range_min;
+    input_.max_reading = cloud_params_.range_max;
   }
 
   // **** keyframe params: when to generate the keyframe scan
@@ -211,6 +320,16 @@ void LaserScanMatcher::initParams()
   if (!nh_private_.getParam ("publish_pose_with_covariance_stamped", publish_pose_with_covariance_stamped_))
     publish_pose_with_covariance_stamped_ = false;
 
+  // If true, the pose2D message and tf are published straight from the ICP
+  // result, and the covariance and remaining pose messages are finalized on
+  // a separate publisher thread.
+  if (!nh_private_.getParam ("publish_async", publish_async_))
+    publish_async_ = false;
+
+  // Scheduling policy (other, fifo, rr), priority, cpus and memory locking
+  // of a dedicated scan processing thread, under ~realtime/
+  loadRealtimeParams(ros::NodeHandle(nh_private_, "realtime"), realtime_params_);
+
   if (!nh_private_.getParam("position_covariance", position_covariance_))
   {
     position_covariance_.resize(3);
@@ -222,131 +341,165 @@ void LaserScanMatcher::initParams()
     orientation_covariance_.resize(3);
     std::fill(orientation_covariance_.begin(), orientation_covariance_.end(), 1e-9);
   }
-  // **** CSM parameters - comments copied from algos.h (by Andrea Censi)
-
-  // Maximum angular displacement between scans
-  if (!nh_private_.getParam ("max_angular_correction_deg", input_.max_angular_correction_deg))
-    input_.max_angular_correction_deg = 45.0;
-
-  // Maximum translation between scans (m)
-  if (!nh_private_.getParam ("max_linear_correction", input_.max_linear_correction))
-    input_.max_linear_correction = 0.50;
-
-  // Maximum ICP cycle iterations
-  if (!nh_private_.getParam ("max_iterations", input_.max_iterations))
-    input_.max_iterations = 10;
-
-  // A threshold for stopping (m)
-  if (!nh_private_.getParam ("epsilon_xy", input_.epsilon_xy))
-    input_.epsilon_xy = 0.000001;
-
-  // A threshold for stopping (rad)
-  if (!nh_private_.getParam ("epsilon_theta", input_.epsilon_theta))
-    input_.epsilon_theta = 0.000001;
-
-  // Maximum distance for a correspondence to be valid
-  if (!nh_private_.getParam ("max_correspondence_dist", input_.max_correspondence_dist))
-    input_.max_correspondence_dist = 0.3;
-
-  // Noise in the scan (m)
-  if (!nh_private_.getParam ("sigma", input_.sigma))
-    input_.sigma = 0.010;
-
-  // Use smart tricks for finding correspondences.
-  if (!nh_private_.getParam ("use_corr_tricks", input_.use_corr_tricks))
-    input_.use_corr_tricks = 1;
-
-  // Restart: Restart if error is over threshold
-  if (!nh_private_.getParam ("restart", input_.restart))
-    input_.restart = 0;
-
-  // Restart: Threshold for restarting
-  if (!nh_private_.getParam ("restart_threshold_mean_error", input_.restart_threshold_mean_error))
-    input_.restart_threshold_mean_error = 0.01;
-
-  // Restart: displacement for restarting. (m)
-  if (!nh_private_.getParam ("restart_dt", input_.restart_dt))
-    input_.restart_dt = 1.0;
-
-  // Restart: displacement for restarting. (rad)
-  if (!nh_private_.getParam ("restart_dtheta", input_.restart_dtheta))
-    input_.restart_dtheta = 0.1;
-
-  // Max distance for staying in the same clustering
-  if (!nh_private_.getParam ("clustering_threshold", input_.clustering_threshold))
-    input_.clustering_threshold = 0.25;
-
-  // Number of neighbour rays used to estimate the orientation
-  if (!nh_private_.getParam ("orientation_neighbourhood", input_.orientation_neighbourhood))
-    input_.orientation_neighbourhood = 20;
-
-  // If 0, it's vanilla ICP
-  if (!nh_private_.getParam ("use_point_to_line_distance", input_.use_point_to_line_distance))
-    input_.use_point_to_line_distance = 1;
-
-  // Discard correspondences based on the angles
-  if (!nh_private_.getParam ("do_alpha_test", input_.do_alpha_test))
-    input_.do_alpha_test = 0;
-
-  // Discard correspondences based on the angles - threshold angle, in degrees
-  if (!nh_private_.getParam ("do_alpha_test_thresholdDeg", input_.do_alpha_test_thresholdDeg))
-    input_.do_alpha_test_thresholdDeg = 20.0;
-
-  // Percentage of correspondences to consider: if 0.9,
-  // always discard the top 10% of correspondences with more error
-  if (!nh_private_.getParam ("outliers_maxPerc", input_.outliers_maxPerc))
-    input_.outliers_maxPerc = 0.90;
-
-  // Parameters describing a simple adaptive algorithm for discarding.
-  //  1) Order the errors.
-  //  2) Choose the percentile according to outliers_adaptive_order.
-  //     (if it is 0.7, get the 70% percentile)
-  //  3) Define an adaptive threshold multiplying outliers_adaptive_mult
-  //     with the value of the error at the chosen percentile.
-  //  4) Discard correspondences over the threshold.
-  //  This is useful to be conservative; yet remove the biggest errors.
-  if (!nh_private_.getParam ("outliers_adaptive_order", input_.outliers_adaptive_order))
-    input_.outliers_adaptive_order = 0.7;
-
-  if (!nh_private_.getParam ("outliers_adaptive_mult", input_.outliers_adaptive_mult))
-    input_.outliers_adaptive_mult = 2.0;
-
-  // If you already have a guess of the solution, you can compute the polar angle
-  // of the points of one scan in the new position. If the polar angle is not a monotone
-  // function of the readings index, it means that the surface is not visible in the
-  // next position. If it is not visible, then we don't use it for matching.
-  if (!nh_private_.getParam ("do_visibility_test", input_.do_visibility_test))
-    input_.do_visibility_test = 0;
-
-  // no two points in laser_sens can have the same corr.
-  if (!nh_private_.getParam ("outliers_remove_doubles", input_.outliers_remove_doubles))
-    input_.outliers_remove_doubles = 1;
-
-  // If 1, computes the covariance of ICP using the method http://purl.org/censi/2006/icpcov
-  if (!nh_private_.getParam ("do_compute_covariance", input_.do_compute_covariance))
-    input_.do_compute_covariance = 0;
-
-  // Checks that find_correspondences_tricks gives the right answer
-  if (!nh_private_.getParam ("debug_verify_tricks", input_.debug_verify_tricks))
-    input_.debug_verify_tricks = 0;
-
-  // If 1, the field 'true_alpha' (or 'alpha') in the first scan is used to compute the
-  // incidence beta, and the factor (1/cos^2(beta)) used to weight the correspondence.");
-  if (!nh_private_.getParam ("use_ml_weights", input_.use_ml_weights))
-    input_.use_ml_weights = 0;
-
-  // If 1, the field 'readings_sigma' in the second scan is used to weight the
-  // correspondence by 1/sigma^2
-  if (!nh_private_.getParam ("use_sigma_weights", input_.use_sigma_weights))
-    input_.use_sigma_weights = 0;
+  // **** CSM parameters, see csm_params.h
+
+  loadCSMParams(nh_private_, input_);
+
+  // **** per-point weights from intensity and incidence angle
+  // If true, the correspondences are weighted by the intensity of the
+  // return and the incidence angle of the beam on the surface. This
+  // replaces the readings_sigma input, and enables use_sigma_weights.
+
+  if (!nh_private_.getParam ("use_intensity_weights", use_intensity_weights_))
+    use_intensity_weights_ = false;
+  // Intensity at which a return gets full weight. If <= 0, the largest
+  // intensity of each scan is used.
+  if (!nh_private_.getParam ("intensity_weight_ref", intensity_weight_ref_))
+    intensity_weight_ref_ = 0.0;
+  // Lower bound of the weight of any valid point
+  if (!nh_private_.getParam ("min_point_weight", min_point_weight_))
+    min_point_weight_ = 0.1;
+  // Neighbours further apart than this do not define a surface for the
+  // incidence angle
+  if (!nh_private_.getParam ("incidence_max_neighbor_dist", incidence_max_neighbor_dist_))
+    incidence_max_neighbor_dist_ = 0.2;
+
+  // **** multi-echo input
+  // If true, subscribes to MultiEchoLaserScan msgs on /multi_echo_scan.
+  // The strongest echo of each beam is used; beams whose echoes differ by
+  // more than multi_echo_max_spread are weighted down by multi_echo_weight.
+
+  if (!nh_private_.getParam ("use_multi_echo_input", use_multi_echo_input_))
+    use_multi_echo_input_ = false;
+  if (!nh_private_.getParam ("multi_echo_max_spread", multi_echo_max_spread_))
+    multi_echo_max_spread_ = 0.1;
+  if (!nh_private_.getParam ("multi_echo_weight", multi_echo_weight_))
+    multi_echo_weight_ = 0.5;
+
+  if (use_intensity_weights_ || use_multi_echo_input_)
+    input_.use_sigma_weights = 1;
+
+  if (use_multi_echo_input_ && use_cloud_input_)
+    ROS_WARN("use_cloud_input and use_multi_echo_input are both set, using the cloud input");
+
+  // **** shadow filtering
+  // If true, the veiling points between edges and the background behind
+  // them are invalidated before matching: the farther of two returns up to
+  // shadow_window beams apart, if the laser sees the line through them
+  // under less than shadow_min_angle [rad]. Not applied to cloud input.
+
+  double shadow_min_angle;
+  int shadow_window;
+
+  if (!nh_private_.getParam ("filter_shadows", filter_shadows_))
+    filter_shadows_ = false;
+  if (!nh_private_.getParam ("shadow_min_angle", shadow_min_angle))
+    shadow_min_angle = 10.0 * M_PI / 180.0;
+  if (!nh_private_.getParam ("shadow_window", shadow_window))
+    shadow_window = 2;
+
+  shadow_filter_.setMinAngle(shadow_min_angle);
+  shadow_filter_.setWindow(shadow_window);
+
+  // **** temporal filtering
+  // If true, returns more than temporal_tolerance [m] from the median of
+  // the same beam over the last temporal_history scans are invalidated
+  // before matching and reflector extraction, e.g. dust or rain. Only
+  // while the laser stands still: if more than
+  // temporal_max_outlier_fraction of the beams disagree, the history
+  // starts over instead. Cloud input has to be binned into a regular scan
+  // (cloud_angle_increment > 0) to be filtered.
+
+  int temporal_history;
+  double temporal_tolerance;
+  double temporal_max_outlier_fraction;
+
+  if (!nh_private_.getParam ("filter_temporal", filter_temporal_))
+    filter_temporal_ = false;
+  if (!nh_private_.getParam ("temporal_history", temporal_history))
+    temporal_history = 5;
+  if (!nh_private_.getParam ("temporal_tolerance", temporal_tolerance))
+    temporal_tolerance = 0.1;
+  if (!nh_private_.getParam ("temporal_max_outlier_fraction", temporal_max_outlier_fraction))
+    temporal_max_outlier_fraction = 0.2;
+
+  temporal_filter_.setHistory(temporal_history);
+  temporal_filter_.setTolerance(temporal_tolerance);
+  temporal_filter_.setMaxOutlierFraction(temporal_max_outlier_fraction);
+
+  // **** dynamic object masking
+  // If true, the scan is projected into the keyframe with the predicted
+  // pose before matching, and beams ending more than dynamic_min_gap [m]
+  // in front of the keyframe (new obstacles, e.g. people) are excluded
+  // from ICP, also once the scan becomes the keyframe, so that later scans
+  // are masked against the static scene. They are published on
+  // dynamic_scan. Only for LaserScan input.
+
+  if (!nh_private_.getParam ("mask_dynamic", mask_dynamic_))
+    mask_dynamic_ = false;
+  if (!nh_private_.getParam ("dynamic_min_gap", dynamic_min_gap_))
+    dynamic_min_gap_ = 0.5;
+
+  // **** shared memory input
+  // If true, subscribes to ShmScanRef msgs on /scan_shm, and reads the scans
+  // they refer to in place, from the shared memory ring of the writer (see
+  // the laser_scan_shm_writer package).
+
+  if (!nh_private_.getParam ("use_shm_input", use_shm_input_))
+    use_shm_input_ = false;
+
+  if (use_shm_input_ && (use_cloud_input_ || use_multi_echo_input_))
+    ROS_WARN("use_shm_input is ignored, the cloud or multi-echo input is used");
 
   if (!nh_private_.getParam ("add_imu_roll_pitch", add_imu_roll_pitch_))
     add_imu_roll_pitch_ = false;
+
+  // **** Reflector landmarks - clusters of high intensity beams (scan input only)
+  // If use_reflectors is true, reflectors are associated with a landmark map
+  // in the fixed frame. With at least reflector_min_matches associations
+  // the resulting pose is either used as the first guess for the ICP
+  // (reflector_first_guess), or only compared against the ICP result.
+
+  if (!nh_private_.getParam ("use_reflectors", use_reflectors_))
+    use_reflectors_ = false;
+  if (!nh_private_.getParam ("reflector_first_guess", reflector_first_guess_))
+    reflector_first_guess_ = true;
+  if (!nh_private_.getParam ("reflector_map_update", reflector_map_update_))
+    reflector_map_update_ = true;
+  if (!nh_private_.getParam ("reflector_map_file", reflector_map_file_))
+    reflector_map_file_ = "";
+  if (!nh_private_.getParam ("reflector_min_matches", reflector_min_matches_))
+    reflector_min_matches_ = 3;
+  if (!nh_private_.getParam ("reflector_association_dist", reflector_association_dist_))
+    reflector_association_dist_ = 0.5;
+  if (!nh_private_.getParam ("reflector_max_disagreement", reflector_max_disagreement_))
+    reflector_max_disagreement_ = 0.2;
+  // new reflectors become landmarks only after reflector_min_observations
+  // consistent observations; until then at most reflector_max_candidates
+  // are tracked, dropping the one seen least recently
+  int reflector_min_observations, reflector_max_candidates;
+  if (!nh_private_.getParam ("reflector_min_observations", reflector_min_observations))
+    reflector_min_observations = 5;
+  if (!nh_private_.getParam ("reflector_max_candidates", reflector_max_candidates))
+    reflector_max_candidates = 100;
+  reflector_map_.setMinObservations(std::max(1, reflector_min_observations));
+  reflector_map_.setMaxCandidates(std::max(0, reflector_max_candidates));
+  if (!nh_private_.getParam ("reflector_intensity_threshold", reflector_params_.intensity_threshold))
+    reflector_params_.intensity_threshold = 1000.0;
+  if (!nh_private_.getParam ("reflector_min_beams", reflector_params_.min_beams))
+    reflector_params_.min_beams = 2;
+  if (!nh_private_.getParam ("reflector_max_width", reflector_params_.max_width))
+    reflector_params_.max_width = 0.2;
+  if (!nh_private_.getParam ("reflector_max_gap", reflector_params_.max_gap))
+    reflector_params_.max_gap = 0.1;
+
+  if (use_reflectors_ && (use_cloud_input_ || use_multi_echo_input_))
+    ROS_WARN("use_reflectors requires LaserScan input, reflectors will not be used");
 }
 
 void LaserScanMatcher::imuCallback(const sensor_msgs::Imu::ConstPtr& imu_msg)
 {
-  boost::mutex::scoped_lock(mutex_);
+  boost::mutex::scoped_lock lock(mutex_);
   latest_imu_msg_ = *imu_msg;
   if (!received_imu_)
   {
@@ -357,7 +510,7 @@ void LaserScanMatcher::imuCallback(const sensor_msgs::Imu::ConstPtr& imu_msg)
 
 void LaserScanMatcher::odomCallback(const nav_msgs::Odometry::ConstPtr& odom_msg)
 {
-  boost::mutex::scoped_lock(mutex_);
+  boost::mutex::scoped_lock lock(mutex_);
   latest_odom_msg_ = *odom_msg;
   if (!received_odom_)
   {
@@ -368,7 +521,7 @@ void LaserScanMatcher::odomCallback(const nav_msgs::Odometry::ConstPtr& odom_msg
 
 void LaserScanMatcher::velCallback(const geometry_msgs::Twist::ConstPtr& twist_msg)
 {
-  boost::mutex::scoped_lock(mutex_);
+  boost::mutex::scoped_lock lock(mutex_);
   latest_vel_msg_ = *twist_msg;
 
   received_vel_ = true;
@@ -376,87 +529,187 @@ void LaserScanMatcher::velCallback(const geometry_msgs::Twist::ConstPtr& twist_m
 
 void LaserScanMatcher::velStmpCallback(const geometry_msgs::TwistStamped::ConstPtr& twist_msg)
 {
-  boost::mutex::scoped_lock(mutex_);
+  boost::mutex::scoped_lock lock(mutex_);
   latest_vel_msg_ = twist_msg->twist;
 
   received_vel_ = true;
 }
 
-void LaserScanMatcher::cloudCallback (const PointCloudT::ConstPtr& cloud)
+void LaserScanMatcher::cloudCallback (const sensor_msgs::PointCloud2::ConstPtr& cloud)
 {
+  SCAN_TOOLS_TRACE("LaserScanMatcher::cloudCallback", cloud->header.stamp, cloud->header.frame_id);
+
   // **** if first scan, cache the tf from base to the scanner
 
-  std_msgs::Header cloud_header = pcl_conversions::fromPCL(cloud->header);
+  if (!initialized_)
+  {
+    // cache the static tf from base to laser
+    if (!getBaseLaserTransform(cloud->header.frame_id))
+    {
+      ROS_WARN("Skipping scan");
+      return;
+    }
+
+    // an unusable cloud must not become the keyframe
+    if (!PointCloudToLDP(cloud, keyframe_scan_)) return;
+    last_icp_time_ = cloud->header.stamp;
+    initialized_ = true;
+  }
+
+  if (!PointCloudToLDP(cloud, curr_scan_)) return;
+  if (filter_temporal_) filterTemporal(curr_scan_);
+  processScan(curr_scan_, cloud->header.stamp);
+}
+
+void LaserScanMatcher::pclCloudCallback (const PointCloudT::ConstPtr& cloud)
+{
+  std_msgs::Header header = pcl_conversions::fromPCL(cloud->header);
+
+  SCAN_TOOLS_TRACE("LaserScanMatcher::pclCloudCallback", header.stamp, header.frame_id);
+
+  // **** if first scan, cache the tf from base to the scanner
 
   if (!initialized_)
   {
     // cache the static tf from base to laser
-    if (!getBaseLaserTransform(cloud_header.frame_id))
+    if (!getBaseLaserTransform(header.frame_id))
     {
       ROS_WARN("Skipping scan");
       return;
     }
 
-    PointCloudToLDP(cloud, prev_ldp_scan_);
-    last_icp_time_ = cloud_header.stamp;
+    // an unusable cloud must not become the keyframe
+    if (!PointCloudToLDP(*cloud, keyframe_scan_)) return;
+    last_icp_time_ = header.stamp;
     initialized_ = true;
   }
 
-  LDP curr_ldp_scan;
-  PointCloudToLDP(cloud, curr_ldp_scan);
-  processScan(curr_ldp_scan, cloud_header.stamp);
+  if (!PointCloudToLDP(*cloud, curr_scan_)) return;
+  if (filter_temporal_) filterTemporal(curr_scan_);
+  processScan(curr_scan_, header.stamp);
 }
 
 void LaserScanMatcher::scanCallback (const sensor_msgs::LaserScan::ConstPtr& scan_msg)
 {
+  SCAN_TOOLS_TRACE("LaserScanMatcher::scanCallback", scan_msg->header.stamp, scan_msg->header.frame_id);
+
+  if (prepareScan(LaserScanView(*scan_msg)))
+    processScan(curr_scan_, scan_msg->header.stamp);
+}
+
+void LaserScanMatcher::shmScanCallback (const scan_tools_common::ShmScanRef::ConstPtr& ref)
+{
+  SCAN_TOOLS_TRACE("LaserScanMatcher::shmScanCallback", ref->header.stamp, ref->header.frame_id);
+
+  LaserScanView scan_view;
+  if (!shm_reader_.read(*ref, scan_view))
+  {
+    ROS_WARN_THROTTLE(1.0, "Skipping scan, it is not in shared memory segment %s (anymore)",
+      ref->segment.c_str());
+    return;
+  }
+
+  bool was_initialized = initialized_;
+  if (!prepareScan(scan_view)) return;
+
+  // the writer may have reused the slot while it was read
+  if (!shm_reader_.valid(*ref))
+  {
+    ROS_WARN_THROTTLE(1.0, "Skipping scan, it was overwritten in shared memory while being read");
+    initialized_ = was_initialized;
+    if (filter_temporal_) temporal_filter_.rollback();
+    return;
+  }
+
+  processScan(curr_scan_, ref->header.stamp);
+}
+
+bool LaserScanMatcher::prepareScan(const LaserScanView& scan_view)
+{
+  // sin and cos of all angles, O(1) if unchanged
+  createCache(scan_view.angle_min, scan_view.angle_increment, scan_view.size,
+              scan_view.range_min, scan_view.range_max);
+
   // **** if first scan, cache the tf from base to the scanner
 
   if (!initialized_)
   {
-    createCache(scan_msg);    // caches the sin and cos of all angles
-
     // cache the static transform between the base and laser
-    if (!getBaseLaserTransform(scan_msg->header.frame_id))
+    if (!getBaseLaserTransform(scan_view.header->frame_id))
     {
       ROS_WARN("Skipping scan");
-      return;
+      return false;
     }
 
-    laserScanToLDP(scan_msg, prev_ldp_scan_);
-    last_icp_time_ = scan_msg->header.stamp;
+    laserScanToLDP(scan_view, keyframe_scan_);
+    last_icp_time_ = scan_view.header->stamp;
     initialized_ = true;
   }
 
-  LDP curr_ldp_scan;
-  laserScanToLDP(scan_msg, curr_ldp_scan);
-  processScan(curr_ldp_scan, scan_msg->header.stamp);
+  laserScanToLDP(scan_view, curr_scan_);
+
+  // once per scan, unlike the conversions, and before anything reads the
+  // ranges of the current scan
+  if (filter_temporal_) filterTemporal(curr_scan_);
+
+  // **** extract reflectors before matching, from the filtered ranges
+
+  if (use_reflectors_)
+  {
+    curr_reflectors_.clear();
+
+    if (scan_view.intensities)
+    {
+      // clusters continue across the seam of a scan around the full circle
+      double inc = std::fabs(scan_view.angle_increment);
+      bool full_circle = scan_view.size * inc >= 2.0 * M_PI - 0.5 * inc;
+
+      extractReflectors(curr_scan_.ranges(), scan_view.intensities,
+                        geometry_->cos(), geometry_->sin(), scan_view.size,
+                        scan_view.range_min, scan_view.range_max, full_circle,
+                        reflector_params_, reflector_mask_, curr_reflectors_);
+    }
+  }
+
+  return true;
 }
 
-void LaserScanMatcher::processScan(LDP& curr_ldp_scan, const ros::Time& time)
+void LaserScanMatcher::multiEchoScanCallback(
+  const sensor_msgs::MultiEchoLaserScan::ConstPtr& scan_msg)
 {
-  ros::WallTime start = ros::WallTime::now();
+  SCAN_TOOLS_TRACE("LaserScanMatcher::multiEchoScanCallback",
+                   scan_msg->header.stamp, scan_msg->header.frame_id);
 
-  // CSM is used in the following way:
-  // The scans are always in the laser frame
-  // The reference scan (prevLDPcan_) has a pose of [0, 0, 0]
-  // The new scan (currLDPScan) has a pose equal to the movement
-  // of the laser in the laser frame since the last scan
-  // The computed correction is then propagated using the tf machinery
+  // sin and cos of all angles, O(1) if unchanged
+  createCache(scan_msg->angle_min, scan_msg->angle_increment, scan_msg->ranges.size(),
+              scan_msg->range_min, scan_msg->range_max);
 
-  prev_ldp_scan_->odometry[0] = 0.0;
-  prev_ldp_scan_->odometry[1] = 0.0;
-  prev_ldp_scan_->odometry[2] = 0.0;
+  // **** if first scan, cache the tf from base to the scanner
 
-  prev_ldp_scan_->estimate[0] = 0.0;
-  prev_ldp_scan_->estimate[1] = 0.0;
-  prev_ldp_scan_->estimate[2] = 0.0;
+  if (!initialized_)
+  {
+    // cache the static transform between the base and laser
+    if (!getBaseLaserTransform(scan_msg->header.frame_id))
+    {
+      ROS_WARN("Skipping scan");
+      return;
+    }
+
+    multiEchoScanToLDP(scan_msg, keyframe_scan_);
+    last_icp_time_ = scan_msg->header.stamp;
+    initialized_ = true;
+  }
 
-  prev_ldp_scan_->true_pose[0] = 0.0;
-  prev_ldp_scan_->true_pose[1] = 0.0;
-  prev_ldp_scan_->true_pose[2] = 0.0;
+  multiEchoScanToLDP(scan_msg, curr_scan_);
+  if (filter_temporal_) filterTemporal(curr_scan_);
+  processScan(curr_scan_, scan_msg->header.stamp);
+}
 
-  input_.laser_ref  = prev_ldp_scan_;
-  input_.laser_sens = curr_ldp_scan;
+void LaserScanMatcher::processScan(CompactScan& curr_scan, const ros::Time& time)
+{
+  SCAN_TOOLS_TRACE("LaserScanMatcher::processScan", time, base_frame_);
+
+  ros::WallTime start = ros::WallTime::now();
 
   // **** estimated change since last scan
 
@@ -472,10 +725,52 @@ void LaserScanMatcher::processScan(LDP& curr_ldp_scan, const ros::Time& time)
   // convert the predicted offset from the keyframe base frame to be in the keyframe laser frame
   tf::Transform pred_keyframe_laser_offset = laser_from_base_ * pred_keyframe_base_offset * base_from_laser_ ;
 
+  // **** pose from reflector landmarks, if available
+
+  tf::Transform reflector_laser_in_fixed;
+  bool reflector_pose_valid = use_reflectors_ &&
+    getReflectorPose(pred_base_in_fixed, reflector_laser_in_fixed);
+
+  if (reflector_pose_valid && reflector_first_guess_)
+  {
+    tf::Transform keyframe_laser_in_fixed = keyframe_base_in_fixed_ * base_from_laser_;
+    pred_keyframe_laser_offset = keyframe_laser_in_fixed.inverse() * reflector_laser_in_fixed;
+  }
+
   input_.first_guess[0] = pred_keyframe_laser_offset.getOrigin().getX();
   input_.first_guess[1] = pred_keyframe_laser_offset.getOrigin().getY();
   input_.first_guess[2] = tf::getYaw(pred_keyframe_laser_offset.getRotation());
 
+  // **** exclude new obstacles from matching, before the LDP is built
+
+  if (mask_dynamic_)
+    maskDynamic(curr_scan, pred_keyframe_laser_offset, time);
+
+  LDP prev_ldp_scan = keyframe_scan_.ldp();
+  LDP curr_ldp_scan = curr_scan.ldp();
+
+  // CSM is used in the following way:
+  // The scans are always in the laser frame
+  // The reference scan (keyframe) has a pose of [0, 0, 0]
+  // The new scan (currLDPScan) has a pose equal to the movement
+  // of the laser in the laser frame since the last scan
+  // The computed correction is then propagated using the tf machinery
+
+  prev_ldp_scan->odometry[0] = 0.0;
+  prev_ldp_scan->odometry[1] = 0.0;
+  prev_ldp_scan->odometry[2] = 0.0;
+
+  prev_ldp_scan->estimate[0] = 0.0;
+  prev_ldp_scan->estimate[1] = 0.0;
+  prev_ldp_scan->estimate[2] = 0.0;
+
+  prev_ldp_scan->true_pose[0] = 0.0;
+  prev_ldp_scan->true_pose[1] = 0.0;
+  prev_ldp_scan->true_pose[2] = 0.0;
+
+  input_.laser_ref  = prev_ldp_scan;
+  input_.laser_sens = curr_ldp_scan;
+
   // If they are non-Null, free covariance gsl matrices to avoid leaking memory
   if (output_.cov_x_m)
   {
@@ -500,6 +795,10 @@ void LaserScanMatcher::processScan(LDP& curr_ldp_scan, const ros::Time& time)
 
   if (output_.valid)
   {
+    icp_iterations_sum_ += output_.iterations;
+    icp_count_++;
+    ROS_DEBUG("ICP converged in %d iterations (average %.2f)", output_.iterations,
+      (double)icp_iterations_sum_ / icp_count_);
 
     // the measured offset of the scan from the keyframe in the keyframe laser frame
     tf::Transform meas_keyframe_laser_offset;
@@ -513,6 +812,15 @@ void LaserScanMatcher::processScan(LDP& curr_ldp_scan, const ros::Time& time)
     
     tf::Transform current_transform = last_base_in_fixed_;
 
+    if (reflector_pose_valid)
+    {
+      // sanity check of the ICP result against the reflector pose
+      tf::Transform laser_in_fixed = last_base_in_fixed_ * base_from_laser_;
+      double d = laser_in_fixed.getOrigin().distance(reflector_laser_in_fixed.getOrigin());
+      if (d > reflector_max_disagreement_)
+        ROS_WARN_THROTTLE(1.0, "Scan matching and reflector poses differ by %.3f m", d);
+    }
+
     if (add_imu_roll_pitch_ && use_imu_ && received_imu_)
     {
       tf::Quaternion imu_orientation;
@@ -530,96 +838,72 @@ void LaserScanMatcher::processScan(LDP& curr_ldp_scan, const ros::Time& time)
 
       current_transform.setRotation(new_quat);
     }
-    // **** publish
 
-    Eigen::Matrix2f xy_cov = Eigen::Matrix2f::Zero();
-    float yaw_cov = 0.0;
-    if (input_.do_compute_covariance)
-    {
-      // get covariance from ICP
-      xy_cov(0, 0) = gsl_matrix_get(output_.cov_x_m, 0, 0);
-      xy_cov(0, 1) = gsl_matrix_get(output_.cov_x_m, 0, 1);
-      xy_cov(1, 0) = gsl_matrix_get(output_.cov_x_m, 1, 0);
-      xy_cov(1, 1) = gsl_matrix_get(output_.cov_x_m, 1, 1);
-      yaw_cov = gsl_matrix_get(output_.cov_x_m, 2, 2);
-
-      // rotate xy covariance from the keyframe into odom frame
-      auto rotation = getLaserRotation(keyframe_base_in_fixed_);
-      xy_cov = rotation * xy_cov * rotation.transpose();
-    }
-    else {
-      xy_cov(0, 0) = position_covariance_[0];
-      xy_cov(1, 1) = position_covariance_[1];
-      yaw_cov = orientation_covariance_[2];
-    }
+    // **** publish the pose and tf first, straight from the ICP result
 
     if (publish_pose_)
     {
       // unstamped Pose2D message
-      geometry_msgs::Pose2D::Ptr pose_msg;
-      pose_msg = boost::make_shared<geometry_msgs::Pose2D>();
+      geometry_msgs::Pose2D::Ptr pose_msg = reuseMessage(pose_msg_);
       pose_msg->x = current_transform.getOrigin().getX();
       pose_msg->y = current_transform.getOrigin().getY();
       pose_msg->theta = tf::getYaw(current_transform.getRotation());
       pose_publisher_.publish(pose_msg);
     }
-    if (publish_pose_stamped_)
-    {
-      // stamped Pose message
-      geometry_msgs::PoseStamped::Ptr pose_stamped_msg;
-      pose_stamped_msg = boost::make_shared<geometry_msgs::PoseStamped>();
-
-      pose_stamped_msg->header.stamp    = time;
-      pose_stamped_msg->header.frame_id = fixed_frame_;
 
-      tf::poseTFToMsg(current_transform, pose_stamped_msg->pose);
-
-      pose_stamped_publisher_.publish(pose_stamped_msg);
-    }
-    if (publish_pose_with_covariance_)
+    if (publish_tf_)
     {
-      // unstamped PoseWithCovariance message
-      geometry_msgs::PoseWithCovariance::Ptr pose_with_covariance_msg;
-      pose_with_covariance_msg = boost::make_shared<geometry_msgs::PoseWithCovariance>();
-      tf::poseTFToMsg(current_transform, pose_with_covariance_msg->pose);
-
-      pose_with_covariance_msg->covariance = boost::assign::list_of
-        (xy_cov(0, 0)) (xy_cov(0, 1)) (0) (0) (0) (0)
-        (xy_cov(1, 0)) (xy_cov(1, 1)) (0) (0) (0) (0)
-        (0) (0) (0) (0) (0) (0)
-        (0) (0) (0) (0) (0) (0)
-        (0) (0) (0) (0) (0) (0)
-        (0) (0) (0) (0) (0) (yaw_cov);
-
-      pose_with_covariance_publisher_.publish(pose_with_covariance_msg);
+      tf::StampedTransform transform_msg (current_transform, time, fixed_frame_, base_frame_);
+      tf_broadcaster_.sendTransform (transform_msg);
+
+      // latency from the scan stamp until the tf is sent
+      double latency = (ros::Time::now() - time).toSec() * 1e3;
+      latency_stats_.add(latency);
+      ROS_DEBUG("Scan to tf latency: %.3f ms (average %.3f ms)",
+        latency, latency_stats_.mean());
     }
-    if (publish_pose_with_covariance_stamped_)
-    {
-      // stamped Pose message
-      geometry_msgs::PoseWithCovarianceStamped::Ptr pose_with_covariance_stamped_msg;
-      pose_with_covariance_stamped_msg = boost::make_shared<geometry_msgs::PoseWithCovarianceStamped>();
 
-      pose_with_covariance_stamped_msg->header.stamp    = time;
-      pose_with_covariance_stamped_msg->header.frame_id = fixed_frame_;
+    // **** covariance and the remaining outputs
 
-      tf::poseTFToMsg(current_transform, pose_with_covariance_stamped_msg->pose.pose);
+    if (publish_pose_stamped_ ||
+        publish_pose_with_covariance_ ||
+        publish_pose_with_covariance_stamped_)
+    {
+      PoseOutput pose_output;
+      pose_output.time = time;
+      pose_output.transform = current_transform;
+      pose_output.keyframe_base_in_fixed = keyframe_base_in_fixed_;
+      pose_output.icp_covariance = input_.do_compute_covariance;
 
-      pose_with_covariance_stamped_msg->pose.covariance = boost::assign::list_of
-        (xy_cov(0, 0)) (xy_cov(0, 1)) (0) (0) (0) (0)
-        (xy_cov(1, 0)) (xy_cov(1, 1)) (0) (0) (0) (0)
-        (0) (0) (0) (0) (0) (0)
-        (0) (0) (0) (0) (0) (0)
-        (0) (0) (0) (0) (0) (0)
-        (0) (0) (0) (0) (0) (yaw_cov);
+      if (input_.do_compute_covariance)
+      {
+        // copy the covariance from ICP, the gsl matrix is freed with the next scan
+        pose_output.xy_cov[0] = gsl_matrix_get(output_.cov_x_m, 0, 0);
+        pose_output.xy_cov[1] = gsl_matrix_get(output_.cov_x_m, 0, 1);
+        pose_output.xy_cov[2] = gsl_matrix_get(output_.cov_x_m, 1, 0);
+        pose_output.xy_cov[3] = gsl_matrix_get(output_.cov_x_m, 1, 1);
+        pose_output.yaw_cov   = gsl_matrix_get(output_.cov_x_m, 2, 2);
+      }
 
-      pose_with_covariance_stamped_publisher_.publish(pose_with_covariance_stamped_msg);
+      if (publish_async_)
+      {
+        boost::mutex::scoped_lock lock(publisher_mutex_);
+        if (publisher_queue_.size() >= 10)
+        {
+          ROS_WARN_THROTTLE(1.0, "Publisher thread is falling behind, dropping pose");
+          publisher_queue_.pop_front();
+        }
+        publisher_queue_.push_back(pose_output);
+        publisher_condition_.notify_one();
+      }
+      else
+      {
+        publishPoseOutput(pose_output);
+      }
     }
 
-    if (publish_tf_)
-    {
-      tf::StampedTransform transform_msg (current_transform, time, fixed_frame_, base_frame_);
-      tf_broadcaster_.sendTransform (transform_msg);
-    }
+    if (use_reflectors_ && reflector_map_update_)
+      updateReflectorMap();
   }
   else
   {
@@ -631,24 +915,155 @@ void LaserScanMatcher::processScan(LDP& curr_ldp_scan, const ros::Time& time)
 
   if (newKeyframeNeeded(meas_keyframe_base_offset))
   {
-    // generate a keyframe
-    ld_free(prev_ldp_scan_);
-    prev_ldp_scan_ = curr_ldp_scan;
+    // generate a keyframe - the current scan keeps its LDP,
+    // the old keyframe becomes the buffer for the next scan
+    keyframe_scan_.swap(curr_scan);
     keyframe_base_in_fixed_ = last_base_in_fixed_;
   }
-  else
-  {
-    ld_free(curr_ldp_scan);
-  }
+
+  curr_scan.releaseLDP();
 
   last_icp_time_ = time;
 
   // **** statistics
 
   double dur = (ros::WallTime::now() - start).toSec() * 1e3;
+  processing_stats_.add(dur);
   ROS_DEBUG("Scan matcher total duration: %.1f ms", dur);
 }
 
+void LaserScanMatcher::publishPoseOutput(const PoseOutput& pose_output)
+{
+  Eigen::Matrix2f xy_cov = Eigen::Matrix2f::Zero();
+  float yaw_cov = 0.0;
+  if (pose_output.icp_covariance)
+  {
+    xy_cov(0, 0) = pose_output.xy_cov[0];
+    xy_cov(0, 1) = pose_output.xy_cov[1];
+    xy_cov(1, 0) = pose_output.xy_cov[2];
+    xy_cov(1, 1) = pose_output.xy_cov[3];
+    yaw_cov = pose_output.yaw_cov;
+
+    // rotate xy covariance from the keyframe into odom frame
+    auto rotation = getLaserRotation(pose_output.keyframe_base_in_fixed);
+    xy_cov = rotation * xy_cov * rotation.transpose();
+  }
+  else {
+    xy_cov(0, 0) = position_covariance_[0];
+    xy_cov(1, 1) = position_covariance_[1];
+    yaw_cov = orientation_covariance_[2];
+  }
+
+  if (publish_pose_stamped_)
+  {
+    // stamped Pose message
+    geometry_msgs::PoseStamped::Ptr pose_stamped_msg =
+      reuseMessage(pose_stamped_msg_);
+
+    pose_stamped_msg->header.stamp    = pose_output.time;
+    pose_stamped_msg->header.frame_id = fixed_frame_;
+
+    tf::poseTFToMsg(pose_output.transform, pose_stamped_msg->pose);
+
+    pose_stamped_publisher_.publish(pose_stamped_msg);
+  }
+  if (publish_pose_with_covariance_)
+  {
+    // unstamped PoseWithCovariance message
+    geometry_msgs::PoseWithCovariance::Ptr pose_with_covariance_msg =
+      reuseMessage(pose_with_covariance_msg_);
+
+    tf::poseTFToMsg(pose_output.transform, pose_with_covariance_msg->pose);
+    fillCovariance(xy_cov, yaw_cov, pose_with_covariance_msg->covariance);
+
+    pose_with_covariance_publisher_.publish(pose_with_covariance_msg);
+  }
+  if (publish_pose_with_covariance_stamped_)
+  {
+    // stamped Pose message
+    geometry_msgs::PoseWithCovarianceStamped::Ptr pose_with_covariance_stamped_msg =
+      reuseMessage(pose_with_covariance_stamped_msg_);
+
+    pose_with_covariance_stamped_msg->header.stamp    = pose_output.time;
+    pose_with_covariance_stamped_msg->header.frame_id = fixed_frame_;
+
+    tf::poseTFToMsg(pose_output.transform, pose_with_covariance_stamped_msg->pose.pose);
+    fillCovariance(xy_cov, yaw_cov, pose_with_covariance_stamped_msg->pose.covariance);
+
+    pose_with_covariance_stamped_publisher_.publish(pose_with_covariance_stamped_msg);
+  }
+}
+
+void LaserScanMatcher::publisherThread()
+{
+  while (true)
+  {
+    PoseOutput pose_output;
+    {
+      boost::mutex::scoped_lock lock(publisher_mutex_);
+      while (publisher_queue_.empty() && !publisher_shutdown_)
+        publisher_condition_.wait(lock);
+
+      if (publisher_shutdown_) return;
+
+      pose_output = publisher_queue_.front();
+      publisher_queue_.pop_front();
+    }
+
+    publishPoseOutput(pose_output);
+  }
+}
+
+void LaserScanMatcher::fillCovariance(const Eigen::Matrix2f& xy_cov, double yaw_cov,
+                                      boost::array<double, 36>& covariance)
+{
+  std::fill(covariance.begin(), covariance.end(), 0.0);
+  covariance[0]  = xy_cov(0, 0);
+  covariance[1]  = xy_cov(0, 1);
+  covariance[6]  = xy_cov(1, 0);
+  covariance[7]  = xy_cov(1, 1);
+  covariance[35] = yaw_cov;
+}
+
+bool LaserScanMatcher::getReflectorPose(const tf::Transform& pred_base_in_fixed,
+                                        tf::Transform& laser_in_fixed)
+{
+  if (curr_reflectors_.empty()) return false;
+
+  tf::Transform pred_laser_in_fixed = pred_base_in_fixed * base_from_laser_;
+
+  std::vector<int> matches;
+  reflector_map_.associate(curr_reflectors_,
+                           pred_laser_in_fixed.getOrigin().getX(),
+                           pred_laser_in_fixed.getOrigin().getY(),
+                           tf::getYaw(pred_laser_in_fixed.getRotation()),
+                           reflector_association_dist_, matches);
+
+  double x, y, theta;
+  if (!estimateReflectorPose(curr_reflectors_, reflector_map_, matches,
+                             reflector_min_matches_, x, y, theta))
+    return false;
+
+  createTfFromXYTheta(x, y, theta, laser_in_fixed);
+  return true;
+}
+
+void LaserScanMatcher::updateReflectorMap()
+{
+  if (curr_reflectors_.empty()) return;
+
+  tf::Transform laser_in_fixed = last_base_in_fixed_ * base_from_laser_;
+  double x = laser_in_fixed.getOrigin().getX();
+  double y = laser_in_fixed.getOrigin().getY();
+  double theta = tf::getYaw(laser_in_fixed.getRotation());
+
+  std::vector<int> matches;
+  reflector_map_.associate(curr_reflectors_, x, y, theta,
+                           reflector_association_dist_, matches);
+  reflector_map_.update(curr_reflectors_, matches, x, y, theta,
+                        reflector_association_dist_);
+}
+
 bool LaserScanMatcher::newKeyframeNeeded(const tf::Transform& d)
 {
   if (fabs(tf::getYaw(d.getRotation())) > kf_dist_angular_) return true;
@@ -660,131 +1075,282 @@ bool LaserScanMatcher::newKeyframeNeeded(const tf::Transform& d)
   return false;
 }
 
-void LaserScanMatcher::PointCloudToLDP(const PointCloudT::ConstPtr& cloud,
-                                             LDP& ldp)
+bool LaserScanMatcher::PointCloudToLDP(const sensor_msgs::PointCloud2::ConstPtr& cloud,
+                                             CompactScan& scan)
 {
-  double max_d2 = cloud_res_ * cloud_res_;
-
-  PointCloudT cloud_f;
-
-  cloud_f.points.push_back(cloud->points[0]);
+  if (!cloud_slicer_.slice(*cloud, cloud_params_, scan))
+  {
+    ROS_WARN_THROTTLE(1.0, "Laser Scan Matcher: Skipping cloud, its x, y, z or %s "
+      "fields are missing or malformed, it is big endian, or it is truncated",
+      cloud_params_.ring_field.c_str());
+    return false;
+  }
+  return true;
+}
 
-  for (unsigned int i = 1; i < cloud->points.size(); ++i)
+bool LaserScanMatcher::PointCloudToLDP(const PointCloudT& cloud, CompactScan& scan)
+{
+  if (!cloud_slicer_.slice(cloud, cloud_params_, scan))
   {
-    const PointT& pa = cloud_f.points[cloud_f.points.size() - 1];
-    const PointT& pb = cloud->points[i];
+    ROS_WARN_THROTTLE(1.0, "Laser Scan Matcher: Skipping cloud, ~cloud_ring is set, "
+      "but the in-process cloud input has no %s field", cloud_params_.ring_field.c_str());
+    return false;
+  }
+  return true;
+}
 
-    double dx = pa.x - pb.x;
-    double dy = pa.y - pb.y;
-    double d2 = dx*dx + dy*dy;
+void LaserScanMatcher::laserScanToLDP(const LaserScanView& scan_view, CompactScan& scan)
+{
+  laserScanToCompactScan(scan_view, scan);
+  unsigned int n = scan.size();
 
-    if (d2 > max_d2)
+  if (filter_shadows_) filterShadows(scan);
+
+  if (use_intensity_weights_)
+  {
+    if (scan_view.intensities)
     {
-      cloud_f.points.push_back(pb);
+      std::copy(scan_view.intensities, scan_view.intensities + n,
+                scan.mutableIntensities());
     }
+    else
+      ROS_WARN_THROTTLE(5.0, "use_intensity_weights is set, but the scan has no intensities");
+
+    computePointWeights(scan);
   }
+}
 
-  unsigned int n = cloud_f.points.size();
+void LaserScanMatcher::multiEchoScanToLDP(
+  const sensor_msgs::MultiEchoLaserScan::ConstPtr& scan_msg, CompactScan& scan)
+{
+  unsigned int n = scan_msg->ranges.size();
+  scan.setRegular(n, scan_msg->angle_min, scan_msg->angle_increment);
+
+  const float range_min = scan_msg->range_min;
+  const float range_max = scan_msg->range_max;
+  const bool has_intensities = scan_msg->intensities.size() == n;
 
-  ldp = ld_alloc_new(n);
+  float* ranges = scan.mutableRanges();
+  float* intensities = has_intensities ? scan.mutableIntensities() : 0;
+
+  // beams whose valid echoes disagree, e.g. at edges or through glass
+  multi_echo_spread_.assign(n, 0);
 
   for (unsigned int i = 0; i < n; i++)
   {
-    // calculate position in laser frame
-    if (is_nan(cloud_f.points[i].x) || is_nan(cloud_f.points[i].y))
-    {
-      ROS_WARN("Laser Scan Matcher: Cloud input contains NaN values. \
-                Please use a filtered cloud input.");
-    }
-    else
+    const std::vector<float>& echoes = scan_msg->ranges[i].echoes;
+    const std::vector<float>* echo_intensities =
+      has_intensities ? &scan_msg->intensities[i].echoes : 0;
+
+    float best_range = -1.0f;  // -1 for invalid range
+    float best_intensity = 0.0f;
+    float min_range =  std::numeric_limits<float>::max();
+    float max_range = -std::numeric_limits<float>::max();
+
+    for (unsigned int e = 0; e < echoes.size(); ++e)
     {
-      double r = sqrt(cloud_f.points[i].x * cloud_f.points[i].x +
-                      cloud_f.points[i].y * cloud_f.points[i].y);
+      float r = echoes[e];
+      if (!(r > range_min && r < range_max)) continue;
 
-      if (r > cloud_range_min_ && r < cloud_range_max_)
-      {
-        ldp->valid[i] = 1;
-        ldp->readings[i] = r;
-      }
-      else
+      min_range = std::min(min_range, r);
+      max_range = std::max(max_range, r);
+
+      // the strongest echo, or the first one without intensities
+      float intensity = 0.0f;
+      if (echo_intensities && e < echo_intensities->size())
+        intensity = (*echo_intensities)[e];
+
+      if (best_range < 0.0f || intensity > best_intensity)
       {
-        ldp->valid[i] = 0;
-        ldp->readings[i] = -1;  // for invalid range
+        best_range = r;
+        best_intensity = intensity;
       }
     }
 
-    ldp->theta[i] = atan2(cloud_f.points[i].y, cloud_f.points[i].x);
-    ldp->cluster[i]  = -1;
+    ranges[i] = best_range;
+    if (intensities) intensities[i] = best_intensity;
+    if (best_range >= 0.0f && max_range - min_range > multi_echo_max_spread_)
+      multi_echo_spread_[i] = 1;
   }
 
-  ldp->min_theta = ldp->theta[0];
-  ldp->max_theta = ldp->theta[n-1];
+  if (filter_shadows_) filterShadows(scan);
 
-  ldp->odometry[0] = 0.0;
-  ldp->odometry[1] = 0.0;
-  ldp->odometry[2] = 0.0;
+  computePointWeights(scan);
 
-  ldp->true_pose[0] = 0.0;
-  ldp->true_pose[1] = 0.0;
-  ldp->true_pose[2] = 0.0;
+  float* weights = scan.mutableWeights();
+  for (unsigned int i = 0; i < n; i++)
+    if (multi_echo_spread_[i])
+      weights[i] = std::max<float>(weights[i] * multi_echo_weight_, min_point_weight_);
 }
 
-void LaserScanMatcher::laserScanToLDP(const sensor_msgs::LaserScan::ConstPtr& scan_msg,
-                                            LDP& ldp)
+void LaserScanMatcher::filterShadows(CompactScan& scan)
 {
-  unsigned int n = scan_msg->ranges.size();
-  ldp = ld_alloc_new(n);
+  const unsigned int n = scan.size();
+
+  // invalid beams have negative ranges
+  if (shadow_filter_.detect(scan.ranges(), n, scan.angleIncrement(),
+                            0.0f, std::numeric_limits<float>::max()) == 0)
+    return;
 
+  float* ranges = scan.mutableRanges();
   for (unsigned int i = 0; i < n; i++)
+    if (shadow_filter_.veiling(i)) ranges[i] = -1.0f;
+}
+
+void LaserScanMatcher::filterTemporal(CompactScan& scan)
+{
+  // the same index is only the same beam in every scan of a regular input
+  if (!scan.regular())
   {
-    // calculate position in laser frame
+    ROS_WARN_ONCE("filter_temporal needs LaserScan input, or cloud_angle_increment > 0 "
+      "for cloud input; not filtering");
+    temporal_filter_.reset();
+    return;
+  }
 
-    double r = scan_msg->ranges[i];
+  const unsigned int n = scan.size();
 
-    if (r > scan_msg->range_min && r < scan_msg->range_max)
-    {
-      // fill in laser scan data
+  // invalid beams have negative ranges
+  if (temporal_filter_.detect(scan.ranges(), n, 0.0f, std::numeric_limits<float>::max()) == 0)
+    return;
 
-      ldp->valid[i] = 1;
-      ldp->readings[i] = r;
-    }
-    else
-    {
-      ldp->valid[i] = 0;
-      ldp->readings[i] = -1;  // for invalid range
-    }
+  float* ranges = scan.mutableRanges();
+  for (unsigned int i = 0; i < n; i++)
+    if (temporal_filter_.outlier(i)) ranges[i] = -1.0f;
+}
 
-    ldp->theta[i]    = scan_msg->angle_min + i * scan_msg->angle_increment;
+void LaserScanMatcher::maskDynamic(CompactScan& scan,
+                                   const tf::Transform& keyframe_laser_offset,
+                                   const ros::Time& time)
+{
+  const unsigned int n = scan.size();
 
-    ldp->cluster[i]  = -1;
-  }
+  // both scans of the laser the geometry was cached for
+  if (!geometry_ || !scan.regular() || !keyframe_scan_.regular() ||
+      geometry_->size() != n || keyframe_scan_.size() != n)
+    return;
+
+  // invalid beams have negative ranges
+  const float max = std::numeric_limits<float>::max();
+
+  projectScan(scan.ranges(), n, 0.0f, max,
+              planarProjection(keyframe_laser_offset), *geometry_,
+              keyframe_scan_.angleMin(), keyframe_scan_.angleIncrement(), n,
+              0.0f, max, dynamic_buffers_);
 
-  ldp->min_theta = ldp->theta[0];
-  ldp->max_theta = ldp->theta[n-1];
+  unsigned int count = flagCloserBeams(dynamic_buffers_, keyframe_scan_.ranges(), n,
+                                       0.0f, max, dynamic_min_gap_, dynamic_flags_);
 
-  ldp->odometry[0] = 0.0;
-  ldp->odometry[1] = 0.0;
-  ldp->odometry[2] = 0.0;
+  dynamic_stats_.add(n > 0 ? 100.0 * count / n : 0.0);
+  ROS_DEBUG("Masked %u dynamic beams", count);
 
-  ldp->true_pose[0] = 0.0;
-  ldp->true_pose[1] = 0.0;
-  ldp->true_pose[2] = 0.0;
+  // **** publish the masked beams, in the laser frame of the scan
+
+  if (dynamic_scan_publisher_.getNumSubscribers() > 0)
+    publishDynamic(scan, time);
+
+  if (count == 0) return;
+
+  // **** invalidate them in the scan itself, so that it also leaves them
+  // out as a reference once it becomes the keyframe
+
+  float* ranges = scan.mutableRanges();
+  for (unsigned int i = 0; i < n; i++)
+    if (dynamic_flags_[i]) ranges[i] = -1.0f;
 }
 
-void LaserScanMatcher::createCache (const sensor_msgs::LaserScan::ConstPtr& scan_msg)
+void LaserScanMatcher::publishDynamic(const CompactScan& scan, const ros::Time& time)
 {
-  a_cos_.clear();
-  a_sin_.clear();
+  const unsigned int n = scan.size();
 
-  for (unsigned int i = 0; i < scan_msg->ranges.size(); ++i)
+  sensor_msgs::LaserScan::Ptr dynamic_msg = reuseMessage(dynamic_scan_msg_);
+  dynamic_msg->header.stamp = time;
+  dynamic_msg->header.frame_id = laser_frame_;
+  dynamic_msg->angle_min = scan.angleMin();
+  dynamic_msg->angle_increment = scan.angleIncrement();
+  dynamic_msg->angle_max = scan.angleMin() + (n > 0 ? n - 1 : 0) * scan.angleIncrement();
+  dynamic_msg->range_min = input_.min_reading;
+  dynamic_msg->range_max = input_.max_reading;
+
+  const float* ranges = scan.ranges();
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+
+  dynamic_msg->ranges.resize(n);
+  for (unsigned int i = 0; i < n; i++)
+    dynamic_msg->ranges[i] = dynamic_flags_[i] ? ranges[i] : nan;
+
+  dynamic_scan_publisher_.publish(dynamic_msg);
+}
+
+void LaserScanMatcher::computePointWeights(CompactScan& scan)
+{
+  const unsigned int n = scan.size();
+  const float* ranges = scan.ranges();
+  const float* intensities = use_intensity_weights_ ? scan.intensities() : 0;
+
+  float* weights = scan.mutableWeights();
+
+  if (!use_intensity_weights_)
+  {
+    std::fill(weights, weights + n, 1.0f);
+    return;
+  }
+
+  // **** intensity term
+
+  float intensity_ref = intensity_weight_ref_;
+  if (intensities && intensity_ref <= 0.0)
+  {
+    intensity_ref = 0.0;
+    for (unsigned int i = 0; i < n; i++)
+      if (ranges[i] >= 0.0f)
+        intensity_ref = std::max(intensity_ref, intensities[i]);
+  }
+
+  for (unsigned int i = 0; i < n; i++)
+  {
+    if (intensities && intensity_ref > 0.0f)
+      weights[i] = std::min(intensities[i] / intensity_ref, 1.0f);
+    else
+      weights[i] = 1.0f;
+  }
+
+  // **** incidence term: cosine of the angle between the beam and the
+  // surface normal, the surface given by the two neighbouring points
+
+  const float* x = scan.x();
+  const float* y = scan.y();
+  const float max_d2 = 4.0 * incidence_max_neighbor_dist_ * incidence_max_neighbor_dist_;
+
+  for (unsigned int i = 1; i + 1 < n; i++)
+  {
+    if (ranges[i] <= 0.0f || ranges[i-1] < 0.0f || ranges[i+1] < 0.0f) continue;
+
+    float tx = x[i+1] - x[i-1];
+    float ty = y[i+1] - y[i-1];
+    float t2 = tx*tx + ty*ty;
+    if (t2 > max_d2 || t2 <= 0.0f) continue;
+
+    // |beam x tangent| / |tangent| is the cosine of the incidence angle
+    float cos_incidence = fabs(x[i] * ty - y[i] * tx) / (ranges[i] * sqrt(t2));
+    weights[i] *= cos_incidence;
+  }
+
+  for (unsigned int i = 0; i < n; i++)
+    weights[i] = std::max<float>(weights[i], min_point_weight_);
+}
+
+void LaserScanMatcher::createCache (float angle_min, float angle_increment, unsigned int size,
+                                    float range_min, float range_max)
+{
+  if (ScanGeometryCache::update(geometry_, angle_min, angle_increment, size) &&
+      initialized_)
   {
-    double angle = scan_msg->angle_min + i * scan_msg->angle_increment;
-    a_cos_.push_back(cos(angle));
-    a_sin_.push_back(sin(angle));
+    ROS_INFO("Scan geometry changed to %u beams", size);
   }
 
-  input_.min_reading = scan_msg->range_min;
-  input_.max_reading = scan_msg->range_max;
+  input_.min_reading = range_min;
+  input_.max_reading = range_max;
 }
 
 bool LaserScanMatcher::getBaseLaserTransform(const std::string& frame_id)
@@ -802,6 +1368,7 @@ bool LaserScanMatcher::getBaseLaserTransform(const std::string& frame_id)
   }
   base_from_laser_ = base_from_laser;
   laser_from_base_ = base_from_laser_.inverse();
+  laser_frame_ = frame_id;
 
   return true;
 }
@@ -809,7 +1376,7 @@ bool LaserScanMatcher::getBaseLaserTransform(const std::string& frame_id)
 // returns the predicted offset from the base pose of the last scan
 tf::Transform LaserScanMatcher::getPrediction(const ros::Time& stamp)
 {
-  boost::mutex::scoped_lock(mutex_);
+  boost::mutex::scoped_lock lock(mutex_);
 
   // **** base case - no input available, use zero-motion model
   tf::Transform pred_last_base_offset = tf::Transform::getIdentity();
@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <laser_scan_matcher/reflector_landmarks.h>
+
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace scan_tools
+{
+
+static inline unsigned int wrapIndex(unsigned int i, unsigned int n)
+{
+  return i < n ? i : i - n;
+}
+
+void extractReflectors(const float* ranges,
+                       const float* intensities,
+                       const double* a_cos,
+                       const double* a_sin,
+                       unsigned int n,
+                       double range_min,
+                       double range_max,
+                       bool full_circle,
+                       const ReflectorParams& params,
+                       std::vector<unsigned char>& mask,
+                       std::vector<Reflector>& reflectors)
+{
+  reflectors.clear();
+  mask.resize(n);
+
+  const float threshold = params.intensity_threshold;
+  const float r_min = range_min;
+  const float r_max = range_max;
+
+  // **** classify all beams in one pass (no branches, vectorizes)
+
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    mask[i] = (intensities[i] >= threshold) &
+              (ranges[i] > r_min) &
+              (ranges[i] < r_max);
+  }
+
+  // **** collect clusters of consecutive bright beams
+
+  const double max_width_sq = params.max_width * params.max_width;
+
+  // around the full circle, a cluster may run from the last beam on into
+  // the first: start at a dark beam, so that none is cut in two
+  unsigned int start = 0;
+  if (full_circle)
+    while (start < n && mask[start]) ++start;
+  if (start == n) start = 0;
+
+  unsigned int k = 0;   // beams visited from start
+  while (k < n)
+  {
+    unsigned int i = wrapIndex(start + k, n);
+    if (!mask[i])
+    {
+      ++k;
+      continue;
+    }
+
+    double sx = 0.0, sy = 0.0;
+    double x0 = ranges[i] * a_cos[i];
+    double y0 = ranges[i] * a_sin[i];
+    int beams = 0;
+    bool too_wide = false;
+
+    unsigned int l = k;
+    unsigned int prev = i;
+    for (; l < n; ++l)
+    {
+      unsigned int j = wrapIndex(start + l, n);
+      if (!mask[j]) break;
+      if (l > k && std::fabs(ranges[j] - ranges[prev]) > params.max_gap) break;
+
+      double x = ranges[j] * a_cos[j];
+      double y = ranges[j] * a_sin[j];
+      double dx = x - x0;
+      double dy = y - y0;
+      if (dx*dx + dy*dy > max_width_sq) too_wide = true;
+
+      sx += x;
+      sy += y;
+      ++beams;
+      prev = j;
+    }
+
+    if (!too_wide && beams >= params.min_beams)
+    {
+      Reflector reflector;
+      reflector.x = sx / beams;
+      reflector.y = sy / beams;
+      reflector.beams = beams;
+      reflectors.push_back(reflector);
+    }
+
+    k = l;
+  }
+}
+
+ReflectorMap::ReflectorMap(int min_observations, unsigned int max_candidates):
+  min_observations_(min_observations),
+  max_candidates_(max_candidates),
+  updates_(0)
+{
+
+}
+
+void ReflectorMap::setMaxCandidates(unsigned int max_candidates)
+{
+  max_candidates_ = max_candidates;
+  if (candidates_.size() > max_candidates_) candidates_.resize(max_candidates_);
+}
+
+bool ReflectorMap::load(const std::string& filename)
+{
+  std::ifstream file(filename.c_str());
+  if (!file.is_open()) return false;
+
+  landmarks_.clear();
+  candidates_.clear();
+
+  std::string line;
+  while (std::getline(file, line))
+  {
+    if (line.empty() || line[0] == '#') continue;
+
+    std::istringstream stream(line);
+    ReflectorLandmark landmark;
+    if (stream >> landmark.x >> landmark.y >> landmark.observations)
+      landmarks_.push_back(landmark);
+  }
+
+  return true;
+}
+
+bool ReflectorMap::save(const std::string& filename) const
+{
+  std::ofstream file(filename.c_str());
+  if (!file.is_open()) return false;
+
+  file.precision(9);
+  file << "# x y observations" << std::endl;
+  for (unsigned int i = 0; i < landmarks_.size(); ++i)
+  {
+    const ReflectorLandmark& landmark = landmarks_[i];
+    file << landmark.x << " " << landmark.y << " " << landmark.observations << std::endl;
+  }
+
+  return file.good();
+}
+
+int ReflectorMap::associate(const std::vector<Reflector>& reflectors,
+                            double x, double y, double theta,
+                            double max_dist,
+                            std::vector<int>& matches) const
+{
+  const double c = cos(theta);
+  const double s = sin(theta);
+  const double max_dist_sq = max_dist * max_dist;
+
+  matches.assign(reflectors.size(), -1);
+
+  // best squared distance claimed for each landmark, and by which
+  // reflector, to keep the association one-to-one
+  std::vector<double> claimed(landmarks_.size(),
+    std::numeric_limits<double>::max());
+  std::vector<int> owner(landmarks_.size(), -1);
+
+  // reflectors still to associate, in order; one that loses its landmark
+  // to a closer reflector is pushed back to try its next best
+  std::vector<unsigned int> pending;
+  for (unsigned int i = reflectors.size(); i > 0; --i)
+    pending.push_back(i - 1);
+
+  while (!pending.empty())
+  {
+    unsigned int i = pending.back();
+    pending.pop_back();
+
+    double fx = c * reflectors[i].x - s * reflectors[i].y + x;
+    double fy = s * reflectors[i].x + c * reflectors[i].y + y;
+
+    double best = max_dist_sq;
+    for (unsigned int j = 0; j < landmarks_.size(); ++j)
+    {
+      double dx = landmarks_[j].x - fx;
+      double dy = landmarks_[j].y - fy;
+      double d2 = dx*dx + dy*dy;
+
+      if (d2 < best && d2 < claimed[j])
+      {
+        best = d2;
+        matches[i] = j;
+      }
+    }
+
+    if (matches[i] < 0) continue;
+
+    // release the landmark from a reflector that was further away; each
+    // release lowers a claim, so this ends
+    int loser = owner[matches[i]];
+    if (loser >= 0)
+    {
+      matches[loser] = -1;
+      pending.push_back(loser);
+    }
+
+    owner[matches[i]] = i;
+    claimed[matches[i]] = best;
+  }
+
+  int n = 0;
+  for (unsigned int i = 0; i < matches.size(); ++i)
+    if (matches[i] >= 0) ++n;
+
+  return n;
+}
+
+void ReflectorMap::update(const std::vector<Reflector>& reflectors,
+                          const std::vector<int>& matches,
+                          double x, double y, double theta,
+                          double max_dist)
+{
+  const double c = cos(theta);
+  const double s = sin(theta);
+  const double max_dist_sq = max_dist * max_dist;
+
+  ++updates_;
+
+  for (unsigned int i = 0; i < reflectors.size(); ++i)
+  {
+    double fx = c * reflectors[i].x - s * reflectors[i].y + x;
+    double fy = s * reflectors[i].x + c * reflectors[i].y + y;
+
+    ReflectorLandmark* landmark = NULL;
+    int candidate = -1;
+
+    if (matches[i] >= 0)
+      landmark = &landmarks_[matches[i]];
+    else
+    {
+      // the nearest candidate, if close enough
+      double best = max_dist_sq;
+      for (unsigned int j = 0; j < candidates_.size(); ++j)
+      {
+        double dx = candidates_[j].landmark.x - fx;
+        double dy = candidates_[j].landmark.y - fy;
+        double d2 = dx*dx + dy*dy;
+        if (d2 < best && candidates_[j].last_seen != updates_)
+        {
+          best = d2;
+          candidate = j;
+        }
+      }
+
+      if (candidate >= 0)
+        landmark = &candidates_[candidate].landmark;
+    }
+
+    if (landmark)
+    {
+      // running average of all observations
+      double w = 1.0 / (landmark->observations + 1);
+      landmark->x += w * (fx - landmark->x);
+      landmark->y += w * (fy - landmark->y);
+      landmark->observations++;
+    }
+    else if (max_candidates_ > 0)
+    {
+      // a new candidate, in place of the one seen least recently if full
+      if (candidates_.size() < max_candidates_)
+      {
+        candidates_.push_back(Candidate());
+        candidate = candidates_.size() - 1;
+      }
+      else
+      {
+        candidate = 0;
+        for (unsigned int j = 1; j < candidates_.size(); ++j)
+          if (candidates_[j].last_seen < candidates_[candidate].last_seen)
+            candidate = j;
+      }
+
+      ReflectorLandmark& new_landmark = candidates_[candidate].landmark;
+      new_landmark.x = fx;
+      new_landmark.y = fy;
+      new_landmark.observations = 1;
+    }
+
+    if (candidate < 0) continue;
+
+    candidates_[candidate].last_seen = updates_;
+
+    // **** promote candidates observed often enough
+
+    if (candidates_[candidate].landmark.observations >= min_observations_)
+    {
+      landmarks_.push_back(candidates_[candidate].landmark);
+      candidates_.erase(candidates_.begin() + candidate);
+    }
+  }
+}
+
+bool estimateReflectorPose(const std::vector<Reflector>& reflectors,
+                           const ReflectorMap& map,
+                           const std::vector<int>& matches,
+                           int min_matches,
+                           double& x, double& y, double& theta)
+{
+  const std::vector<ReflectorLandmark>& landmarks = map.landmarks();
+
+  // **** centroids of the associated points
+
+  double ox = 0.0, oy = 0.0; // observed, laser frame
+  double mx = 0.0, my = 0.0; // map, fixed frame
+  int n = 0;
+
+  for (unsigned int i = 0; i < reflectors.size(); ++i)
+  {
+    if (matches[i] < 0) continue;
+    ox += reflectors[i].x;
+    oy += reflectors[i].y;
+    mx += landmarks[matches[i]].x;
+    my += landmarks[matches[i]].y;
+    ++n;
+  }
+
+  if (n < min_matches || n < 2) return false;
+
+  ox /= n; oy /= n;
+  mx /= n; my /= n;
+
+  // **** rotation from the cross-covariance of the centered points
+
+  double sxx = 0.0, sxy = 0.0, syx = 0.0, syy = 0.0;
+
+  for (unsigned int i = 0; i < reflectors.size(); ++i)
+  {
+    if (matches[i] < 0) continue;
+    double ax = reflectors[i].x - ox;
+    double ay = reflectors[i].y - oy;
+    double bx = landmarks[matches[i]].x - mx;
+    double by = landmarks[matches[i]].y - my;
+
+    sxx += ax * bx;
+    sxy += ax * by;
+    syx += ay * bx;
+    syy += ay * by;
+  }
+
+  theta = atan2(sxy - syx, sxx + syy);
+
+  double c = cos(theta);
+  double s = sin(theta);
+  x = mx - (c * ox - s * oy);
+  y = my - (s * ox + c * oy);
+
+  return true;
+}
+
+} // namespace scan_tools
@@ -0,0 +1,359 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <laser_scan_matcher/scan_conversion.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace scan_tools
+{
+
+void laserScanToCompactScan(const sensor_msgs::LaserScan& scan_msg, CompactScan& scan)
+{
+  laserScanToCompactScan(LaserScanView(scan_msg), scan);
+}
+
+void laserScanToCompactScan(const LaserScanView& scan_view, CompactScan& scan)
+{
+  unsigned int n = scan_view.size;
+  scan.setRegular(n, scan_view.angle_min, scan_view.angle_increment);
+
+  const float range_min = scan_view.range_min;
+  const float range_max = scan_view.range_max;
+  const float* in = scan_view.ranges;
+  float* out = scan.mutableRanges();
+
+  for (unsigned int i = 0; i < n; i++)
+  {
+    float r = in[i];
+    out[i] = (r > range_min && r < range_max) ? r : -1.0f;  // -1 for invalid range
+  }
+}
+
+CloudSliceParams::CloudSliceParams():
+  range_min(0.1),
+  range_max(50.0),
+  res(0.05),
+  ring(-1),
+  ring_field("ring"),
+  z_min(-std::numeric_limits<double>::max()),
+  z_max(std::numeric_limits<double>::max()),
+  angle_increment(0.0)
+{
+
+}
+
+namespace
+{
+
+bool useZ(const CloudSliceParams& params)
+{
+  return params.z_min > -std::numeric_limits<double>::max() ||
+         params.z_max <  std::numeric_limits<double>::max();
+}
+
+} // namespace
+
+// Points of a PointCloud2, read through the offsets of their fields
+struct CloudSlicer::CloudMsgPoints
+{
+  const uint8_t* data;
+  unsigned int size;
+  unsigned int width;
+  unsigned int point_step;
+  unsigned int row_step;    // rows may be padded
+  bool use_ring;
+  bool use_z;
+  int ring;
+  double z_min;
+  double z_max;
+  Field x_field;
+  Field y_field;
+  Field z_field;
+  Field ring_field;
+
+  const uint8_t* point(unsigned int i) const
+  {
+    return data + (i / width) * row_step + (i % width) * point_step;
+  }
+
+  bool keep(unsigned int i) const
+  {
+    if (use_ring && (int)readField(point(i), ring_field) != ring) return false;
+    if (use_z)
+    {
+      double z = readField(point(i), z_field);
+      if (!(z >= z_min && z <= z_max)) return false;
+    }
+    return true;
+  }
+
+  double x(unsigned int i) const { return readField(point(i), x_field); }
+  double y(unsigned int i) const { return readField(point(i), y_field); }
+};
+
+// Points of a pcl cloud, which has no ring field
+struct CloudSlicer::PclPoints
+{
+  const PointCloudT* cloud;
+  bool use_z;
+  double z_min;
+  double z_max;
+
+  unsigned int size;
+
+  bool keep(unsigned int i) const
+  {
+    if (!use_z) return true;
+    double z = cloud->points[i].z;
+    return z >= z_min && z <= z_max;
+  }
+
+  double x(unsigned int i) const { return cloud->points[i].x; }
+  double y(unsigned int i) const { return cloud->points[i].y; }
+};
+
+bool CloudSlicer::slice(const sensor_msgs::PointCloud2& cloud,
+                        const CloudSliceParams& params,
+                        CompactScan& scan)
+{
+  // **** locate the fields, only these bytes of each point are read
+
+  CloudMsgPoints points;
+  points.x_field = findField(cloud, "x");
+  points.y_field = findField(cloud, "y");
+  points.z_field = findField(cloud, "z");
+  points.ring_field = findField(cloud, params.ring_field);
+
+  points.use_z = useZ(params);
+  points.use_ring = params.ring >= 0;
+
+  const unsigned int step = cloud.point_step;
+
+  if (!fieldFits(points.x_field, step) || !fieldFits(points.y_field, step) ||
+      (points.use_z && !fieldFits(points.z_field, step)) ||
+      (points.use_ring && !fieldFits(points.ring_field, step)) ||
+      cloud.is_bigendian ||
+      cloud.row_step < cloud.width * cloud.point_step ||
+      cloud.data.size() < (size_t)cloud.height * cloud.row_step)
+  {
+    scan.setIrregular(0);
+    return false;
+  }
+
+  points.size = cloud.width * cloud.height;
+  points.width = cloud.width;
+  points.point_step = cloud.point_step;
+  points.row_step = cloud.row_step;
+  points.data = cloud.data.empty() ? NULL : &cloud.data[0];
+  points.ring = params.ring;
+  points.z_min = params.z_min;
+  points.z_max = params.z_max;
+
+  sliceImpl(points, params, scan);
+  return true;
+}
+
+bool CloudSlicer::slice(const PointCloudT& cloud,
+                        const CloudSliceParams& params,
+                        CompactScan& scan)
+{
+  if (params.ring >= 0)
+  {
+    scan.setIrregular(0);
+    return false;
+  }
+
+  PclPoints points;
+  points.cloud = &cloud;
+  points.use_z = useZ(params);
+  points.z_min = params.z_min;
+  points.z_max = params.z_max;
+  points.size = cloud.points.size();
+
+  sliceImpl(points, params, scan);
+  return true;
+}
+
+template <class Points>
+void CloudSlicer::sliceImpl(const Points& points,
+                            const CloudSliceParams& params,
+                            CompactScan& scan)
+{
+  const unsigned int n_points = points.size;
+
+  const double range_min_sq = params.range_min * params.range_min;
+  const double range_max_sq = params.range_max * params.range_max;
+
+  if (params.angle_increment > 0.0)
+  {
+    // **** one pass: bin by bearing into a regular scan, closest point wins
+
+    const unsigned int n = std::ceil(2.0 * M_PI / params.angle_increment);
+    scan.setRegular(n, -M_PI, params.angle_increment);
+    float* ranges = scan.mutableRanges();
+    std::fill(ranges, ranges + n, -1.0f);  // -1 for invalid range
+
+    for (unsigned int i = 0; i < n_points; ++i)
+    {
+      if (!points.keep(i)) continue;
+
+      double x = points.x(i);
+      double y = points.y(i);
+      double r2 = x*x + y*y;
+
+      // also rejects NaNs
+      if (!(r2 > range_min_sq && r2 < range_max_sq)) continue;
+
+      int bin = (atan2(y, x) + M_PI) / params.angle_increment;
+      if (bin < 0 || bin >= (int)n) bin = 0;   // +pi wraps around
+
+      float r = sqrt(r2);
+      if (ranges[bin] < 0.0f || r < ranges[bin])
+        ranges[bin] = r;
+    }
+  }
+  else
+  {
+    // **** points in cloud order, spaced by at least cloud_res
+
+    double max_d2 = params.res * params.res;
+
+    // reuse the point buffers across scans
+    x_.clear();
+    y_.clear();
+
+    for (unsigned int i = 0; i < n_points; ++i)
+    {
+      if (!points.keep(i)) continue;
+
+      float x = points.x(i);
+      float y = points.y(i);
+
+      if (is_nan(x) || is_nan(y))
+      {
+        ROS_WARN_THROTTLE(10.0, "Laser Scan Matcher: Cloud input contains NaN values. "
+                          "Please use a filtered cloud input.");
+        continue;
+      }
+
+      if (!x_.empty())
+      {
+        double dx = x_.back() - x;
+        double dy = y_.back() - y;
+        if (dx*dx + dy*dy <= max_d2) continue;
+      }
+
+      x_.push_back(x);
+      y_.push_back(y);
+    }
+
+    unsigned int n = x_.size();
+
+    scan.setIrregular(n);
+    float* ranges = scan.mutableRanges();
+    float* theta  = scan.mutableBearings();
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+      double r2 = x_[i] * x_[i] + y_[i] * y_[i];
+
+      if (r2 > range_min_sq && r2 < range_max_sq)
+        ranges[i] = sqrt(r2);
+      else
+        ranges[i] = -1;  // for invalid range
+
+      theta[i] = atan2(y_[i], x_[i]);
+    }
+  }
+}
+
+CloudSlicer::Field CloudSlicer::findField(
+  const sensor_msgs::PointCloud2& cloud, const std::string& name)
+{
+  Field field;
+  field.offset = -1;
+  field.datatype = 0;
+
+  for (unsigned int i = 0; i < cloud.fields.size(); ++i)
+  {
+    if (cloud.fields[i].name == name)
+    {
+      field.offset = cloud.fields[i].offset;
+      field.datatype = cloud.fields[i].datatype;
+      break;
+    }
+  }
+  return field;
+}
+
+unsigned int CloudSlicer::fieldSize(uint8_t datatype)
+{
+  switch (datatype)
+  {
+    case sensor_msgs::PointField::INT8:
+    case sensor_msgs::PointField::UINT8:   return 1;
+    case sensor_msgs::PointField::INT16:
+    case sensor_msgs::PointField::UINT16:  return 2;
+    case sensor_msgs::PointField::INT32:
+    case sensor_msgs::PointField::UINT32:
+    case sensor_msgs::PointField::FLOAT32: return 4;
+    case sensor_msgs::PointField::FLOAT64: return 8;
+  }
+  return 0;
+}
+
+bool CloudSlicer::fieldFits(const Field& field, unsigned int point_step)
+{
+  unsigned int size = fieldSize(field.datatype);
+  return field.offset >= 0 && size > 0 && field.offset + size <= point_step;
+}
+
+double CloudSlicer::readField(const uint8_t* point, const Field& field)
+{
+  const uint8_t* p = point + field.offset;
+
+  switch (field.datatype)
+  {
+    case sensor_msgs::PointField::FLOAT32: { float v;    memcpy(&v, p, sizeof(v)); return v; }
+    case sensor_msgs::PointField::FLOAT64: { double v;   memcpy(&v, p, sizeof(v)); return v; }
+    case sensor_msgs::PointField::INT8:    { int8_t v;   memcpy(&v, p, sizeof(v)); return v; }
+    case sensor_msgs::PointField::UINT8:   { uint8_t v;  memcpy(&v, p, sizeof(v)); return v; }
+    case sensor_msgs::PointField::INT16:   { int16_t v;  memcpy(&v, p, sizeof(v)); return v; }
+    case sensor_msgs::PointField::UINT16:  { uint16_t v; memcpy(&v, p, sizeof(v)); return v; }
+    case sensor_msgs::PointField::INT32:   { int32_t v;  memcpy(&v, p, sizeof(v)); return v; }
+    case sensor_msgs::PointField::UINT32:  { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+  }
+  return std::numeric_limits<double>::quiet_NaN();
+}
+
+} // namespace scan_tools
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <laser_scan_matcher/reflector_landmarks.h>
+
+using namespace scan_tools;
+
+static Reflector makeReflector(double x, double y)
+{
+  Reflector reflector;
+  reflector.x = x;
+  reflector.y = y;
+  reflector.beams = 3;
+  return reflector;
+}
+
+// one update of map, as the matcher does it, with the laser at the origin
+static void observe(ReflectorMap& map, const std::vector<Reflector>& reflectors)
+{
+  std::vector<int> matches;
+  map.associate(reflectors, 0.0, 0.0, 0.0, 0.5, matches);
+  map.update(reflectors, matches, 0.0, 0.0, 0.0, 0.5);
+}
+
+TEST(ReflectorMap, promotesConsistentCandidates)
+{
+  ReflectorMap map(3, 10);
+
+  std::vector<Reflector> reflectors;
+  reflectors.push_back(makeReflector(2.0, 1.0));
+
+  observe(map, reflectors);
+  observe(map, reflectors);
+  EXPECT_EQ(0u, map.landmarks().size());
+  EXPECT_EQ(1u, map.candidateCount());
+
+  // the third observation, a little off
+  reflectors[0] = makeReflector(2.03, 1.0);
+  observe(map, reflectors);
+  ASSERT_EQ(1u, map.landmarks().size());
+  EXPECT_EQ(0u, map.candidateCount());
+  EXPECT_EQ(3, map.landmarks()[0].observations);
+  EXPECT_NEAR(2.01, map.landmarks()[0].x, 1e-9);
+  EXPECT_NEAR(1.0, map.landmarks()[0].y, 1e-9);
+
+  // now it is matched as a landmark, not a new candidate
+  observe(map, reflectors);
+  EXPECT_EQ(1u, map.landmarks().size());
+  EXPECT_EQ(0u, map.candidateCount());
+  EXPECT_EQ(4, map.landmarks()[0].observations);
+}
+
+TEST(ReflectorMap, inconsistentObservationsAreNotPromoted)
+{
+  ReflectorMap map(3, 10);
+
+  // a reflection that shows up somewhere else every scan
+  for (int i = 0; i < 5; ++i)
+  {
+    std::vector<Reflector> reflectors;
+    reflectors.push_back(makeReflector(1.0 + i, 0.0));
+    observe(map, reflectors);
+  }
+
+  EXPECT_EQ(0u, map.landmarks().size());
+  EXPECT_EQ(5u, map.candidateCount());
+}
+
+TEST(ReflectorMap, capsCandidates)
+{
+  ReflectorMap map(3, 4);
+
+  std::vector<Reflector> steady;
+  steady.push_back(makeReflector(0.0, 5.0));
+
+  // the steady reflector stays a recent candidate while spurious ones
+  // come and go
+  for (int i = 0; i < 20; ++i)
+  {
+    std::vector<Reflector> reflectors;
+    reflectors.push_back(makeReflector(1.0 + i, 0.0));
+    observe(map, reflectors);
+    EXPECT_LE(map.candidateCount(), 4u);
+
+    if (i % 2 == 0 && map.landmarks().empty())
+      observe(map, steady);
+  }
+
+  EXPECT_EQ(4u, map.candidateCount());
+  ASSERT_EQ(1u, map.landmarks().size());
+  EXPECT_NEAR(5.0, map.landmarks()[0].y, 1e-9);
+
+  // lowering the cap drops candidates right away
+  map.setMaxCandidates(2);
+  EXPECT_EQ(2u, map.candidateCount());
+}
+
+TEST(ReflectorMap, bumpedReflectorsTakeTheirNextBest)
+{
+  // two landmarks 1 m apart, promoted on first sight
+  ReflectorMap map(1, 10);
+
+  std::vector<Reflector> reflectors;
+  reflectors.push_back(makeReflector(2.0, 0.0));
+  reflectors.push_back(makeReflector(2.0, 1.0));
+  observe(map, reflectors);
+  ASSERT_EQ(2u, map.landmarks().size());
+
+  // the first reflector is nearest to the first landmark too, but loses
+  // it to the second, and falls back to the other landmark
+  reflectors[0] = makeReflector(2.0, 0.45);
+  reflectors[1] = makeReflector(2.0, 0.1);
+
+  std::vector<int> matches;
+  EXPECT_EQ(2, map.associate(reflectors, 0.0, 0.0, 0.0, 0.6, matches));
+  EXPECT_EQ(1, matches[0]);
+  EXPECT_EQ(0, matches[1]);
+}
+
+TEST(ExtractReflectors, mergesAcrossTheSeam)
+{
+  // 360 beams around the full circle, bright on the two at either end
+  const unsigned int n = 360;
+  std::vector<float> ranges(n, 3.0f), intensities(n, 0.0f);
+  std::vector<double> a_cos(n), a_sin(n);
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    double a = -M_PI + i * 2.0 * M_PI / n;
+    a_cos[i] = std::cos(a);
+    a_sin[i] = std::sin(a);
+  }
+  intensities[0] = intensities[1] = intensities[n-2] = intensities[n-1] = 1000.0f;
+
+  ReflectorParams params;
+  params.intensity_threshold = 500.0;
+  params.min_beams = 2;
+  params.max_width = 0.5;
+  params.max_gap = 0.2;
+
+  std::vector<unsigned char> mask;
+  std::vector<Reflector> reflectors;
+
+  extractReflectors(ranges.data(), intensities.data(), a_cos.data(), a_sin.data(),
+                    n, 0.1, 30.0, true, params, mask, reflectors);
+  ASSERT_EQ(1u, reflectors.size());
+  EXPECT_EQ(4, reflectors[0].beams);
+  EXPECT_NEAR(-3.0, reflectors[0].x, 0.01);
+  EXPECT_NEAR(0.0, reflectors[0].y, 0.05);
+
+  // a partial scan ends at its first and last beams
+  extractReflectors(ranges.data(), intensities.data(), a_cos.data(), a_sin.data(),
+                    n, 0.1, 30.0, false, params, mask, reflectors);
+  ASSERT_EQ(2u, reflectors.size());
+  EXPECT_EQ(2, reflectors[0].beams);
+  EXPECT_EQ(2, reflectors[1].beams);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
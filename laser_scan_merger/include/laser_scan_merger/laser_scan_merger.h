@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LASER_SCAN_MERGER_LASER_SCAN_MERGER_H
+#define LASER_SCAN_MERGER_LASER_SCAN_MERGER_H
+
+#include <ros/ros.h>
+#include <sensor_msgs/LaserScan.h>
+#include <tf/transform_listener.h>
+#include <boost/thread/mutex.hpp>
+
+#include <scan_tools_common/realtime.h>
+#include <scan_tools_common/scan_binning.h>
+#include <scan_tools_common/scan_geometry.h>
+
+namespace scan_tools {
+
+/**
+ * Merges the scans of several lasers into one virtual scan in a target
+ * frame, e.g. a front and a rear laser into a 360 degree scan. Each bin
+ * of the virtual scan keeps the closest beam that falls into it.
+ */
+class LaserScanMerger
+{
+  public:
+
+    LaserScanMerger(ros::NodeHandle nh, ros::NodeHandle nh_private);
+    virtual ~LaserScanMerger();
+
+  private:
+
+    struct Input
+    {
+      std::string topic;
+      ros::Subscriber subscriber;
+
+      sensor_msgs::LaserScan::ConstPtr scan_msg;  // waiting to be merged
+
+      ScanGeometryPtr geometry;      // sin and cos of the beam angles, shared
+      std::string frame_id;          // of the cached transform
+      PlanarProjection projection;   // static, cached
+    };
+
+    // **** ROS-related
+
+    ros::NodeHandle nh_;
+    ros::NodeHandle nh_private_;
+    ros::Publisher  scan_publisher_;
+
+    tf::TransformListener tf_listener_;
+
+    // **** paramaters
+
+    std::string target_frame_;
+    double angle_min_;
+    double angle_max_;
+    double angle_increment_;
+    double range_min_;
+    double range_max_;
+    double slop_;
+    double tf_timeout_;
+
+    // **** state variables
+
+    boost::mutex mutex_;
+
+    std::vector<Input> inputs_;
+    unsigned int bins_;
+
+    ScanBinningBuffers buffers_;
+    sensor_msgs::LaserScan::Ptr merged_msg_;
+
+    JitterStats latency_stats_;  // earliest input stamp to publishing [ms]
+    JitterStats merge_stats_;    // [ms]
+
+    // **** member functions
+
+    void scanCallback(const sensor_msgs::LaserScan::ConstPtr& scan_msg, unsigned int index);
+    bool synchronized() const;
+    void mergeScans();
+    bool getTargetToLaserTf(Input& input);
+    void tokenize(const std::string& str, std::vector<std::string>& tokens);
+};
+
+} //namespace scan_tools
+
+#endif // LASER_SCAN_MERGER_LASER_SCAN_MERGER_H
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "laser_scan_merger/laser_scan_merger.h"
+
+#include <cmath>
+#include <limits>
+#include <boost/bind.hpp>
+
+#include <scan_tools_common/reuse_message.h>
+#include <scan_tools_common/trace.h>
+
+namespace scan_tools {
+
+LaserScanMerger::LaserScanMerger(ros::NodeHandle nh, ros::NodeHandle nh_private):
+  nh_(nh),
+  nh_private_(nh_private),
+  bins_(0)
+{
+  ROS_INFO("Starting LaserScanMerger");
+
+  Tracer::instance().advertise(nh_);
+
+  // **** get paramters
+
+  std::string topics_string;
+
+  if (!nh_private_.getParam("topics", topics_string))
+    topics_string = "scan_front scan_rear";
+  if (!nh_private_.getParam("target_frame", target_frame_))
+    target_frame_ = "base_link";
+  if (!nh_private_.getParam("angle_min", angle_min_))
+    angle_min_ = -M_PI;
+  if (!nh_private_.getParam("angle_max", angle_max_))
+    angle_max_ = M_PI;
+  if (!nh_private_.getParam("angle_increment", angle_increment_))
+    angle_increment_ = M_PI / 720.0;
+  if (!nh_private_.getParam("range_min", range_min_))
+    range_min_ = 0.0;
+  if (!nh_private_.getParam("range_max", range_max_))
+    range_max_ = 30.0;
+  if (!nh_private_.getParam("slop", slop_))
+    slop_ = 0.05;
+  if (!nh_private_.getParam("tf_timeout", tf_timeout_))
+    tf_timeout_ = 0.1;
+
+  ROS_ASSERT_MSG(angle_increment_ > 0.0 && angle_max_ > angle_min_,
+    "LaserScanMerger: angle_increment must be > 0, and angle_max > angle_min");
+
+  bins_ = (unsigned int)((angle_max_ - angle_min_) / angle_increment_ + 0.5) + 1;
+
+  std::vector<std::string> topics;
+  tokenize(topics_string, topics);
+
+  ROS_ASSERT_MSG(!topics.empty(), "LaserScanMerger: no input topics given");
+
+  // **** advertise topics
+
+  scan_publisher_ = nh_.advertise<sensor_msgs::LaserScan>(
+    "scan_merged", 10);
+
+  // **** subscribe to laser scan messages
+
+  inputs_.resize(topics.size());
+  for (unsigned int i = 0; i < topics.size(); i++)
+  {
+    inputs_[i].topic = topics[i];
+    inputs_[i].subscriber = nh_.subscribe<sensor_msgs::LaserScan>(
+      topics[i], 10, boost::bind(&LaserScanMerger::scanCallback, this, _1, i));
+  }
+
+  ROS_INFO("Merging %d scans into %u bins in the %s frame",
+    (int)inputs_.size(), bins_, target_frame_.c_str());
+}
+
+LaserScanMerger::~LaserScanMerger()
+{
+  ROS_INFO("Destroying LaserScanMerger");
+
+  if (latency_stats_.count() > 0)
+    ROS_INFO("Scan to merged scan latency: mean %.3f ms, std dev %.3f ms, max %.3f ms over %d scans",
+      latency_stats_.mean(), latency_stats_.stdDev(), latency_stats_.max(),
+      latency_stats_.count());
+
+  if (merge_stats_.count() > 0)
+    ROS_INFO("Merge time: mean %.3f ms, std dev %.3f ms, max %.3f ms",
+      merge_stats_.mean(), merge_stats_.stdDev(), merge_stats_.max());
+}
+
+void LaserScanMerger::scanCallback(const sensor_msgs::LaserScan::ConstPtr& scan_msg,
+                                   unsigned int index)
+{
+  SCAN_TOOLS_TRACE("LaserScanMerger::scanCallback", scan_msg->header.stamp, scan_msg->header.frame_id);
+
+  boost::mutex::scoped_lock lock(mutex_);
+
+  inputs_[index].scan_msg = scan_msg;
+
+  if (synchronized()) mergeScans();
+}
+
+// True once every input has a scan, all within slop of each other. A
+// scan that is too old stays until its laser sends a newer one.
+bool LaserScanMerger::synchronized() const
+{
+  ros::Time earliest, latest;
+
+  for (unsigned int i = 0; i < inputs_.size(); i++)
+  {
+    if (!inputs_[i].scan_msg) return false;
+
+    const ros::Time& stamp = inputs_[i].scan_msg->header.stamp;
+    if (i == 0 || stamp < earliest) earliest = stamp;
+    if (i == 0 || stamp > latest)   latest   = stamp;
+  }
+
+  return (latest - earliest).toSec() <= slop_;
+}
+
+void LaserScanMerger::mergeScans()
+{
+  ros::WallTime start = ros::WallTime::now();
+
+  sensor_msgs::LaserScan::Ptr merged = reuseMessage(merged_msg_);
+
+  merged->header.frame_id = target_frame_;
+  merged->angle_min       = angle_min_;
+  merged->angle_increment = angle_increment_;
+  merged->angle_max       = angle_min_ + angle_increment_ * (bins_ - 1);
+  merged->range_min       = range_min_;
+  merged->range_max       = range_max_;
+  merged->time_increment  = 0.0;
+  merged->scan_time       = 0.0;
+
+  merged->ranges.assign(bins_, std::numeric_limits<float>::infinity());
+
+  bool intensities = true;
+  for (unsigned int i = 0; i < inputs_.size(); i++)
+    intensities = intensities && !inputs_[i].scan_msg->intensities.empty();
+  merged->intensities.assign(intensities ? bins_ : 0, 0.0);
+
+  // the earliest stamp, so that tf has every laser's data for it
+  bool ok = true;
+  for (unsigned int i = 0; i < inputs_.size(); i++)
+  {
+    Input& input = inputs_[i];
+    const sensor_msgs::LaserScan& scan_msg = *input.scan_msg;
+
+    if (i == 0 || scan_msg.header.stamp < merged->header.stamp)
+      merged->header.stamp = scan_msg.header.stamp;
+    merged->scan_time = std::max(merged->scan_time, scan_msg.scan_time);
+
+    if (!getTargetToLaserTf(input))
+    {
+      ok = false;
+      break;
+    }
+
+    ScanGeometryCache::update(input.geometry, scan_msg.angle_min,
+                              scan_msg.angle_increment, scan_msg.ranges.size());
+
+    binScan(scan_msg, input.projection, *input.geometry, *merged, buffers_);
+  }
+
+  for (unsigned int i = 0; i < inputs_.size(); i++)
+    inputs_[i].scan_msg.reset();
+
+  if (!ok) return;
+
+  scan_publisher_.publish(merged);
+
+  // **** statistics
+
+  double dur = (ros::WallTime::now() - start).toSec() * 1e3;
+  merge_stats_.add(dur);
+
+  double latency = (ros::Time::now() - merged->header.stamp).toSec() * 1e3;
+  latency_stats_.add(latency);
+  ROS_DEBUG("Merged %d scans in %.3f ms, latency %.3f ms",
+    (int)inputs_.size(), dur, latency);
+}
+
+bool LaserScanMerger::getTargetToLaserTf(Input& input)
+{
+  const std::string& frame_id = input.scan_msg->header.frame_id;
+  if (frame_id == input.frame_id) return true;
+
+  tf::StampedTransform target_to_laser;
+  try
+  {
+    tf_listener_.waitForTransform(target_frame_, frame_id, ros::Time(0), ros::Duration(tf_timeout_));
+    tf_listener_.lookupTransform (target_frame_, frame_id, ros::Time(0), target_to_laser);
+  }
+  catch (const tf::TransformException& ex)
+  {
+    ROS_WARN("Could not get transform from %s to %s, %s",
+      target_frame_.c_str(), frame_id.c_str(), ex.what());
+    return false;
+  }
+
+  input.projection = planarProjection(target_to_laser);
+  input.frame_id = frame_id;
+  return true;
+}
+
+void LaserScanMerger::tokenize(const std::string& str, std::vector<std::string>& tokens)
+{
+  std::string::size_type last_pos = str.find_first_not_of(" ", 0);
+  std::string::size_type pos = str.find_first_of(" ", last_pos);
+
+  while (std::string::npos != pos || std::string::npos != last_pos)
+  {
+    tokens.push_back(str.substr(last_pos, pos - last_pos));
+    last_pos = str.find_first_not_of(" ", pos);
+    pos = str.find_first_of(" ", last_pos);
+  }
+}
+
+} //namespace scan_tools
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LASER_SCAN_PIPELINE_LASER_SCAN_PIPELINE_H
+#define LASER_SCAN_PIPELINE_LASER_SCAN_PIPELINE_H
+
+#include <ros/ros.h>
+#include <sensor_msgs/LaserScan.h>
+#include <boost/shared_ptr.hpp>
+
+#include <laser_ortho_projector/laser_ortho_projector.h>
+#include <laser_scan_matcher/laser_scan_matcher.h>
+#include <scan_to_cloud_converter/scan_to_cloud_converter.h>
+#include <scan_tools_common/realtime.h>
+#include <scan_tools_common/scan_geometry.h>
+
+namespace scan_tools {
+
+/**
+ * Runs the splitter, sparsifier, ortho projector, cloud converter and
+ * scan matcher as stages of a single scan callback, in the order given by
+ * the ~stages parameter. Intermediate results stay in buffers that are
+ * reused from scan to scan, and are only published if someone subscribed
+ * to them.
+ */
+class LaserScanPipeline
+{
+  public:
+
+    LaserScanPipeline(ros::NodeHandle nh, ros::NodeHandle nh_private);
+    virtual ~LaserScanPipeline();
+
+  private:
+
+    typedef ScanToCloudConverter::PointCloudT PointCloudT;
+
+    enum StageType { SPLIT, SPARSIFY, PROJECT, CONVERT, MATCH };
+
+    struct Stage
+    {
+      StageType type;
+      std::string name;
+      ros::Publisher publisher;  // intermediate output, none for match
+      double time_sum;           // ms
+    };
+
+    // **** ROS-related
+
+    ros::NodeHandle nh_;
+    ros::NodeHandle nh_private_;
+    ros::Subscriber scan_subscriber_;
+
+    // **** paramaters
+
+    std::vector<Stage> stages_;
+
+    int split_offset_;
+    int split_size_;
+    std::string split_frame_id_;
+    int sparsify_step_;
+
+    RealtimeParams realtime_params_;
+
+    // **** state variables
+
+    // all stages run here if realtime_params_ are enabled
+    boost::shared_ptr<CallbackThread> processing_thread_;
+
+    boost::shared_ptr<LaserOrthoProjector> projector_;
+    boost::shared_ptr<LaserScanMatcher> matcher_;
+
+    // scan stages alternate between the two buffers, so a stage never
+    // writes into its own input
+    sensor_msgs::LaserScan::Ptr scan_buffers_[2];
+    PointCloudT::Ptr cloud_buffer_;
+
+    ScanGeometryPtr geometry_;  // sin and cos of the beam angles, shared
+
+    JitterStats latency_stats_;   // scan stamp to end of the last stage, ms
+
+    // **** member functions
+
+    bool initStages();
+    void scanCallback(const sensor_msgs::LaserScan::ConstPtr& scan_msg);
+};
+
+} //namespace scan_tools
+
+#endif // LASER_SCAN_PIPELINE_LASER_SCAN_PIPELINE_H
@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "laser_scan_pipeline/laser_scan_pipeline.h"
+
+#include <laser_scan_sparsifier/laser_scan_sparsifier.h>
+#include <laser_scan_splitter/laser_scan_splitter.h>
+#include <pcl_conversions/pcl_conversions.h>
+#include <scan_tools_common/reuse_message.h>
+#include <scan_tools_common/trace.h>
+
+namespace scan_tools {
+
+LaserScanPipeline::LaserScanPipeline(ros::NodeHandle nh, ros::NodeHandle nh_private):
+  nh_(nh),
+  nh_private_(nh_private)
+{
+  ROS_INFO("Starting LaserScanPipeline");
+
+  Tracer::instance().advertise(nh_);
+
+  if (!initStages())
+  {
+    ROS_ERROR("LaserScanPipeline: invalid ~stages, not subscribing to scans");
+    return;
+  }
+
+  // the whole pipeline runs on its own thread if it needs a different
+  // scheduling, see scan_tools_common/realtime.h
+  loadRealtimeParams(ros::NodeHandle(nh_private_, "realtime"), realtime_params_);
+
+  ros::NodeHandle nh_scans(nh_);
+  if (realtime_params_.enabled())
+  {
+    processing_thread_.reset(new CallbackThread(realtime_params_, "scan_pipeline"));
+    nh_scans.setCallbackQueue(processing_thread_->queue());
+  }
+
+  scan_subscriber_ = nh_scans.subscribe(
+    "scan", 1, &LaserScanPipeline::scanCallback, this);
+}
+
+LaserScanPipeline::~LaserScanPipeline()
+{
+  ROS_INFO("Destroying LaserScanPipeline");
+
+  scan_subscriber_.shutdown();
+  processing_thread_.reset();
+
+  int scan_count = latency_stats_.count();
+  if (scan_count > 0)
+  {
+    for (unsigned int i = 0; i < stages_.size(); ++i)
+      ROS_INFO("Average %s stage time: %.3f ms",
+        stages_[i].name.c_str(), stages_[i].time_sum / scan_count);
+
+    ROS_INFO("Scan to pipeline output latency: mean %.3f ms, std dev %.3f ms, "
+      "max %.3f ms over %d scans", latency_stats_.mean(), latency_stats_.stdDev(),
+      latency_stats_.max(), scan_count);
+  }
+}
+
+bool LaserScanPipeline::initStages()
+{
+  std::vector<std::string> names;
+  if (!nh_private_.getParam("stages", names))
+  {
+    names.push_back("sparsify");
+    names.push_back("match");
+  }
+
+  if (!nh_private_.getParam("split/offset", split_offset_))
+    split_offset_ = 0;
+  if (!nh_private_.getParam("split/size", split_size_))
+    split_size_ = 0;
+  if (!nh_private_.getParam("split/frame_id", split_frame_id_))
+    split_frame_id_ = "";
+  if (!nh_private_.getParam("sparsify/step", sparsify_step_))
+    sparsify_step_ = 2;
+
+  // the scan stages need a scan as input; project and convert turn it
+  // into a cloud, which only the matcher can take
+
+  bool cloud = false;
+  bool matched = false;
+
+  for (unsigned int i = 0; i < names.size(); ++i)
+  {
+    Stage stage;
+    stage.name = names[i];
+    stage.time_sum = 0.0;
+
+    if      (stage.name == "split")    stage.type = SPLIT;
+    else if (stage.name == "sparsify") stage.type = SPARSIFY;
+    else if (stage.name == "project")  stage.type = PROJECT;
+    else if (stage.name == "convert")  stage.type = CONVERT;
+    else if (stage.name == "match")    stage.type = MATCH;
+    else
+    {
+      ROS_ERROR("LaserScanPipeline: unknown stage %s", stage.name.c_str());
+      return false;
+    }
+
+    for (unsigned int j = 0; j < stages_.size(); ++j)
+    {
+      if (stages_[j].type == stage.type)
+      {
+        ROS_ERROR("LaserScanPipeline: stage %s appears twice", stage.name.c_str());
+        return false;
+      }
+    }
+
+    if (matched)
+    {
+      ROS_ERROR("LaserScanPipeline: match has to be the last stage");
+      return false;
+    }
+
+    if (cloud && stage.type != MATCH)
+    {
+      ROS_ERROR("LaserScanPipeline: stage %s needs a scan, but gets a cloud",
+        stage.name.c_str());
+      return false;
+    }
+
+    switch (stage.type)
+    {
+      case SPLIT:
+        if (split_offset_ < 0 || split_size_ <= 0)
+        {
+          ROS_ERROR("LaserScanPipeline: split/offset and split/size must be set");
+          return false;
+        }
+        stage.publisher = nh_private_.advertise<sensor_msgs::LaserScan>(
+          "split/scan", 1);
+        break;
+
+      case SPARSIFY:
+        if (sparsify_step_ < 1)
+        {
+          ROS_ERROR("LaserScanPipeline: sparsify/step must be positive");
+          return false;
+        }
+        stage.publisher = nh_private_.advertise<sensor_msgs::LaserScan>(
+          "sparsify/scan", 1);
+        break;
+
+      case PROJECT:
+        projector_.reset(new LaserOrthoProjector(
+          nh_, ros::NodeHandle(nh_private_, "project"), false));
+        stage.publisher = nh_private_.advertise<PointCloudT>("project/cloud", 1);
+        cloud = true;
+        break;
+
+      case CONVERT:
+        stage.publisher = nh_private_.advertise<PointCloudT>("convert/cloud", 1);
+        cloud = true;
+        break;
+
+      case MATCH:
+      {
+        // the matcher takes whatever the previous stage produces
+        ros::NodeHandle nh_match(nh_private_, "match");
+        nh_match.setParam("use_cloud_input", cloud);
+        matcher_.reset(new LaserScanMatcher(nh_, nh_match, false));
+        matched = true;
+        break;
+      }
+    }
+
+    stages_.push_back(stage);
+  }
+
+  return !stages_.empty();
+}
+
+void LaserScanPipeline::scanCallback(const sensor_msgs::LaserScan::ConstPtr& scan_msg)
+{
+  SCAN_TOOLS_TRACE("LaserScanPipeline::scanCallback", scan_msg->header.stamp, scan_msg->header.frame_id);
+
+  ros::WallTime start = ros::WallTime::now();
+
+  sensor_msgs::LaserScan::ConstPtr scan = scan_msg;
+  PointCloudT::ConstPtr cloud;
+  int next_buffer = 0;
+
+  double stage_time[MATCH + 1];  // every stage type appears at most once
+
+  for (unsigned int i = 0; i < stages_.size(); ++i)
+  {
+    Stage& stage = stages_[i];
+    ros::WallTime stage_start = ros::WallTime::now();
+
+    switch (stage.type)
+    {
+      case SPLIT:
+      {
+        if ((unsigned int)(split_offset_ + split_size_) > scan->ranges.size())
+        {
+          ROS_WARN_THROTTLE(1.0, "LaserScanPipeline: split/offset + split/size "
+            "exceeds the %d beams of the scan", (int)scan->ranges.size());
+          return;
+        }
+
+        sensor_msgs::LaserScan::Ptr out = reuseMessage(scan_buffers_[next_buffer]);
+        next_buffer = 1 - next_buffer;
+
+        const std::string& frame_id =
+          split_frame_id_.empty() ? scan->header.frame_id : split_frame_id_;
+        LaserScanSplitter::splitScan(*scan, split_offset_, split_size_, frame_id, *out);
+        scan = out;
+
+        if (stage.publisher.getNumSubscribers() > 0)
+          stage.publisher.publish(scan);
+        break;
+      }
+
+      case SPARSIFY:
+      {
+        sensor_msgs::LaserScan::Ptr out = reuseMessage(scan_buffers_[next_buffer]);
+        next_buffer = 1 - next_buffer;
+
+        LaserScanSparsifier::sparsifyScan(*scan, sparsify_step_, *out);
+        scan = out;
+
+        if (stage.publisher.getNumSubscribers() > 0)
+          stage.publisher.publish(scan);
+        break;
+      }
+
+      case PROJECT:
+      {
+        PointCloudT::Ptr out = reuseMessage(cloud_buffer_);
+        if (!projector_->project(scan, *out)) return;
+        cloud = out;
+
+        if (stage.publisher.getNumSubscribers() > 0)
+          stage.publisher.publish(cloud);
+        break;
+      }
+
+      case CONVERT:
+      {
+        ScanGeometryCache::update(geometry_, scan->angle_min,
+                                  scan->angle_increment, scan->ranges.size());
+
+        // without the NaNs of invalid beams, which the matcher would skip
+        PointCloudT::Ptr out = reuseMessage(cloud_buffer_);
+        ScanToCloudConverter::convertValidBeams(LaserScanView(*scan), *geometry_, *out);
+        pcl_conversions::toPCL(scan->header, out->header);
+        cloud = out;
+
+        if (stage.publisher.getNumSubscribers() > 0)
+          stage.publisher.publish(cloud);
+        break;
+      }
+
+      case MATCH:
+      {
+        if (cloud)
+          matcher_->pclCloudCallback(cloud);
+        else
+          matcher_->scanCallback(scan);
+        break;
+      }
+    }
+
+    stage_time[i] = (ros::WallTime::now() - stage_start).toSec() * 1e3;
+  }
+
+  // **** statistics, only for scans that made it through all stages
+
+  double latency = (ros::Time::now() - scan_msg->header.stamp).toSec() * 1e3;
+  double total = (ros::WallTime::now() - start).toSec() * 1e3;
+
+  for (unsigned int i = 0; i < stages_.size(); ++i)
+  {
+    stages_[i].time_sum += stage_time[i];
+    ROS_DEBUG("LaserScanPipeline: %s took %.3f ms", stages_[i].name.c_str(), stage_time[i]);
+  }
+  ROS_DEBUG("LaserScanPipeline: %.3f ms for all stages, %.3f ms since the scan stamp",
+    total, latency);
+
+  latency_stats_.add(latency);
+}
+
+} //namespace scan_tools
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LASER_SCAN_SHM_WRITER_LASER_SCAN_SHM_WRITER_H
+#define LASER_SCAN_SHM_WRITER_LASER_SCAN_SHM_WRITER_H
+
+#include <ros/ros.h>
+#include <sensor_msgs/LaserScan.h>
+
+#include <scan_tools_common/ShmScanRef.h>
+#include <scan_tools_common/shm_scan_ring.h>
+
+namespace scan_tools {
+
+/**
+ * Copies the scans it subscribes to into a shared memory ring, and
+ * announces each one with a ShmScanRef message. Meant to be loaded into
+ * the nodelet manager of the laser driver, so the scans reach it without
+ * serialization.
+ */
+class LaserScanShmWriter
+{
+  public:
+
+    LaserScanShmWriter(ros::NodeHandle nh, ros::NodeHandle nh_private);
+    virtual ~LaserScanShmWriter();
+
+  private:
+
+    // **** ROS-related
+
+    ros::NodeHandle nh_;
+    ros::NodeHandle nh_private_;
+    ros::Subscriber scan_subscriber_;
+    ros::Publisher  ref_publisher_;
+
+    // **** paramaters
+
+    std::string segment_;
+    int slots_;
+    int max_beams_;
+
+    // **** state variables
+
+    boost::shared_ptr<ShmScanRing> ring_;
+    scan_tools_common::ShmScanRef::Ptr ref_msg_;
+
+    // **** member functions
+
+    bool createRing(unsigned int max_beams);
+    void scanCallback(const sensor_msgs::LaserScan::ConstPtr& scan_msg);
+};
+
+} //namespace scan_tools
+
+#endif // LASER_SCAN_SHM_WRITER_LASER_SCAN_SHM_WRITER_H
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "laser_scan_shm_writer/laser_scan_shm_writer.h"
+
+#include <algorithm>
+
+#include <scan_tools_common/reuse_message.h>
+#include <scan_tools_common/trace.h>
+
+namespace scan_tools {
+
+LaserScanShmWriter::LaserScanShmWriter(ros::NodeHandle nh, ros::NodeHandle nh_private):
+  nh_(nh),
+  nh_private_(nh_private)
+{
+  ROS_INFO("Starting LaserScanShmWriter");
+
+  Tracer::instance().advertise(nh_);
+
+  // **** get paramters
+
+  // by default, one segment per scan topic, e.g. scan_tools_robot_scan
+  // for /robot/scan
+  if (!nh_private_.getParam("segment", segment_))
+  {
+    segment_ = "scan_tools" + nh_.resolveName("scan");
+    std::replace(segment_.begin(), segment_.end(), '/', '_');
+  }
+  if (!nh_private_.getParam("slots", slots_))
+    slots_ = 16;
+  if (!nh_private_.getParam("max_beams", max_beams_))
+    max_beams_ = 4096;
+
+  if (slots_ < 2 || max_beams_ < 1)
+  {
+    ROS_ERROR("LaserScanShmWriter: slots must be at least 2, max_beams at least 1");
+    return;
+  }
+
+  if (!createRing(max_beams_)) return;
+
+  // **** advertise topics
+
+  ref_publisher_ = nh_.advertise<scan_tools_common::ShmScanRef>(
+    "scan_shm", 10);
+
+  // **** subscribe to laser scan messages
+
+  scan_subscriber_ = nh_.subscribe(
+    "scan", 10, &LaserScanShmWriter::scanCallback, this);
+}
+
+LaserScanShmWriter::~LaserScanShmWriter()
+{
+  ROS_INFO("Destroying LaserScanShmWriter");
+}
+
+bool LaserScanShmWriter::createRing(unsigned int max_beams)
+{
+  if (ring_)
+  {
+    // the old ring is kept if the new one cannot be created
+    if (!ShmScanRing::replace(ring_, max_beams)) return false;
+  }
+  else
+  {
+    ring_ = ShmScanRing::create(segment_, slots_, max_beams);
+    if (!ring_) return false;
+  }
+
+  ROS_INFO("Writing scans to shared memory segment %s: %d slots of up to %u beams",
+    segment_.c_str(), slots_, max_beams);
+  return true;
+}
+
+void LaserScanShmWriter::scanCallback(const sensor_msgs::LaserScan::ConstPtr& scan_msg)
+{
+  SCAN_TOOLS_TRACE("LaserScanShmWriter::scanCallback", scan_msg->header.stamp, scan_msg->header.frame_id);
+
+  if (!ring_) return;
+
+  // a bigger ring for bigger scans; readers notice the new session
+  unsigned int n = scan_msg->ranges.size();
+  if (n > ring_->maxBeams())
+  {
+    ROS_WARN("Scan of %u beams does not fit into the shared memory slots, "
+      "recreating the segment", n);
+
+    // the scans that fit are still written into the old ring on failure
+    if (!createRing(n)) return;
+  }
+
+  scan_tools_common::ShmScanRef::Ptr ref_msg = reuseMessage(ref_msg_);
+  if (ring_->write(*scan_msg, *ref_msg))
+    ref_publisher_.publish(ref_msg);
+}
+
+} //namespace scan_tools
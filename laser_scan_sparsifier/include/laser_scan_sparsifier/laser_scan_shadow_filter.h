@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LASER_SCAN_SPARSIFIER_LASER_SCAN_SHADOW_FILTER_H
+#define LASER_SCAN_SPARSIFIER_LASER_SCAN_SHADOW_FILTER_H
+
+#include <ros/ros.h>
+#include <sensor_msgs/LaserScan.h>
+#include <scan_tools_common/realtime.h>
+#include <scan_tools_common/shadow_filter.h>
+
+namespace scan_tools {
+
+// Invalidates the veiling points of a laser, for the consumers of its
+// scans that have no shadow filtering of their own
+class LaserScanShadowFilter
+{
+  public:
+
+    LaserScanShadowFilter(ros::NodeHandle nh, ros::NodeHandle nh_private);
+    virtual ~LaserScanShadowFilter();
+
+  private:
+
+    // **** ROS-related
+    ros::NodeHandle nh_;
+    ros::NodeHandle nh_private_;
+    ros::Subscriber scan_subscriber_;
+    ros::Publisher  scan_publisher_;
+
+    // **** state variables
+
+    ShadowFilter filter_;
+
+    uint64_t beams_count_;
+    uint64_t veiling_count_;
+    JitterStats filter_stats_;  // [ms] to filter a scan
+
+    // **** member functions
+
+    void scanCallback(const sensor_msgs::LaserScanConstPtr& scan_msg);
+};
+
+} //namespace scan_tools
+
+#endif // LASER_SCAN_SPARSIFIER_LASER_SCAN_SHADOW_FILTER_H
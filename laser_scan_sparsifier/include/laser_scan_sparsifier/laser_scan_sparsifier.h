@@ -32,6 +32,9 @@
 
 #include <ros/ros.h>
 #include <sensor_msgs/LaserScan.h>
+#include <std_msgs/Header.h>
+#include <scan_tools_common/realtime.h>
+#include <scan_tools_common/scan_mask.h>
 
 namespace scan_tools {
 
@@ -39,24 +42,76 @@ class LaserScanSparsifier
 {
   public:
 
+    enum Reduction
+    {
+      STRIDE,   // every step-th beam
+      MIN       // the closest valid beam of every step beams
+    };
+
     LaserScanSparsifier(ros::NodeHandle nh, ros::NodeHandle nh_private);
     virtual ~LaserScanSparsifier();
 
+    /**
+     * Reduces every step beams of scan_msg to one beam of scan_sparse.
+     * With MIN, a bin without valid beams keeps its first beam, and the
+     * sparse beams lie at the center of their bins. Either way, a
+     * sparse scan reduced again gives the same as reducing scan_msg at
+     * once by the product of both steps.
+     */
+    static void sparsifyScan(const sensor_msgs::LaserScan& scan_msg, int step,
+                             sensor_msgs::LaserScan& scan_sparse,
+                             Reduction reduction = STRIDE);
+
   private:
 
+    // One decimation level of the pyramid, with its own topics
+    struct Level
+    {
+      int step;
+      Reduction reduction;
+      int source;               // finer level it is reduced from, -1 for the input
+
+      ros::Publisher scan_publisher;
+      ros::Publisher compressed_publisher;
+    };
+
     // **** ROS-related
     ros::NodeHandle nh_;
     ros::NodeHandle nh_private_;
     ros::Subscriber scan_subscriber_;
-    ros::Publisher  scan_publisher_;
+    ros::Publisher  heartbeat_publisher_;
 
     // **** paramaters
 
     int step_;
+    bool publish_compressed_;
+    double range_resolution_;
+
+    bool publish_on_change_;
+    double change_tolerance_;   // [m] for a beam to count as changed
+    double change_threshold_;   // fraction of changed beams to publish
+    double max_interval_;       // [s] between published scans
+
+    // **** state variables
+
+    std::vector<Level> levels_; // finest first
+
+    ScanMask mask_;             // from the ~mask/ parameters, if any
+    sensor_msgs::LaserScan masked_scan_;  // the masked input, reused
+
+    sensor_msgs::LaserScan::ConstPtr last_published_;
+
+    uint64_t scans_count_;
+    uint64_t published_count_;
+    JitterStats change_stats_;  // [ms] to compare a scan
 
     // **** member functions
 
     void scanCallback(const sensor_msgs::LaserScanConstPtr& scan_msg);
+    bool changed(const sensor_msgs::LaserScan& scan_sparse);
+    void initLevels();
+    void initMask();
+    bool needed(unsigned int index) const;
 };
 
 } //namespace scan_tools
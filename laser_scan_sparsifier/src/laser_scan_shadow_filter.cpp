@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "laser_scan_sparsifier/laser_scan_shadow_filter.h"
+
+#include <scan_tools_common/trace.h>
+
+namespace scan_tools {
+
+LaserScanShadowFilter::LaserScanShadowFilter(ros::NodeHandle nh, ros::NodeHandle nh_private):
+  nh_(nh),
+  nh_private_(nh_private)
+{
+  ROS_INFO ("Starting LaserScanShadowFilter");
+
+  Tracer::instance().advertise(nh_);
+
+  beams_count_ = 0;
+  veiling_count_ = 0;
+
+  // **** get paramters
+
+  double min_angle;
+  int window;
+
+  if (!nh_private_.getParam ("min_angle", min_angle))
+    min_angle = 10.0 * M_PI / 180.0;
+  if (!nh_private_.getParam ("window", window))
+    window = 2;
+
+  ROS_ASSERT_MSG(min_angle > 0.0 && min_angle < M_PI_2,
+    "min_angle parameter is set to %f, must be in (0, pi/2)", min_angle);
+  ROS_ASSERT_MSG(window > 0,
+    "window parameter is set to %d, must be > 0", window);
+
+  filter_.setMinAngle(min_angle);
+  filter_.setWindow(window);
+
+  // **** advertise topics
+
+  scan_publisher_ = nh_.advertise<sensor_msgs::LaserScan>(
+    "scan_filtered", 10);
+
+  // **** subscribe to laser scan messages
+
+  scan_subscriber_ = nh_.subscribe(
+    "scan", 10, &LaserScanShadowFilter::scanCallback, this);
+}
+
+LaserScanShadowFilter::~LaserScanShadowFilter ()
+{
+  ROS_INFO ("Destroying LaserScanShadowFilter");
+
+  if (beams_count_ > 0)
+  {
+    ROS_INFO("Invalidated %llu of %llu beams (%.2f%%) as veiling",
+      (unsigned long long)veiling_count_, (unsigned long long)beams_count_,
+      100.0 * veiling_count_ / beams_count_);
+
+    ROS_INFO("Shadow filtering: mean %.3f ms, std dev %.3f ms, max %.3f ms",
+      filter_stats_.mean(), filter_stats_.stdDev(), filter_stats_.max());
+  }
+}
+
+void LaserScanShadowFilter::scanCallback (const sensor_msgs::LaserScanConstPtr& scan_msg)
+{
+  SCAN_TOOLS_TRACE("LaserScanShadowFilter::scanCallback", scan_msg->header.stamp, scan_msg->header.frame_id);
+
+  if (scan_publisher_.getNumSubscribers() == 0) return;
+
+  sensor_msgs::LaserScan::Ptr scan_filtered =
+    boost::make_shared<sensor_msgs::LaserScan>(*scan_msg);
+
+  ros::WallTime start = ros::WallTime::now();
+  unsigned int veiling = filter_.filter(*scan_filtered);
+  filter_stats_.add((ros::WallTime::now() - start).toSec() * 1e3);
+
+  beams_count_ += scan_msg->ranges.size();
+  veiling_count_ += veiling;
+
+  scan_publisher_.publish(scan_filtered);
+}
+
+} //namespace scan_tools
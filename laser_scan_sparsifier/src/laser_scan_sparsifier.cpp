@@ -29,6 +29,14 @@
 
 #include "laser_scan_sparsifier/laser_scan_sparsifier.h"
 
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+#include <scan_tools_common/scan_change.h>
+#include <scan_tools_common/scan_codec.h>
+#include <scan_tools_common/trace.h>
+
 namespace scan_tools {
 
 LaserScanSparsifier::LaserScanSparsifier(ros::NodeHandle nh, ros::NodeHandle nh_private):
@@ -37,18 +45,46 @@ LaserScanSparsifier::LaserScanSparsifier(ros::NodeHandle nh, ros::NodeHandle nh_
 {
   ROS_INFO ("Starting LaserScanSparsifier");
 
+  Tracer::instance().advertise(nh_);
+
+  scans_count_ = 0;
+  published_count_ = 0;
+
   // **** get paramters
 
   if (!nh_private_.getParam ("step", step_))
     step_ = 2;
+  if (!nh_private_.getParam ("publish_compressed", publish_compressed_))
+    publish_compressed_ = false;
+  if (!nh_private_.getParam ("range_resolution", range_resolution_))
+    range_resolution_ = 0.001;
+
+  // publish every scan by default
+  if (!nh_private_.getParam ("publish_on_change", publish_on_change_))
+    publish_on_change_ = false;
+  if (!nh_private_.getParam ("change_tolerance", change_tolerance_))
+    change_tolerance_ = 0.05;
+  if (!nh_private_.getParam ("change_threshold", change_threshold_))
+    change_threshold_ = 0.01;
+  if (!nh_private_.getParam ("max_interval", max_interval_))
+    max_interval_ = 1.0;
 
   ROS_ASSERT_MSG(step_ > 0,
     "step parameter is set to %d, must be > 0", step_);
+  ROS_ASSERT_MSG(range_resolution_ > 0.0,
+    "range_resolution parameter is set to %f, must be > 0", range_resolution_);
+  ROS_ASSERT_MSG(change_tolerance_ >= 0.0 && change_threshold_ >= 0.0,
+    "change_tolerance and change_threshold parameters must be >= 0");
 
   // **** advertise topics
 
-  scan_publisher_ = nh_.advertise<sensor_msgs::LaserScan>(
-    "scan_sparse", 10);
+  initLevels();
+
+  // the stamps of the scans not published, for consumers to tell a
+  // static scene from a dead laser
+  if (publish_on_change_)
+    heartbeat_publisher_ = nh_.advertise<std_msgs::Header>(
+      "scan_sparse/heartbeat", 10);
 
   // **** subscribe to laser scan messages
 
@@ -59,41 +95,292 @@ LaserScanSparsifier::LaserScanSparsifier(ros::NodeHandle nh, ros::NodeHandle nh_
 LaserScanSparsifier::~LaserScanSparsifier ()
 {
   ROS_INFO ("Destroying LaserScanSparsifier");
+
+  // each scan held back is one that downstream consumers did not process
+  if (publish_on_change_ && scans_count_ > 0)
+  {
+    ROS_INFO("Published %llu of %llu scans (%.1f%%), reduction ratio %.2f",
+      (unsigned long long)published_count_, (unsigned long long)scans_count_,
+      100.0 * published_count_ / scans_count_,
+      published_count_ > 0 ? (double)scans_count_ / published_count_ : 0.0);
+
+    ROS_INFO("Change detection: mean %.3f ms, std dev %.3f ms, max %.3f ms",
+      change_stats_.mean(), change_stats_.stdDev(), change_stats_.max());
+  }
 }
 
 void LaserScanSparsifier::scanCallback (const sensor_msgs::LaserScanConstPtr& scan_msg)
 {
-  sensor_msgs::LaserScan::Ptr scan_sparse;
-  scan_sparse = boost::make_shared<sensor_msgs::LaserScan>();
+  SCAN_TOOLS_TRACE("LaserScanSparsifier::scanCallback", scan_msg->header.stamp, scan_msg->header.frame_id);
+
+  // **** mask the input, so that a reduction never picks a masked beam
+
+  const sensor_msgs::LaserScan* scan = scan_msg.get();
+
+  if (!mask_.empty())
+  {
+    // rebuilt only if the geometry changed
+    if (mask_.update(scan_msg->angle_min, scan_msg->angle_increment, scan_msg->ranges.size()))
+      ROS_INFO("Masking %u of %u beams in sectors, and %u up to the footprint, %u beams after cropping",
+        mask_.sectorMaskedCount(), (unsigned int)scan_msg->ranges.size(),
+        mask_.footprintBeamCount(), mask_.croppedSize());
+
+    masked_scan_ = *scan_msg;
+    mask_.apply(masked_scan_);
+    scan = &masked_scan_;
+  }
+
+  // **** reduce the levels in one pass, each from the finest level it
+  // can be reduced from, and only those with subscribers
+
+  std::vector<sensor_msgs::LaserScan::Ptr> scans_sparse(levels_.size());
+
+  for (unsigned int i = 0; i < levels_.size(); i++)
+  {
+    const Level& level = levels_[i];
+    if (!needed(i)) continue;
+
+    scans_sparse[i] = boost::make_shared<sensor_msgs::LaserScan>();
+
+    if (level.source < 0)
+      sparsifyScan(*scan, level.step, *scans_sparse[i], level.reduction);
+    else
+      sparsifyScan(*scans_sparse[level.source], level.step / levels_[level.source].step,
+                   *scans_sparse[i], level.reduction);
+  }
+
+  scans_count_++;
+
+  // the finest level decides for all of them
+  if (publish_on_change_)
+  {
+    if (!changed(*scans_sparse[0]))
+    {
+      heartbeat_publisher_.publish(scans_sparse[0]->header);
+      return;
+    }
+    last_published_ = scans_sparse[0];
+  }
+
+  published_count_++;
+
+  // **** publish
+
+  for (unsigned int i = 0; i < levels_.size(); i++)
+  {
+    Level& level = levels_[i];
+    const sensor_msgs::LaserScan::Ptr& scan_sparse = scans_sparse[i];
+
+    if (!scan_sparse) continue;
+
+    level.scan_publisher.publish(scan_sparse);
+
+    if (publish_compressed_ && level.compressed_publisher.getNumSubscribers() > 0)
+    {
+      scan_tools_common::CompressedLaserScan::Ptr compressed =
+        boost::make_shared<scan_tools_common::CompressedLaserScan>();
+      compressScan(*scan_sparse, range_resolution_, *compressed);
+      level.compressed_publisher.publish(compressed);
+    }
+  }
+}
+
+// True if level index, or a coarser level reduced from it, has subscribers
+bool LaserScanSparsifier::needed(unsigned int index) const
+{
+  const Level& level = levels_[index];
+
+  if (index == 0 && publish_on_change_) return true;
+
+  if (level.scan_publisher.getNumSubscribers() > 0) return true;
+  if (publish_compressed_ && level.compressed_publisher.getNumSubscribers() > 0) return true;
+
+  for (unsigned int i = index + 1; i < levels_.size(); i++)
+    if (levels_[i].source == (int)index && needed(i)) return true;
+
+  return false;
+}
+
+// Reads ~levels and ~reduction, and advertises the topics of every level:
+// scan_sparse for the single level of ~step, or scan_sparse_<step> for
+// each step in ~levels
+void LaserScanSparsifier::initLevels()
+{
+  std::string levels_string, reduction_string;
+
+  if (!nh_private_.getParam ("levels", levels_string))
+    levels_string = "";
+  if (!nh_private_.getParam ("reduction", reduction_string))
+    reduction_string = "stride";
 
+  std::vector<int> steps;
+  std::vector<std::string> reductions;
+  int step;
+  std::string reduction;
+
+  std::istringstream levels_stream(levels_string);
+  while (levels_stream >> step) steps.push_back(step);
+
+  std::istringstream reduction_stream(reduction_string);
+  while (reduction_stream >> reduction) reductions.push_back(reduction);
+
+  bool single = steps.empty();
+  if (single) steps.push_back(step_);
+
+  ROS_ASSERT_MSG(reductions.size() == 1 || reductions.size() == steps.size(),
+    "reduction parameter must hold one reduction, or one per level");
+
+  initMask();
+
+  levels_.resize(steps.size());
+  for (unsigned int i = 0; i < steps.size(); i++)
+  {
+    Level& level = levels_[i];
+    const std::string& name = reductions[reductions.size() == 1 ? 0 : i];
+
+    ROS_ASSERT_MSG(steps[i] > 0, "levels parameter must hold steps > 0");
+    ROS_ASSERT_MSG(name == "stride" || name == "min",
+      "reduction parameter must be stride or min, is %s", name.c_str());
+    ROS_ASSERT_MSG(i == 0 || steps[i] > steps[i - 1],
+      "levels parameter must hold increasing steps");
+
+    level.step = steps[i];
+    level.reduction = name == "min" ? MIN : STRIDE;
+
+    // the coarsest finer level this one is a multiple of
+    level.source = -1;
+    for (int j = i - 1; j >= 0 && level.source < 0; j--)
+      if (level.step % levels_[j].step == 0 && levels_[j].reduction == level.reduction)
+        level.source = j;
+
+    std::ostringstream topic;
+    topic << "scan_sparse";
+    if (!single) topic << "_" << level.step;
+
+    level.scan_publisher = nh_.advertise<sensor_msgs::LaserScan>(
+      topic.str(), 10);
+
+    if (publish_compressed_)
+      level.compressed_publisher = nh_.advertise<scan_tools_common::CompressedLaserScan>(
+        topic.str() + "/compressed", 10);
+
+    ROS_INFO("Publishing every %d beams (%s) on %s", level.step, name.c_str(), topic.str().c_str());
+  }
+}
+
+// Reads ~mask/sectors (angle pairs, in rad) and ~mask/footprint (x y
+// pairs in the laser frame, in m), both separated by spaces
+void LaserScanSparsifier::initMask()
+{
+  std::string sectors_string, footprint_string;
+  bool crop;
+
+  if (!nh_private_.getParam ("mask/sectors", sectors_string))
+    sectors_string = "";
+  if (!nh_private_.getParam ("mask/footprint", footprint_string))
+    footprint_string = "";
+  if (!nh_private_.getParam ("mask/crop", crop))
+    crop = true;
+
+  std::vector<double> sectors, footprint;
+  double value;
+
+  std::istringstream sectors_stream(sectors_string);
+  while (sectors_stream >> value) sectors.push_back(value);
+
+  std::istringstream footprint_stream(footprint_string);
+  while (footprint_stream >> value) footprint.push_back(value);
+
+  ROS_ASSERT_MSG(sectors.size() % 2 == 0,
+    "mask/sectors parameter must hold pairs of angles, has %d values", (int)sectors.size());
+  ROS_ASSERT_MSG(footprint.size() % 2 == 0 && footprint.size() != 2 && footprint.size() != 4,
+    "mask/footprint parameter must hold at least 3 x y pairs, has %d values", (int)footprint.size());
+
+  for (unsigned int i = 0; i + 1 < sectors.size(); i += 2)
+    mask_.addSector(sectors[i], sectors[i + 1]);
+  mask_.setFootprint(footprint);
+  mask_.setCrop(crop);
+}
+
+// True if scan_sparse differs enough from the last published scan, or
+// if that one is more than max_interval old
+bool LaserScanSparsifier::changed(const sensor_msgs::LaserScan& scan_sparse)
+{
+  if (!last_published_) return true;
+
+  if ((scan_sparse.header.stamp - last_published_->header.stamp).toSec() >= max_interval_ ||
+      scan_sparse.angle_min       != last_published_->angle_min ||
+      scan_sparse.angle_increment != last_published_->angle_increment)
+    return true;
+
+  ros::WallTime start = ros::WallTime::now();
+
+  double change = scanChange(scan_sparse, *last_published_, change_tolerance_);
+
+  change_stats_.add((ros::WallTime::now() - start).toSec() * 1e3);
+
+  ROS_DEBUG("%.1f%% of the beams changed", change * 100.0);
+
+  return change > change_threshold_;
+}
+
+void LaserScanSparsifier::sparsifyScan(const sensor_msgs::LaserScan& scan_msg, int step,
+                                       sensor_msgs::LaserScan& scan_sparse,
+                                       Reduction reduction)
+{
   // copy over equal fields
 
-  scan_sparse->header          = scan_msg->header;
-  scan_sparse->range_min       = scan_msg->range_min;
-  scan_sparse->range_max       = scan_msg->range_max;
-  scan_sparse->angle_min       = scan_msg->angle_min;
-  scan_sparse->angle_increment = scan_msg->angle_increment * step_;
-  scan_sparse->time_increment  = scan_msg->time_increment;
-  scan_sparse->scan_time       = scan_msg->scan_time;
+  scan_sparse.header          = scan_msg.header;
+  scan_sparse.range_min       = scan_msg.range_min;
+  scan_sparse.range_max       = scan_msg.range_max;
+  scan_sparse.angle_min       = scan_msg.angle_min;
+  scan_sparse.angle_increment = scan_msg.angle_increment * step;
+  scan_sparse.time_increment  = scan_msg.time_increment;
+  scan_sparse.scan_time       = scan_msg.scan_time;
+
+  // a min beam lies at the center of its bin
+  if (reduction == MIN)
+    scan_sparse.angle_min += scan_msg.angle_increment * (step - 1) / 2.0;
 
   // determine size of new scan
 
-  unsigned int size_sparse = scan_msg->ranges.size() / step_;
-  scan_sparse->ranges.resize(size_sparse);
+  unsigned int size_sparse = scan_msg.ranges.size() / step;
+  scan_sparse.ranges.resize(size_sparse);
 
   // determine new maximum angle
 
-  scan_sparse->angle_max = 
-    scan_sparse->angle_min + (scan_sparse->angle_increment * (size_sparse - 1));
+  scan_sparse.angle_max = 
+    scan_sparse.angle_min + (scan_sparse.angle_increment * (size_sparse - 1));
 
-  for (unsigned int i = 0; i < size_sparse; i++)
+  if (reduction == STRIDE)
   {
-    scan_sparse->ranges[i] = scan_msg->ranges[i * step_];
-    // TODO - also copy intensity values
+    for (unsigned int i = 0; i < size_sparse; i++)
+    {
+      scan_sparse.ranges[i] = scan_msg.ranges[i * step];
+      // TODO - also copy intensity values
+    }
+    return;
   }
 
-  scan_publisher_.publish(scan_sparse);
+  const float range_min = scan_msg.range_min;
+  const float range_max = scan_msg.range_max;
+  const float none = std::numeric_limits<float>::max();
+
+  for (unsigned int i = 0; i < size_sparse; i++)
+  {
+    const float* bin = &scan_msg.ranges[i * step];
+
+    // branch free, invalid beams (NaN included) compare as none
+    float r_min = none;
+    for (int j = 0; j < step; j++)
+    {
+      float r = bin[j];
+      r_min = std::min(r_min, (r >= range_min && r <= range_max) ? r : none);
+    }
+
+    // the first beam if none is valid, so that invalid stays invalid
+    scan_sparse.ranges[i] = r_min != none ? r_min : bin[0];
+  }
 }
 
 } //namespace scan_tools
-
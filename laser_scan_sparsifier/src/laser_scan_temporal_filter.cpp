@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "laser_scan_sparsifier/laser_scan_temporal_filter.h"
+
+#include <scan_tools_common/trace.h>
+
+namespace scan_tools {
+
+LaserScanTemporalFilter::LaserScanTemporalFilter(ros::NodeHandle nh, ros::NodeHandle nh_private):
+  nh_(nh),
+  nh_private_(nh_private)
+{
+  ROS_INFO ("Starting LaserScanTemporalFilter");
+
+  Tracer::instance().advertise(nh_);
+
+  scans_count_ = 0;
+  stationary_count_ = 0;
+  beams_count_ = 0;
+  outlier_count_ = 0;
+
+  // **** get paramters
+
+  int history;
+  double tolerance;
+  double max_outlier_fraction;
+
+  if (!nh_private_.getParam ("history", history))
+    history = 5;
+  if (!nh_private_.getParam ("tolerance", tolerance))
+    tolerance = 0.1;
+  if (!nh_private_.getParam ("max_outlier_fraction", max_outlier_fraction))
+    max_outlier_fraction = 0.2;
+
+  ROS_ASSERT_MSG(history > 0 && history <= TemporalFilter::MAX_HISTORY,
+    "history parameter is set to %d, must be in [1, %d]", history, TemporalFilter::MAX_HISTORY);
+  ROS_ASSERT_MSG(tolerance >= 0.0,
+    "tolerance parameter is set to %f, must be >= 0", tolerance);
+
+  filter_.setHistory(history);
+  filter_.setTolerance(tolerance);
+  filter_.setMaxOutlierFraction(max_outlier_fraction);
+
+  // **** advertise topics
+
+  scan_publisher_ = nh_.advertise<sensor_msgs::LaserScan>(
+    "scan_filtered", 10);
+
+  // **** subscribe to laser scan messages
+
+  scan_subscriber_ = nh_.subscribe(
+    "scan", 10, &LaserScanTemporalFilter::scanCallback, this);
+}
+
+LaserScanTemporalFilter::~LaserScanTemporalFilter ()
+{
+  ROS_INFO ("Destroying LaserScanTemporalFilter");
+
+  if (scans_count_ > 0)
+  {
+    ROS_INFO("Stationary for %llu of %llu scans, invalidated %llu of %llu beams (%.2f%%)",
+      (unsigned long long)stationary_count_, (unsigned long long)scans_count_,
+      (unsigned long long)outlier_count_, (unsigned long long)beams_count_,
+      beams_count_ > 0 ? 100.0 * outlier_count_ / beams_count_ : 0.0);
+
+    ROS_INFO("Temporal filtering: mean %.3f ms, std dev %.3f ms, max %.3f ms",
+      filter_stats_.mean(), filter_stats_.stdDev(), filter_stats_.max());
+  }
+}
+
+void LaserScanTemporalFilter::scanCallback (const sensor_msgs::LaserScanConstPtr& scan_msg)
+{
+  SCAN_TOOLS_TRACE("LaserScanTemporalFilter::scanCallback", scan_msg->header.stamp, scan_msg->header.frame_id);
+
+  // the history would be out of date once subscribed again
+  if (scan_publisher_.getNumSubscribers() == 0)
+  {
+    filter_.reset();
+    return;
+  }
+
+  sensor_msgs::LaserScan::Ptr scan_filtered =
+    boost::make_shared<sensor_msgs::LaserScan>(*scan_msg);
+
+  ros::WallTime start = ros::WallTime::now();
+  unsigned int outliers = filter_.filter(*scan_filtered);
+  filter_stats_.add((ros::WallTime::now() - start).toSec() * 1e3);
+
+  scans_count_++;
+  if (filter_.stationary()) stationary_count_++;
+  beams_count_ += scan_msg->ranges.size();
+  outlier_count_ += outliers;
+
+  scan_publisher_.publish(scan_filtered);
+}
+
+} //namespace scan_tools
@@ -46,12 +46,15 @@ class LaserScanSplitter
     ros::NodeHandle nh_private_;
     ros::Subscriber scan_subscriber_;
     std::vector<ros::Publisher> scan_publishers_;
+    std::vector<ros::Publisher> compressed_publishers_;
 
     // **** paramaters
 
     std::vector<std::string> published_scan_topics_;
     std::vector<std::string> published_laser_frames_;
     std::vector<int> sizes_;
+    bool publish_compressed_;
+    double range_resolution_;
 
     // **** state variables
 
@@ -66,6 +69,11 @@ class LaserScanSplitter
 
     LaserScanSplitter (ros::NodeHandle nh, ros::NodeHandle nh_private);
     virtual ~ LaserScanSplitter ();
+
+    // Copies size beams of scan_msg, starting at beam offset, into scan_segment
+    static void splitScan (const sensor_msgs::LaserScan& scan_msg, int offset, int size,
+                           const std::string& frame_id,
+                           sensor_msgs::LaserScan& scan_segment);
 };
 
 } //namespace scan_tools
@@ -29,6 +29,9 @@
 
 #include "laser_scan_splitter/laser_scan_splitter.h"
 
+#include <scan_tools_common/scan_codec.h>
+#include <scan_tools_common/trace.h>
+
 namespace scan_tools {
 
 LaserScanSplitter::LaserScanSplitter(ros::NodeHandle nh, ros::NodeHandle nh_private):
@@ -37,6 +40,8 @@ LaserScanSplitter::LaserScanSplitter(ros::NodeHandle nh, ros::NodeHandle nh_priv
 {
   ROS_INFO ("Starting LaserScanSplitter");
 
+  Tracer::instance().advertise(nh_);
+
   // **** get paramters
 
   std::string topics_string;
@@ -49,6 +54,10 @@ LaserScanSplitter::LaserScanSplitter(ros::NodeHandle nh, ros::NodeHandle nh_priv
     frames_string = "laser laser";
   if (!nh_private_.getParam ("sizes", sizes_string))
     sizes_string = "256 256";
+  if (!nh_private_.getParam ("publish_compressed", publish_compressed_))
+    publish_compressed_ = false;
+  if (!nh_private_.getParam ("range_resolution", range_resolution_))
+    range_resolution_ = 0.001;
 
   // **** tokenize inputs
   tokenize (topics_string, published_scan_topics_);
@@ -81,6 +90,10 @@ LaserScanSplitter::LaserScanSplitter(ros::NodeHandle nh, ros::NodeHandle nh_priv
     scan_publishers_.push_back (ros::Publisher ());
     scan_publishers_[i] = 
       nh_.advertise<sensor_msgs::LaserScan>(published_scan_topics_[i], 10);
+
+    if (publish_compressed_)
+      compressed_publishers_.push_back (
+        nh_.advertise<scan_tools_common::CompressedLaserScan>(published_scan_topics_[i] + "/compressed", 10));
   }
 }
 
@@ -91,6 +104,8 @@ LaserScanSplitter::~LaserScanSplitter ()
 
 void LaserScanSplitter::scanCallback (const sensor_msgs::LaserScanConstPtr & scan_msg)
 {
+  SCAN_TOOLS_TRACE("LaserScanSplitter::scanCallback", scan_msg->header.stamp, scan_msg->header.frame_id);
+
   // **** check for scan size
   if (size_sum_ != scan_msg->ranges.size ())
   {
@@ -107,29 +122,44 @@ void LaserScanSplitter::scanCallback (const sensor_msgs::LaserScanConstPtr & sca
     sensor_msgs::LaserScan::Ptr scan_segment;
     scan_segment = boost::make_shared<sensor_msgs::LaserScan>();
 
-    scan_segment->header = scan_msg->header;
-    scan_segment->range_min = scan_msg->range_min;
-    scan_segment->range_max = scan_msg->range_max;
-    scan_segment->angle_increment = scan_msg->angle_increment;
-    scan_segment->time_increment = scan_msg->time_increment;
-    scan_segment->scan_time = scan_msg->scan_time;
-    scan_segment->header.frame_id = published_laser_frames_[i];
-
-    scan_segment->angle_min = 
-      scan_msg->angle_min + (scan_msg->angle_increment * r);
-    scan_segment->angle_max = 
-      scan_msg->angle_min + (scan_msg->angle_increment * (r + sizes_[i] - 1));
-
-    // TODO - also copy intensity values
-
-    scan_segment->ranges.resize(sizes_[i]);
-    memcpy(&scan_segment->ranges[0], &scan_msg->ranges[r], sizes_[i]*sizeof(int));
+    splitScan (*scan_msg, r, sizes_[i], published_laser_frames_[i], *scan_segment);
     r+=sizes_[i];
 
     scan_publishers_[i].publish (scan_segment);
+
+    if (publish_compressed_ && compressed_publishers_[i].getNumSubscribers () > 0)
+    {
+      scan_tools_common::CompressedLaserScan::Ptr compressed =
+        boost::make_shared<scan_tools_common::CompressedLaserScan>();
+      compressScan (*scan_segment, range_resolution_, *compressed);
+      compressed_publishers_[i].publish (compressed);
+    }
   }
 }
 
+void LaserScanSplitter::splitScan (const sensor_msgs::LaserScan& scan_msg, int offset, int size,
+                                   const std::string& frame_id,
+                                   sensor_msgs::LaserScan& scan_segment)
+{
+  scan_segment.header = scan_msg.header;
+  scan_segment.range_min = scan_msg.range_min;
+  scan_segment.range_max = scan_msg.range_max;
+  scan_segment.angle_increment = scan_msg.angle_increment;
+  scan_segment.time_increment = scan_msg.time_increment;
+  scan_segment.scan_time = scan_msg.scan_time;
+  scan_segment.header.frame_id = frame_id;
+
+  scan_segment.angle_min = 
+    scan_msg.angle_min + (scan_msg.angle_increment * offset);
+  scan_segment.angle_max = 
+    scan_msg.angle_min + (scan_msg.angle_increment * (offset + size - 1));
+
+  // TODO - also copy intensity values
+
+  scan_segment.ranges.resize(size);
+  memcpy(&scan_segment.ranges[0], &scan_msg.ranges[offset], size*sizeof(float));
+}
+
 void LaserScanSplitter::tokenize (const std::string & str, std::vector < std::string > &tokens)
 {
   std::string::size_type last_pos = str.find_first_not_of (" ", 0);
@@ -37,10 +37,7 @@
 #include <tf/transform_broadcaster.h>
 #include <sensor_msgs/LaserScan.h>
 
-const double DEG_TO_RAD = 3.14159 / 180.0;
-
-const double RANGE_MIN = 0.20;
-const double RANGE_MAX = 50.0;
+#include "ncd_parser/ncd_reader.h"
 
 const std::string worldFrame_      = "map";
 const std::string odomFrame_       = "odom";
@@ -65,19 +62,11 @@ class NCDParser
     tf::Transform  odomToLeftLaser_;
     tf::Transform  odomToRightLaser_;
 
-    void publishLaserMessage(const std::vector<std::string>& tokens,
+    void publishLaserMessage(NCDRecord& record,
                              const std::string& laserFrame,
                              const ros::Publisher& publisher);
 
-    void publishTfMessages(const std::vector<std::string>& tokens);
-
-    void tokenize (const std::string& str, 
-                         std::vector <std::string> &tokens, 
-                         std::string sentinel);
-
-    std::vector<float> extractArray(std::string s, std::string pattern);
-
-    double extractValue(std::string s, std::string pattern);
+    void publishTfMessages(const NCDRecord& record);
 
     void createOdomToLeftLaserTf();
     void createOdomToRightLaserTf();
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef NCD_PARSER_NCD_READER
+#define NCD_PARSER_NCD_READER
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sensor_msgs/LaserScan.h>
+
+const double DEG_TO_RAD = 3.14159 / 180.0;
+
+const double RANGE_MIN = 0.20;
+const double RANGE_MAX = 50.0;
+
+// One laser or odometry entry of an .alog file
+struct NCDRecord
+{
+  enum Type { LASER_LEFT, LASER_RIGHT, ODOMETRY };
+
+  Type type;
+  double log_time;              // first column, time since the log started
+  double time;
+
+  sensor_msgs::LaserScan scan;  // laser entries, without frame_id
+
+  double x, y, theta;           // odometry entries
+  double pitch, roll;
+};
+
+// Reads the laser and odometry entries of a New College Dataset .alog
+// file, without any dependency on a running ROS master. Used by the
+// ncd_parser node and by offline tools.
+class NCDReader
+{
+  public:
+
+    NCDReader();
+
+    bool open(const std::string& filename);
+
+    /**
+     * Reads the next laser or odometry entry, skipping everything else.
+     *
+     * @returns False at the end of the file.
+     */
+    bool next(NCDRecord& record);
+
+    static void tokenize (const std::string& str,
+                                std::vector <std::string> &tokens,
+                                std::string sentinel);
+
+    static std::vector<float> extractArray(std::string s, std::string pattern);
+
+    static double extractValue(std::string s, std::string pattern);
+
+  private:
+
+    std::ifstream aLogFile_;
+    int lineCounter_;
+};
+
+#endif
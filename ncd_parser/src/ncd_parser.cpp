@@ -79,58 +79,39 @@ NCDParser::~NCDParser()
 
 void NCDParser::launch()
 {
-  std::ifstream aLogFile;
-  aLogFile.open(filename_);
+  NCDReader reader;
 
-  if(!aLogFile.is_open())
+  if(!reader.open(filename_))
     ROS_FATAL("Could not open %s\n", filename_);
 
-  int lineCounter = 0;
-  std::string line;
-
-  // **** skip first lines
-
-  for (int i = 0; i < 210; i++)
-  {
-    getline(aLogFile, line);
-    lineCounter++;
-  }
-
   // **** iterate over rest of file
 
-  while (getline(aLogFile, line))
-  {
-    lineCounter++;
-    std::vector<std::string> tokens;
-    tokenize(line, tokens, " ");
-
-    // skip incomplete line
-    if (tokens.size() < 4) continue;
+  NCDRecord record;
 
+  while (reader.next(record))
+  {
     // skip log entries before start time
-    if (strtod(tokens[0].c_str(), NULL) <= start_) continue;
+    if (record.log_time <= start_) continue;
 
     // stop if time is bigger than end point time
-    if (strtod(tokens[0].c_str(), NULL) > end_ && end_ != -1)
+    if (record.log_time > end_ && end_ != -1)
     {
-      std::cout << strtod(tokens[0].c_str(), NULL) << ", " << end_ << std::endl;
+      std::cout << record.log_time << ", " << end_ << std::endl;
       ROS_INFO("Reached specified end time.");
       break;
     }
 
     // publish messages
-    if      (tokens[1].compare("LMS_LASER_2D_LEFT") == 0)
-      publishLaserMessage(tokens, leftLaserFrame_, leftLaserPublisher_);  
-    else if (tokens[1].compare("LMS_LASER_2D_RIGHT") == 0)
-      publishLaserMessage(tokens, rightLaserFrame_, rightLaserPublisher_);
-    else if (tokens[1].compare("ODOMETRY_POSE") == 0)
-      publishTfMessages(tokens);
+    if      (record.type == NCDRecord::LASER_LEFT)
+      publishLaserMessage(record, leftLaserFrame_, leftLaserPublisher_);
+    else if (record.type == NCDRecord::LASER_RIGHT)
+      publishLaserMessage(record, rightLaserFrame_, rightLaserPublisher_);
     else
-      continue;
+      publishTfMessages(record);
 
     // wait before publishing next message
 
-    double time = extractValue(tokens[3], "time=");
+    double time = record.time;
 
     if(lastTime_ == -1) lastTime_ = time; 
     else
@@ -142,56 +123,30 @@ void NCDParser::launch()
   }
 }
 
-void NCDParser::publishLaserMessage(const std::vector<std::string>& tokens,
+void NCDParser::publishLaserMessage(NCDRecord& record,
                                     const std::string& laserFrame,
                                     const ros::Publisher& publisher)
 {
   ROS_DEBUG("Laser message");
 
-  sensor_msgs::LaserScan scan;
-
-  double time = extractValue(tokens[3], "time=");
-
-  scan.header.stamp    = ros::Time(time);
-  scan.header.frame_id = laserFrame;
-
-  scan.angle_min       = extractValue(tokens[3], "minAngle=") * DEG_TO_RAD; 
-  scan.angle_max       = extractValue(tokens[3], "maxAngle=") * DEG_TO_RAD; 
-  scan.angle_increment = extractValue(tokens[3], "angRes=")   * DEG_TO_RAD; 
-  scan.range_min       = RANGE_MIN;
-  scan.range_max       = RANGE_MAX;
-  scan.ranges          = extractArray(tokens[3], "Range=[181]");
-  scan.intensities     = extractArray(tokens[3], "Reflectance=[181]");
+  record.scan.header.frame_id = laserFrame;
 
-  publisher.publish(scan);
+  publisher.publish(record.scan);
 }
 
-void NCDParser::publishTfMessages(const std::vector<std::string>& tokens)
+void NCDParser::publishTfMessages(const NCDRecord& record)
 {
   ROS_DEBUG("Tf message");
 
-  // extract time
-  double time = extractValue(tokens[3], "time=");
-
-  // extract x, y, theta
-  std::vector<float> xytheta = extractArray(tokens[3], "Pose=[3x1]");
-  double x     = xytheta[0];
-  double y     = xytheta[1];
+  double time  = record.time;
   double z     = 0.0;
-  double theta = xytheta[2];       
-
-  // extract Pitch
-  double pitch = extractValue(tokens[3], "Pitch=");
-
-  // extract Roll
-  double roll = extractValue(tokens[3], "Roll=");
 
   tf::Quaternion rotation;
-  rotation.setRPY (roll, pitch, theta);
+  rotation.setRPY (record.roll, record.pitch, record.theta);
   worldToOdom_.setRotation (rotation);
 
   tf::Vector3 origin;
-  origin.setValue (x, y, z);
+  origin.setValue (record.x, record.y, z);
   worldToOdom_.setOrigin (origin);
 
   tf::StampedTransform worldToOdomStamped(worldToOdom_, ros::Time(time), worldFrame_, odomFrame_);
@@ -204,48 +159,6 @@ void NCDParser::publishTfMessages(const std::vector<std::string>& tokens)
   tfBroadcaster_.sendTransform(odomToRightLaserStamped);
 }
 
-void NCDParser::tokenize (const std::string& str, 
-                                std::vector <std::string> &tokens, 
-                                std::string sentinel)
-{
-  std::string::size_type lastPos = str.find_first_not_of (sentinel, 0);
-  std::string::size_type pos = str.find_first_of (sentinel, lastPos);
-
-  while (std::string::npos != pos || std::string::npos != lastPos)
-  {
-    std::string stringToken = str.substr (lastPos, pos - lastPos);
-    tokens.push_back (stringToken);
-    lastPos = str.find_first_not_of (sentinel, pos);
-    pos = str.find_first_of (sentinel, lastPos);
-  }
-}
-
-std::vector<float> NCDParser::extractArray(std::string s, std::string pattern)
-{
-  int n0 = s.find(pattern);
-  int n1 = s.find("{", n0);
-  int n2 = s.find("}", n1);
-  std::string valueList = s.substr(n1+1, n2-n1-1);
-  
-  std::vector<float> values;
-  std::vector<std::string> s_values;
-  tokenize(valueList, s_values, ",");
-
-  for (unsigned int i = 0; i < s_values.size(); i++)
-    values.push_back(strtod(s_values[i].c_str(), NULL));
-
-  return values;
-}
-
-double NCDParser::extractValue(std::string s, std::string pattern)
-{
-  int n1 = s.find(pattern);
-  int n2 = s.find(",", n1);
-  std::string s_value = s.substr(n1+pattern.length(), n2-n1-pattern.length());
-  return strtod(s_value.c_str(), NULL);
-}
-
-
 void NCDParser::createOdomToLeftLaserTf()
 {
   double x     = -0.270;
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "ncd_parser/ncd_reader.h"
+
+#include <cstdlib>
+
+NCDReader::NCDReader():lineCounter_(0)
+{
+
+}
+
+bool NCDReader::open(const std::string& filename)
+{
+  aLogFile_.open(filename.c_str());
+
+  if(!aLogFile_.is_open()) return false;
+
+  std::string line;
+
+  // **** skip first lines
+
+  for (int i = 0; i < 210; i++)
+  {
+    getline(aLogFile_, line);
+    lineCounter_++;
+  }
+
+  return true;
+}
+
+bool NCDReader::next(NCDRecord& record)
+{
+  std::string line;
+
+  while (getline(aLogFile_, line))
+  {
+    lineCounter_++;
+    std::vector<std::string> tokens;
+    tokenize(line, tokens, " ");
+
+    // skip incomplete line
+    if (tokens.size() < 4) continue;
+
+    if      (tokens[1].compare("LMS_LASER_2D_LEFT") == 0)
+      record.type = NCDRecord::LASER_LEFT;
+    else if (tokens[1].compare("LMS_LASER_2D_RIGHT") == 0)
+      record.type = NCDRecord::LASER_RIGHT;
+    else if (tokens[1].compare("ODOMETRY_POSE") == 0)
+      record.type = NCDRecord::ODOMETRY;
+    else
+      continue;
+
+    record.log_time = strtod(tokens[0].c_str(), NULL);
+    record.time     = extractValue(tokens[3], "time=");
+
+    if (record.type == NCDRecord::ODOMETRY)
+    {
+      // extract x, y, theta
+      std::vector<float> xytheta = extractArray(tokens[3], "Pose=[3x1]");
+      if (xytheta.size() < 3) continue;
+
+      record.x     = xytheta[0];
+      record.y     = xytheta[1];
+      record.theta = xytheta[2];
+
+      record.pitch = extractValue(tokens[3], "Pitch=");
+      record.roll  = extractValue(tokens[3], "Roll=");
+    }
+    else
+    {
+      sensor_msgs::LaserScan& scan = record.scan;
+
+      scan.header.stamp    = ros::Time(record.time);
+      scan.angle_min       = extractValue(tokens[3], "minAngle=") * DEG_TO_RAD;
+      scan.angle_max       = extractValue(tokens[3], "maxAngle=") * DEG_TO_RAD;
+      scan.angle_increment = extractValue(tokens[3], "angRes=")   * DEG_TO_RAD;
+      scan.range_min       = RANGE_MIN;
+      scan.range_max       = RANGE_MAX;
+      scan.ranges          = extractArray(tokens[3], "Range=[181]");
+      scan.intensities     = extractArray(tokens[3], "Reflectance=[181]");
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+void NCDReader::tokenize (const std::string& str,
+                                std::vector <std::string> &tokens,
+                                std::string sentinel)
+{
+  std::string::size_type lastPos = str.find_first_not_of (sentinel, 0);
+  std::string::size_type pos = str.find_first_of (sentinel, lastPos);
+
+  while (std::string::npos != pos || std::string::npos != lastPos)
+  {
+    std::string stringToken = str.substr (lastPos, pos - lastPos);
+    tokens.push_back (stringToken);
+    lastPos = str.find_first_not_of (sentinel, pos);
+    pos = str.find_first_of (sentinel, lastPos);
+  }
+}
+
+std::vector<float> NCDReader::extractArray(std::string s, std::string pattern)
+{
+  int n0 = s.find(pattern);
+  int n1 = s.find("{", n0);
+  int n2 = s.find("}", n1);
+  std::string valueList = s.substr(n1+1, n2-n1-1);
+
+  std::vector<float> values;
+  std::vector<std::string> s_values;
+  tokenize(valueList, s_values, ",");
+
+  for (unsigned int i = 0; i < s_values.size(); i++)
+    values.push_back(strtod(s_values[i].c_str(), NULL));
+
+  return values;
+}
+
+double NCDReader::extractValue(std::string s, std::string pattern)
+{
+  int n1 = s.find(pattern);
+  int n2 = s.find(",", n1);
+  std::string s_value = s.substr(n1+pattern.length(), n2-n1-pattern.length());
+  return strtod(s_value.c_str(), NULL);
+}
@@ -43,6 +43,8 @@
 #include <string.h>
 #include <vector>
 
+#include <scan_tools_common/scan_geometry.h>
+
 #define PM_TYPE             double // change it to double for higher accuracy  and lower speed
 
 // range reading errors
@@ -109,10 +111,6 @@ class PolarMatcher
     void pm_cov_est(PM_TYPE err, double *c11,double *c12, double *c22, double *c33,
                         bool corridor=false, PM_TYPE corr_angle=0);
 
-    void pm_scan_project(const PMScan *act,  PM_TYPE   *new_r,  int *new_bad);
-    PM_TYPE pm_orientation_search(const PMScan *ref, const PM_TYPE *new_r, const int *new_bad);
-    PM_TYPE pm_translation_estimation(const PMScan *ref, const PM_TYPE *new_r, const int *new_bad, PM_TYPE C, PM_TYPE *dx, PM_TYPE *dy);
-
     PM_TYPE point_line_distance ( PM_TYPE x1, PM_TYPE y1, PM_TYPE x2, PM_TYPE y2,
                               PM_TYPE x3, PM_TYPE y3,PM_TYPE *x, PM_TYPE *y);
 
@@ -136,9 +134,10 @@ class PolarMatcher
     PM_TYPE PM_FI_MAX;// = M_PI/2.0 + PM_FOV*PM_D2R/2.0;//[rad] bearing at which laser scans end
     PM_TYPE PM_DFI;   // = PM_FOV*PM_D2R/ ( PM_L_POINTS + 1.0 );//[rad] angular resolution of laser scans
 
-    std::vector<PM_TYPE>  pm_fi;//contains precomputed angles
-    std::vector<PM_TYPE>  pm_si;//contains sinus of angles
-    std::vector<PM_TYPE>  pm_co;//contains cos of angles
+    const double*  pm_fi;//contains precomputed angles
+    const double*  pm_si;//contains sinus of angles
+    const double*  pm_co;//contains cos of angles
+    scan_tools::ScanGeometryPtr pm_geometry;//holds the tables above, shared between matchers
 
     double  PM_FOV ;             //! field of view of the laser range finder in degrees
     double  PM_MAX_RANGE ;       //![cm] max valid laser range (set this to about 400 for the Hokuyo URG)
@@ -168,6 +167,11 @@ class PolarMatcher
     //segments scanpoints into groups based on range discontinuities
     void pm_segment_scan(PMScan *ls);
 
+    // the steps of a PSM iteration, public so they can be benchmarked separately
+    void pm_scan_project(const PMScan *act,  PM_TYPE   *new_r,  int *new_bad);
+    PM_TYPE pm_orientation_search(const PMScan *ref, const PM_TYPE *new_r, const int *new_bad);
+    PM_TYPE pm_translation_estimation(const PMScan *ref, const PM_TYPE *new_r, const int *new_bad, PM_TYPE C, PM_TYPE *dx, PM_TYPE *dy);
+
     // minimizes least square error through changing lsa->rx, lsa->ry,lsa->th
     // this looks for angle too, like pm_linearized_match_proper,execept it
     // fits a parabola to the error when searching for the angle and interpolates.
@@ -40,6 +40,9 @@
 #include <sensor_msgs/Imu.h>
 #include <geometry_msgs/Pose2D.h>
 
+#include <scan_tools_common/shadow_filter.h>
+#include <scan_tools_common/temporal_filter.h>
+
 #include "polar_scan_matcher/polar_match.h"
 
 const std::string imuTopic_  = "imu";
@@ -86,12 +89,24 @@ class PSMNode
     int    maxIterations_;
     double stopCondition_;
 
+    bool filterShadows_;
+    scan_tools::ShadowFilter shadowFilter_;
+
+    bool filterTemporal_;
+    scan_tools::TemporalFilter temporalFilter_;
+
     std::string worldFrame_;
     std::string baseFrame_;
     std::string laserFrame_;
 
+    // geometry of the scans the matcher was initialized with
+    float laserAngleMin_;
+    float laserAngleMax_;
+    unsigned int laserPoints_;
+
     void getParams();
     bool initialize(const sensor_msgs::LaserScan& scan);
+    bool geometryChanged(const sensor_msgs::LaserScan& scan) const;
 
     void imuCallback (const sensor_msgs::Imu& imuMsg);
     void scanCallback (const sensor_msgs::LaserScan& scan);
@@ -62,7 +62,8 @@ TODO: change the time measurement approach; do a proper cleanup. have doxygen co
 
 using namespace std;
 
-PolarMatcher::PolarMatcher()
+PolarMatcher::PolarMatcher():
+  pm_fi(NULL), pm_si(NULL), pm_co(NULL)
 {
 
 }
@@ -71,20 +72,15 @@ PolarMatcher::PolarMatcher()
 */
 void PolarMatcher::pm_init()
 {
-  pm_fi.resize(PM_L_POINTS);
-  pm_si.resize(PM_L_POINTS);
-  pm_co.resize(PM_L_POINTS);
-
   PM_FI_MIN = M_PI/2.0 - PM_FOV*PM_D2R/2.0; 
   PM_FI_MAX = M_PI/2.0 + PM_FOV*PM_D2R/2.0; 
   PM_DFI    = PM_FOV*PM_D2R/ ( PM_L_POINTS + 1.0 );
 
-  for ( int i=0;i<PM_L_POINTS;i++ )
-  {
-    pm_fi[i] = ( ( float ) i ) *PM_DFI + PM_FI_MIN;
-    pm_si[i] = sin ( pm_fi[i] );
-    pm_co[i] = cos ( pm_fi[i] );
-  }
+  //the tables are only rebuilt if the geometry changed
+  scan_tools::ScanGeometryCache::update ( pm_geometry, PM_FI_MIN, PM_DFI, PM_L_POINTS );
+  pm_fi = pm_geometry->angles();
+  pm_si = pm_geometry->sin();
+  pm_co = pm_geometry->cos();
 }//pm_init
 
 //-------------------------------------------------------------------------
@@ -30,6 +30,8 @@
 
 #include "polar_scan_matcher/psm_node.h"
 
+#include <scan_tools_common/trace.h>
+
 int main (int argc, char** argv)
 {
   ros::init(argc, argv, "PolarScanMatching Node");
@@ -43,9 +45,12 @@ PSMNode::PSMNode()
 
   ros::NodeHandle nh;
 
+  scan_tools::Tracer::instance().advertise(nh);
+
   initialized_   = false;
   totalDuration_ = 0.0;
   scansCount_    = 0;
+  prevPMScan_    = NULL;
 
   prevWorldToBase_.setIdentity();
 
@@ -115,6 +120,43 @@ void PSMNode::getParams()
     maxIterations_ = 20;
   if (!nh_private.getParam ("stop_condition", stopCondition_))
     stopCondition_ = 0.01;
+
+  // **** shadow filter parameters
+  // veiling points are marked PM_MIXED, and not matched
+
+  double shadowMinAngle;
+  int shadowWindow;
+
+  if (!nh_private.getParam ("filter_shadows", filterShadows_))
+    filterShadows_ = false;
+  if (!nh_private.getParam ("shadow_min_angle", shadowMinAngle))
+    shadowMinAngle = 10.0 * M_PI / 180.0;
+  if (!nh_private.getParam ("shadow_window", shadowWindow))
+    shadowWindow = 2;
+
+  shadowFilter_.setMinAngle(shadowMinAngle);
+  shadowFilter_.setWindow(shadowWindow);
+
+  // **** temporal filter parameters
+  // returns that disagree with the last scans while the laser stands
+  // still are marked PM_MOVING, and not matched
+
+  int temporalHistory;
+  double temporalTolerance;
+  double temporalMaxOutlierFraction;
+
+  if (!nh_private.getParam ("filter_temporal", filterTemporal_))
+    filterTemporal_ = false;
+  if (!nh_private.getParam ("temporal_history", temporalHistory))
+    temporalHistory = 5;
+  if (!nh_private.getParam ("temporal_tolerance", temporalTolerance))
+    temporalTolerance = 0.1;
+  if (!nh_private.getParam ("temporal_max_outlier_fraction", temporalMaxOutlierFraction))
+    temporalMaxOutlierFraction = 0.2;
+
+  temporalFilter_.setHistory(temporalHistory);
+  temporalFilter_.setTolerance(temporalTolerance);
+  temporalFilter_.setMaxOutlierFraction(temporalMaxOutlierFraction);
 }
 
 bool PSMNode::initialize(const sensor_msgs::LaserScan& scan)
@@ -157,6 +199,10 @@ bool PSMNode::initialize(const sensor_msgs::LaserScan& scan)
 
   matcher_.pm_init();
 
+  laserAngleMin_ = scan.angle_min;
+  laserAngleMax_ = scan.angle_max;
+  laserPoints_   = scan.ranges.size();
+
   // **** get the initial worldToBase tf
 
   getCurrentEstimatedPose(prevWorldToBase_, scan);
@@ -165,12 +211,20 @@ bool PSMNode::initialize(const sensor_msgs::LaserScan& scan)
 
   tf::Transform t;
   t.setIdentity();
+  delete prevPMScan_;
   prevPMScan_ = new PMScan(scan.ranges.size());
   rosToPMScan(scan, t, prevPMScan_);
 
   return true;
 }
 
+bool PSMNode::geometryChanged(const sensor_msgs::LaserScan& scan) const
+{
+  return scan.ranges.size() != laserPoints_ ||
+         scan.angle_min != laserAngleMin_ ||
+         scan.angle_max != laserAngleMax_;
+}
+
 void PSMNode::imuCallback (const sensor_msgs::Imu& imuMsg)
 {
   imuMutex_.lock();
@@ -183,6 +237,8 @@ void PSMNode::imuCallback (const sensor_msgs::Imu& imuMsg)
 
 void PSMNode::scanCallback(const sensor_msgs::LaserScan& scan)
 {
+  SCAN_TOOLS_TRACE("PSMNode::scanCallback", scan.header.stamp, scan.header.frame_id);
+
   ROS_DEBUG("Received scan");
   scansCount_++;
 
@@ -197,6 +253,15 @@ void PSMNode::scanCallback(const sensor_msgs::LaserScan& scan)
     if (initialized_) ROS_INFO("Matcher initialized");
     return;
   }
+
+  // **** if the scan geometry changed, start over from this scan
+
+  if (geometryChanged(scan))
+  {
+    ROS_INFO("Scan geometry changed, re-initializing matcher");
+    initialized_ = initialize(scan);
+    return;
+  }
   
   // **** attmempt to match the two scans
 
@@ -331,6 +396,18 @@ void PSMNode::rosToPMScan(const sensor_msgs::LaserScan& scan,
     pmScan->bad[i] = 0;
   }
 
+  if (filterShadows_ && shadowFilter_.detect(scan) > 0)
+  {
+    for (int i = 0; i < scan.ranges.size(); ++i)
+      if (shadowFilter_.veiling(i)) pmScan->bad[i] |= PM_MIXED;
+  }
+
+  if (filterTemporal_ && temporalFilter_.detect(scan) > 0)
+  {
+    for (int i = 0; i < scan.ranges.size(); ++i)
+      if (temporalFilter_.outlier(i)) pmScan->bad[i] |= PM_MOVING;
+  }
+
   matcher_.pm_median_filter  (pmScan);
   matcher_.pm_find_far_points(pmScan);
   matcher_.pm_segment_scan   (pmScan);  
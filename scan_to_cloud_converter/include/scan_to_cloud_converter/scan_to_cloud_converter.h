@@ -36,13 +36,19 @@
 #include <pcl/point_types.h>
 #include <pcl/point_cloud.h>
 #include <pcl_ros/point_cloud.h>
+#include <scan_tools_common/laser_scan_view.h>
+#include <scan_tools_common/scan_geometry.h>
+#include <scan_tools_common/shm_scan_ring.h>
+#include <scan_tools_common/voxel_hash.h>
 
 namespace scan_tools {
 
 class ScanToCloudConverter
 {
-  typedef pcl::PointXYZ           PointT;
-  typedef pcl::PointCloud<PointT> PointCloudT;
+  public:
+
+    typedef pcl::PointXYZ           PointT;
+    typedef pcl::PointCloud<PointT> PointCloudT;
 
   private:
 
@@ -52,14 +58,44 @@ class ScanToCloudConverter
     ros::Publisher cloud_publisher_;
     ros::Subscriber scan_subscriber_;
 
-    PointT invalid_point_;
+    bool use_shm_input_;
+    double leaf_size_;          // 0 for one point per beam
+
+    ScanGeometryPtr geometry_;  // sin and cos of the beam angles, shared
+    ShmScanReader shm_reader_;
+    VoxelHash2D voxels_;        // reused from scan to scan
 
     void scanCallback(const sensor_msgs::LaserScan::ConstPtr& scan_msg);
+    void shmScanCallback(const scan_tools_common::ShmScanRef::ConstPtr& ref);
+
+    PointCloudT::Ptr convert(const LaserScanView& scan_view);
  
  public:
 
     ScanToCloudConverter(ros::NodeHandle nh, ros::NodeHandle nh_private);
     ~ScanToCloudConverter();
+
+    // Converts every beam of scan_msg into a point of an organized cloud,
+    // NaN for out of range beams; geometry must match the scan
+    static void convertScan(const sensor_msgs::LaserScan& scan_msg,
+                            const ScanGeometry& geometry,
+                            PointCloudT& cloud);
+    static void convertScan(const LaserScanView& scan_view,
+                            const ScanGeometry& geometry,
+                            PointCloudT& cloud);
+
+    // Converts only the valid beams of scan_view, in beam order, into a
+    // dense cloud; geometry must match the scan
+    static void convertValidBeams(const LaserScanView& scan_view,
+                                  const ScanGeometry& geometry,
+                                  PointCloudT& cloud);
+
+    // Converts the valid beams of scan_view into a dense cloud of one
+    // point per occupied cell of voxels, which is cleared first
+    static void downsampleScan(const LaserScanView& scan_view,
+                               const ScanGeometry& geometry,
+                               VoxelHash2D& voxels,
+                               PointCloudT& cloud);
 };
 
 } // namespace scan_tools
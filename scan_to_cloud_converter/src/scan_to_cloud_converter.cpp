@@ -30,6 +30,7 @@
 #include "scan_to_cloud_converter/scan_to_cloud_converter.h"
 
 #include <pcl_conversions/pcl_conversions.h>
+#include <scan_tools_common/trace.h>
 
 namespace scan_tools {
 
@@ -39,14 +40,41 @@ ScanToCloudConverter::ScanToCloudConverter(ros::NodeHandle nh, ros::NodeHandle n
 {
   ROS_INFO("Starting ScanToCloudConverter");
 
-  invalid_point_.x = std::numeric_limits<float>::quiet_NaN();
-  invalid_point_.y = std::numeric_limits<float>::quiet_NaN();
-  invalid_point_.z = std::numeric_limits<float>::quiet_NaN();
+  Tracer::instance().advertise(nh_);
+
+  // if true, reads the scans in place from the shared memory ring of a
+  // laser_scan_shm_writer, announced on scan_shm
+  if (!nh_private_.getParam("use_shm_input", use_shm_input_))
+    use_shm_input_ = false;
+
+  // if > 0, downsamples the cloud to one point per square cell of that
+  // size, the centroid or the nearest point to the cell center
+  std::string downsample_mode;
+  if (!nh_private_.getParam("leaf_size", leaf_size_))
+    leaf_size_ = 0.0;
+  if (!nh_private_.getParam("downsample_mode", downsample_mode))
+    downsample_mode = "centroid";
+
+  ROS_ASSERT_MSG(leaf_size_ <= 0.0 || leaf_size_ >= 0.001,
+    "leaf_size parameter must be 0 or at least 0.001 m, is %f", leaf_size_);
+  ROS_ASSERT_MSG(downsample_mode == "centroid" || downsample_mode == "nearest",
+    "downsample_mode parameter must be centroid or nearest, is %s", downsample_mode.c_str());
+
+  if (leaf_size_ > 0.0)
+  {
+    voxels_.setLeafSize(leaf_size_);
+    voxels_.setMode(downsample_mode == "nearest" ? VoxelHash2D::NEAREST : VoxelHash2D::CENTROID);
+  }
 
   cloud_publisher_ = nh_.advertise<PointCloudT>(
     "cloud", 1); 
-  scan_subscriber_ = nh_.subscribe(
-    "scan", 1, &ScanToCloudConverter::scanCallback, this);
+
+  if (use_shm_input_)
+    scan_subscriber_ = nh_.subscribe(
+      "scan_shm", 1, &ScanToCloudConverter::shmScanCallback, this);
+  else
+    scan_subscriber_ = nh_.subscribe(
+      "scan", 1, &ScanToCloudConverter::scanCallback, this);
 }
 
 ScanToCloudConverter::~ScanToCloudConverter()
@@ -55,34 +83,152 @@ ScanToCloudConverter::~ScanToCloudConverter()
 }
 
 void ScanToCloudConverter::scanCallback(const sensor_msgs::LaserScan::ConstPtr& scan_msg)
+{
+  SCAN_TOOLS_TRACE("ScanToCloudConverter::scanCallback", scan_msg->header.stamp, scan_msg->header.frame_id);
+
+  cloud_publisher_.publish(convert(LaserScanView(*scan_msg)));
+}
+
+void ScanToCloudConverter::shmScanCallback(const scan_tools_common::ShmScanRef::ConstPtr& ref)
+{
+  SCAN_TOOLS_TRACE("ScanToCloudConverter::shmScanCallback", ref->header.stamp, ref->header.frame_id);
+
+  LaserScanView scan_view;
+  if (!shm_reader_.read(*ref, scan_view))
+  {
+    ROS_WARN_THROTTLE(1.0, "Skipping scan, it is not in shared memory segment %s (anymore)",
+      ref->segment.c_str());
+    return;
+  }
+
+  PointCloudT::Ptr cloud_msg = convert(scan_view);
+
+  // the writer may have reused the slot while it was read
+  if (!shm_reader_.valid(*ref))
+  {
+    ROS_WARN_THROTTLE(1.0, "Skipping scan, it was overwritten in shared memory while being read");
+    return;
+  }
+
+  cloud_publisher_.publish(cloud_msg);
+}
+
+ScanToCloudConverter::PointCloudT::Ptr ScanToCloudConverter::convert(const LaserScanView& scan_view)
 {
   PointCloudT::Ptr cloud_msg =
     boost::shared_ptr<PointCloudT>(new PointCloudT());
 
-  cloud_msg->points.resize(scan_msg->ranges.size());
+  ScanGeometryCache::update(geometry_, scan_view.angle_min,
+                            scan_view.angle_increment, scan_view.size);
+
+  if (leaf_size_ > 0.0)
+    downsampleScan(scan_view, *geometry_, voxels_, *cloud_msg);
+  else
+    convertScan(scan_view, *geometry_, *cloud_msg);
+  pcl_conversions::toPCL(*scan_view.header, cloud_msg->header);
+
+  return cloud_msg;
+}
+
+void ScanToCloudConverter::convertScan(const sensor_msgs::LaserScan& scan_msg,
+                                       const ScanGeometry& geometry,
+                                       PointCloudT& cloud)
+{
+  convertScan(LaserScanView(scan_msg), geometry, cloud);
+}
 
-  for (unsigned int i = 0; i < scan_msg->ranges.size(); ++i)
+void ScanToCloudConverter::convertScan(const LaserScanView& scan_view,
+                                       const ScanGeometry& geometry,
+                                       PointCloudT& cloud)
+{
+  PointT invalid_point;
+  invalid_point.x = std::numeric_limits<float>::quiet_NaN();
+  invalid_point.y = std::numeric_limits<float>::quiet_NaN();
+  invalid_point.z = std::numeric_limits<float>::quiet_NaN();
+
+  const float* a_cos = geometry.cosFloat();
+  const float* a_sin = geometry.sinFloat();
+
+  cloud.points.resize(scan_view.size);
+
+  for (unsigned int i = 0; i < scan_view.size; ++i)
   {
-    PointT& p = cloud_msg->points[i];
-    float range = scan_msg->ranges[i];
-    if (range > scan_msg->range_min && range < scan_msg->range_max)
+    PointT& p = cloud.points[i];
+    float range = scan_view.ranges[i];
+    if (range > scan_view.range_min && range < scan_view.range_max)
     {
-      float angle = scan_msg->angle_min + i*scan_msg->angle_increment;
-
-      p.x = range * cos(angle);
-      p.y = range * sin(angle);
+      p.x = range * a_cos[i];
+      p.y = range * a_sin[i];
       p.z = 0.0;
     }
     else
-      p = invalid_point_;
+      p = invalid_point;
   }
 
-  cloud_msg->width = scan_msg->ranges.size();
-  cloud_msg->height = 1;
-  cloud_msg->is_dense = false; //contains nans
-  pcl_conversions::toPCL(scan_msg->header, cloud_msg->header);
+  cloud.width = scan_view.size;
+  cloud.height = 1;
+  cloud.is_dense = false; //contains nans
+}
 
-  cloud_publisher_.publish(cloud_msg);
+void ScanToCloudConverter::convertValidBeams(const LaserScanView& scan_view,
+                                             const ScanGeometry& geometry,
+                                             PointCloudT& cloud)
+{
+  const float* a_cos = geometry.cosFloat();
+  const float* a_sin = geometry.sinFloat();
+
+  cloud.points.clear();
+  cloud.points.reserve(scan_view.size);
+
+  PointT p;
+  p.z = 0.0;
+
+  for (unsigned int i = 0; i < scan_view.size; ++i)
+  {
+    float range = scan_view.ranges[i];
+    if (range > scan_view.range_min && range < scan_view.range_max)
+    {
+      p.x = range * a_cos[i];
+      p.y = range * a_sin[i];
+      cloud.points.push_back(p);
+    }
+  }
+
+  cloud.width = cloud.points.size();
+  cloud.height = 1;
+  cloud.is_dense = true;
+}
+
+void ScanToCloudConverter::downsampleScan(const LaserScanView& scan_view,
+                                          const ScanGeometry& geometry,
+                                          VoxelHash2D& voxels,
+                                          PointCloudT& cloud)
+{
+  const float* a_cos = geometry.cosFloat();
+  const float* a_sin = geometry.sinFloat();
+
+  voxels.clear();
+  voxels.reserve(scan_view.size);
+
+  for (unsigned int i = 0; i < scan_view.size; ++i)
+  {
+    float range = scan_view.ranges[i];
+    if (range > scan_view.range_min && range < scan_view.range_max)
+      voxels.add(range * a_cos[i], range * a_sin[i]);
+  }
+
+  cloud.points.resize(voxels.size());
+
+  for (unsigned int i = 0; i < voxels.size(); ++i)
+  {
+    PointT& p = cloud.points[i];
+    voxels.point(i, p.x, p.y);
+    p.z = 0.0;
+  }
+
+  cloud.width = cloud.points.size();
+  cloud.height = 1;
+  cloud.is_dense = true;
 }
 
 } //namespace scan_tools
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_BENCHMARKS_SCAN_SIMULATOR_H
+#define SCAN_TOOLS_BENCHMARKS_SCAN_SIMULATOR_H
+
+#include <vector>
+#include <stdint.h>
+#include <sensor_msgs/LaserScan.h>
+
+namespace scan_tools
+{
+
+struct SimPose
+{
+  SimPose(double x_ = 0.0, double y_ = 0.0, double theta_ = 0.0):
+    x(x_), y(y_), theta(theta_) { }
+
+  double x;
+  double y;
+  double theta;
+};
+
+/**
+ * A 2D world made of line segments, each with its own reflectivity.
+ *
+ * Segments are stored as structure of arrays so the ray casting loop
+ * over all segments of a beam vectorizes.
+ */
+class SimWorld
+{
+  public:
+
+    void addSegment(double x1, double y1, double x2, double y2, float intensity = 1000.0);
+
+    // Adds the edges of a polygon; closed polygons get the last edge too
+    void addPolygon(const std::vector<SimPose>& vertices, bool closed = true,
+                    float intensity = 1000.0);
+
+    // Adds an axis aligned box centered at (cx, cy)
+    void addBox(double cx, double cy, double width, double height,
+                float intensity = 1000.0);
+
+    unsigned int size() const { return x_.size(); }
+
+    // **** predefined environments
+
+    // A straight corridor along x, with doors every few meters
+    static SimWorld corridor(double length = 50.0, double width = 2.0);
+
+    // A large hall with a few pillars, mostly out of range
+    static SimWorld open(double size = 60.0);
+
+    // A room full of randomly placed boxes, generated from seed
+    static SimWorld cluttered(double size = 20.0, int obstacles = 60,
+                              uint64_t seed = 1);
+
+    /**
+     * Ray casts from pose along the beams given by the cosine and sine of
+     * their angles (relative to the pose heading).
+     *
+     * @param[out] ranges       Distance to the closest segment, or a negative
+     *                          value if no segment is hit.
+     * @param[out] incidence    Cosine of the incidence angle of each hit, or 0.
+     * @param[out] intensities  Intensity of the segment hit, or 0.
+     */
+    void castRays(const SimPose& pose, unsigned int n,
+                  const float* a_cos, const float* a_sin,
+                  float* ranges, float* incidence, float* intensities) const;
+
+  private:
+
+    std::vector<float> x_;   // segment start
+    std::vector<float> y_;
+    std::vector<float> ex_;  // segment direction, end - start
+    std::vector<float> ey_;
+    std::vector<float> intensity_;
+};
+
+/**
+ * A trajectory through a sequence of waypoints, driven at a constant
+ * linear speed. The heading is interpolated between waypoints.
+ */
+class SimTrajectory
+{
+  public:
+
+    SimTrajectory(const std::vector<SimPose>& waypoints, double speed);
+
+    double duration() const { return times_.empty() ? 0.0 : times_.back(); }
+
+    SimPose poseAt(double t) const;
+
+  private:
+
+    std::vector<SimPose> waypoints_;
+    std::vector<double> times_;   // time at which each waypoint is reached
+};
+
+struct SimScanConfig
+{
+  SimScanConfig();
+
+  double fov;              // [rad], centered on the heading
+  int beams;
+  double range_min;        // [m]
+  double range_max;        // [m], beyond it the range is set to range_max + 1
+  double rate;             // [Hz]
+  double noise_stddev;     // [m], gaussian range noise
+  double dropout_prob;     // probability of a 0 range reading
+  bool intensities;        // fill in the intensities
+  double intensity_noise;  // relative gaussian intensity noise
+  uint64_t seed;           // base seed, every scan gets its own seed from it
+  std::string frame_id;
+};
+
+/**
+ * Simulates LaserScan messages in a SimWorld.
+ *
+ * Every scan is a deterministic function of the world, the config, the
+ * pose and the scan index: the noise of scan i is drawn from a generator
+ * seeded from (seed, i). Results are therefore identical regardless of
+ * the number of threads used.
+ */
+class ScanSimulator
+{
+  public:
+
+    ScanSimulator(const SimWorld& world, const SimScanConfig& config);
+
+    const SimScanConfig& config() const { return config_; }
+
+    // Simulates the index-th scan, taken at pose
+    void simulate(const SimPose& pose, uint64_t index,
+                  sensor_msgs::LaserScan& scan) const;
+
+    /**
+     * Simulates all scans along the trajectory, at the configured rate.
+     *
+     * @param[out] scans    The simulated scans, stamped from t = 0.
+     * @param[out] poses    The ground truth pose of each scan.
+     * @param[in]  threads  Number of threads, 0 for all cores.
+     */
+    void simulate(const SimTrajectory& trajectory,
+                  std::vector<sensor_msgs::LaserScan>& scans,
+                  std::vector<SimPose>& poses,
+                  unsigned int threads = 0) const;
+
+  private:
+
+    SimWorld world_;
+    SimScanConfig config_;
+
+    std::vector<float> a_cos_;
+    std::vector<float> a_sin_;
+};
+
+} // namespace scan_tools
+
+#endif // SCAN_TOOLS_BENCHMARKS_SCAN_SIMULATOR_H
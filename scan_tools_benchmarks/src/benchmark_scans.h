@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_BENCHMARKS_BENCHMARK_SCANS_H
+#define SCAN_TOOLS_BENCHMARKS_BENCHMARK_SCANS_H
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <sensor_msgs/LaserScan.h>
+#include <sensor_msgs/PointCloud2.h>
+
+namespace scan_tools
+{
+
+// Beam counts of common scanners: 1 deg, 0.5 deg and 0.25 deg over
+// 180/270 deg, and a 0.125 deg full circle
+inline void BeamCounts(benchmark::internal::Benchmark* b)
+{
+  b->Arg(181)->Arg(541)->Arg(1081)->Arg(2880);
+}
+
+// Field of view used for a given beam count, in radians
+inline double benchmarkFov(int n)
+{
+  if (n == 181) return M_PI;
+  if (n == 2880) return 2.0 * M_PI * (n - 1) / n;
+  return 1.5 * M_PI;
+}
+
+// Range from (px, py) along angle a to the walls of a 10 x 7 m room
+inline double roomRange(double px, double py, double a)
+{
+  const double x_min = -5.0, x_max = 5.0, y_min = -3.0, y_max = 4.0;
+  double c = cos(a), s = sin(a);
+  double r = 1e9;
+  if (c >  1e-9) r = std::min(r, (x_max - px) / c);
+  if (c < -1e-9) r = std::min(r, (x_min - px) / c);
+  if (s >  1e-9) r = std::min(r, (y_max - py) / s);
+  if (s < -1e-9) r = std::min(r, (y_min - py) / s);
+  return r;
+}
+
+/**
+ * A scan of n beams taken at (px, py, pa) in a rectangular room, with a
+ * few invalid readings so that the validity checks are exercised.
+ */
+inline void makeRoomScan(int n, sensor_msgs::LaserScan& scan,
+                         double px = 0.3, double py = -0.2, double pa = 0.0)
+{
+  double fov = benchmarkFov(n);
+
+  scan.header.frame_id = "laser";
+  scan.angle_min = -fov / 2.0;
+  scan.angle_increment = fov / (n - 1);
+  scan.angle_max = scan.angle_min + scan.angle_increment * (n - 1);
+  scan.range_min = 0.05;
+  scan.range_max = 30.0;
+  scan.ranges.resize(n);
+  scan.intensities.resize(n);
+
+  for (int i = 0; i < n; ++i)
+  {
+    double a = scan.angle_min + i * scan.angle_increment;
+    scan.ranges[i] = roomRange(px, py, a + pa);
+    scan.intensities[i] = 1000.0;
+    if (i % 97 == 0) scan.ranges[i] = 0.0;  // dropouts
+  }
+}
+
+/**
+ * An organized 3D cloud (x, y, z, ring as float32/uint16) of the same
+ * room, with n points per ring.
+ */
+inline void makeRoomCloud(int n, int rings, sensor_msgs::PointCloud2& cloud)
+{
+  const char* names[3] = { "x", "y", "z" };
+  cloud.fields.resize(4);
+  for (int f = 0; f < 3; ++f)
+  {
+    cloud.fields[f].name = names[f];
+    cloud.fields[f].offset = 4 * f;
+    cloud.fields[f].datatype = sensor_msgs::PointField::FLOAT32;
+    cloud.fields[f].count = 1;
+  }
+  cloud.fields[3].name = "ring";
+  cloud.fields[3].offset = 12;
+  cloud.fields[3].datatype = sensor_msgs::PointField::UINT16;
+  cloud.fields[3].count = 1;
+
+  cloud.header.frame_id = "laser";
+  cloud.height = rings;
+  cloud.width = n;
+  cloud.point_step = 16;
+  cloud.row_step = cloud.point_step * n;
+  cloud.is_bigendian = false;
+  cloud.is_dense = true;
+  cloud.data.resize(cloud.row_step * rings);
+
+  for (int ring = 0; ring < rings; ++ring)
+  {
+    double elevation = (ring - rings / 2) * 2.0 * M_PI / 180.0;
+    for (int i = 0; i < n; ++i)
+    {
+      double a = -M_PI + i * 2.0 * M_PI / n;
+      double r = roomRange(0.3, -0.2, a);
+      float p[3] = { (float)(r * cos(a)), (float)(r * sin(a)), (float)(r * tan(elevation)) };
+      uint16_t ring_id = ring;
+
+      uint8_t* point = &cloud.data[ring * cloud.row_step + i * cloud.point_step];
+      memcpy(point, p, sizeof(p));
+      memcpy(point + 12, &ring_id, sizeof(ring_id));
+    }
+  }
+}
+
+} // namespace scan_tools
+
+#endif // SCAN_TOOLS_BENCHMARKS_BENCHMARK_SCANS_H
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <laser_scan_matcher/compact_scan.h>
+#include <laser_scan_matcher/scan_conversion.h>
+
+#include "benchmark_scans.h"
+
+namespace scan_tools
+{
+
+// LaserScan to LDP, as done by the scan matcher for every scan: range
+// validation into a CompactScan, then materialization of the LDP
+static void BM_LaserScanToLDP(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg;
+  makeRoomScan(state.range(0), scan_msg);
+
+  CompactScan scan;
+
+  for (auto _ : state)
+  {
+    laserScanToCompactScan(scan_msg, scan);
+    benchmark::DoNotOptimize(scan.ldp());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LaserScanToLDP)->Apply(BeamCounts);
+
+// PointCloud2 to LDP from a single ring cloud, points in cloud order
+static void BM_PointCloudToLDP(benchmark::State& state)
+{
+  sensor_msgs::PointCloud2 cloud;
+  makeRoomCloud(state.range(0), 1, cloud);
+
+  CloudSliceParams params;
+  params.res = 0.0;
+  CloudSlicer slicer;
+  CompactScan scan;
+
+  for (auto _ : state)
+  {
+    slicer.slice(cloud, params, scan);
+    benchmark::DoNotOptimize(scan.ldp());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PointCloudToLDP)->Apply(BeamCounts);
+
+// PointCloud2 to LDP from a 16 ring cloud: one ring selected and binned
+static void BM_PointCloudToLDPRingBinned(benchmark::State& state)
+{
+  const int rings = 16;
+  sensor_msgs::PointCloud2 cloud;
+  makeRoomCloud(state.range(0), rings, cloud);
+
+  CloudSliceParams params;
+  params.ring = rings / 2;
+  params.angle_increment = 2.0 * M_PI / state.range(0);
+  CloudSlicer slicer;
+  CompactScan scan;
+
+  for (auto _ : state)
+  {
+    slicer.slice(cloud, params, scan);
+    benchmark::DoNotOptimize(scan.ldp());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) * rings);
+}
+BENCHMARK(BM_PointCloudToLDPRingBinned)->Apply(BeamCounts);
+
+} // namespace scan_tools
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <limits>
+
+#include <tf/transform_datatypes.h>
+#include <scan_tools_common/scan_binning.h>
+
+#include "benchmark_scans.h"
+
+namespace scan_tools
+{
+
+// Merges 2 to 4 lasers of 1081 beams (front, rear, left, right of the
+// base) into a 0.25 deg virtual scan, as the merger does per scan set
+static void BM_MergeScans(benchmark::State& state)
+{
+  const int n = 1081;
+  const double poses[4][3] = {
+    { 0.3,  0.0,  0.0},
+    {-0.3,  0.0,  M_PI},
+    { 0.0,  0.2,  M_PI / 2.0},
+    { 0.0, -0.2, -M_PI / 2.0}};
+
+  int inputs = state.range(0);
+
+  std::vector<sensor_msgs::LaserScan> scans(inputs);
+  std::vector<PlanarProjection> projection(inputs);
+  std::vector<ScanGeometryPtr> geometry(inputs);
+
+  for (int i = 0; i < inputs; ++i)
+  {
+    makeRoomScan(n, scans[i], poses[i][0], poses[i][1], poses[i][2]);
+    projection[i] = planarProjection(tf::Transform(
+      tf::createQuaternionFromYaw(poses[i][2]), tf::Vector3(poses[i][0], poses[i][1], 0.0)));
+    geometry[i] = ScanGeometryCache::get(
+      scans[i].angle_min, scans[i].angle_increment, scans[i].ranges.size());
+  }
+
+  sensor_msgs::LaserScan merged;
+  merged.angle_min       = -M_PI;
+  merged.angle_increment = M_PI / 720.0;
+  merged.angle_max       = M_PI;
+  merged.range_min       = 0.0;
+  merged.range_max       = 30.0;
+
+  ScanBinningBuffers buffers;
+
+  for (auto _ : state)
+  {
+    merged.ranges.assign(1441, std::numeric_limits<float>::infinity());
+    merged.intensities.assign(1441, 0.0);
+
+    for (int i = 0; i < inputs; ++i)
+      binScan(scans[i], projection[i], *geometry[i], merged, buffers);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * inputs * n);
+}
+BENCHMARK(BM_MergeScans)->DenseRange(2, 4);
+
+} // namespace scan_tools
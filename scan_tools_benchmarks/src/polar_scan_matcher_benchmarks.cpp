@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <polar_scan_matcher/polar_match.h>
+
+#include "benchmark_scans.h"
+
+namespace scan_tools
+{
+
+static const double ROS_TO_PM = 100.0;   // convert from cm to m
+
+// Sets up the matcher like PSMNode does for a scan of n beams
+static void initMatcher(PolarMatcher& matcher, const sensor_msgs::LaserScan& scan)
+{
+  matcher.PM_L_POINTS         = scan.ranges.size();
+  matcher.PM_FOV              = (scan.angle_max - scan.angle_min) * 180.0 / M_PI;
+  matcher.PM_MAX_RANGE        = scan.range_max * ROS_TO_PM;
+  matcher.PM_TIME_DELAY       = 0.00;
+  matcher.PM_MIN_VALID_POINTS = 40;
+  matcher.PM_SEARCH_WINDOW    = 40;
+  matcher.PM_MAX_ERROR        = 0.2 * ROS_TO_PM;
+  matcher.PM_MAX_ITER         = 10;
+  matcher.PM_MAX_ITER_ICP     = 10;
+  matcher.PM_STOP_COND        = 0.01 * ROS_TO_PM;
+  matcher.PM_STOP_COND_ICP    = 0.01 * ROS_TO_PM;
+  matcher.pm_init();
+}
+
+// Same conversion as PSMNode::rosToPMScan
+static void toPMScan(PolarMatcher& matcher, const sensor_msgs::LaserScan& scan,
+                     double rx, double ry, double th, PMScan& pm_scan)
+{
+  pm_scan.rx = rx * ROS_TO_PM;
+  pm_scan.ry = ry * ROS_TO_PM;
+  pm_scan.th = th;
+
+  for (unsigned int i = 0; i < scan.ranges.size(); ++i)
+  {
+    if (scan.ranges[i] == 0)
+      pm_scan.r[i] = 99999;
+    else
+      pm_scan.r[i] = scan.ranges[i] * ROS_TO_PM;
+    pm_scan.x[i] = pm_scan.r[i] * matcher.pm_co[i];
+    pm_scan.y[i] = pm_scan.r[i] * matcher.pm_si[i];
+    pm_scan.bad[i] = 0;
+  }
+
+  matcher.pm_median_filter  (&pm_scan);
+  matcher.pm_find_far_points(&pm_scan);
+  matcher.pm_segment_scan   (&pm_scan);
+}
+
+// A reference scan and an active scan, displaced by a few cm and deg
+struct PSMFixture
+{
+  PSMFixture(int n): ref(n), act(n), new_r(n), new_bad(n)
+  {
+    sensor_msgs::LaserScan ref_msg, act_msg;
+    makeRoomScan(n, ref_msg, 0.3, -0.2, 0.0);
+    makeRoomScan(n, act_msg, 0.35, -0.17, 0.03);
+
+    initMatcher(matcher, ref_msg);
+    toPMScan(matcher, ref_msg, 0.0, 0.0, 0.0, ref);
+    toPMScan(matcher, act_msg, 0.0, 0.0, 0.0, act);
+
+    matcher.pm_scan_project(&act, &new_r[0], &new_bad[0]);
+  }
+
+  PolarMatcher matcher;
+  PMScan ref;
+  PMScan act;
+  std::vector<PM_TYPE> new_r;
+  std::vector<int> new_bad;
+};
+
+static void BM_PMScanProject(benchmark::State& state)
+{
+  PSMFixture f(state.range(0));
+
+  for (auto _ : state)
+  {
+    f.matcher.pm_scan_project(&f.act, &f.new_r[0], &f.new_bad[0]);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PMScanProject)->Apply(BeamCounts);
+
+static void BM_PMOrientationSearch(benchmark::State& state)
+{
+  PSMFixture f(state.range(0));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(
+      f.matcher.pm_orientation_search(&f.ref, &f.new_r[0], &f.new_bad[0]));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PMOrientationSearch)->Apply(BeamCounts);
+
+static void BM_PMTranslationEstimation(benchmark::State& state)
+{
+  PSMFixture f(state.range(0));
+  PM_TYPE dx, dy;
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(
+      f.matcher.pm_translation_estimation(&f.ref, &f.new_r[0], &f.new_bad[0], 70*70, &dx, &dy));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PMTranslationEstimation)->Apply(BeamCounts);
+
+static void BM_PMMedianFilter(benchmark::State& state)
+{
+  PSMFixture f(state.range(0));
+  PMScan scan(state.range(0));
+
+  for (auto _ : state)
+  {
+    scan.r = f.act.r;
+    f.matcher.pm_median_filter(&scan);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PMMedianFilter)->Apply(BeamCounts);
+
+} // namespace scan_tools
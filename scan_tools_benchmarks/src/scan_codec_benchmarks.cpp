@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <scan_tools_common/scan_codec.h>
+
+#include "benchmark_scans.h"
+
+namespace scan_tools
+{
+
+// Float ranges and intensities against their compressed size
+static void setCompressionRatio(benchmark::State& state,
+                                const sensor_msgs::LaserScan& scan_msg,
+                                const scan_tools_common::CompressedLaserScan& compressed)
+{
+  double raw_size = (scan_msg.ranges.size() + scan_msg.intensities.size()) * sizeof(float);
+  double compressed_size = compressed.ranges.size() + compressed.intensities.size();
+
+  state.counters["ratio"] = raw_size / compressed_size;
+  state.counters["range_bits_per_beam"] = 8.0 * compressed.ranges.size() / scan_msg.ranges.size();
+}
+
+static void BM_CompressScan(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg;
+  makeRoomScan(state.range(0), scan_msg);
+
+  scan_tools_common::CompressedLaserScan compressed;
+
+  for (auto _ : state)
+  {
+    compressScan(scan_msg, 0.001, compressed);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  setCompressionRatio(state, scan_msg, compressed);
+}
+BENCHMARK(BM_CompressScan)->Apply(BeamCounts);
+
+static void BM_DecompressScan(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg, scan_decoded;
+  makeRoomScan(state.range(0), scan_msg);
+
+  scan_tools_common::CompressedLaserScan compressed;
+  compressScan(scan_msg, 0.001, compressed);
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(decompressScan(compressed, scan_decoded));
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  setCompressionRatio(state, scan_msg, compressed);
+}
+BENCHMARK(BM_DecompressScan)->Apply(BeamCounts);
+
+} // namespace scan_tools
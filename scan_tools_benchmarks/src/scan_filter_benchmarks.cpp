@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <limits>
+
+#include <laser_ortho_projector/laser_ortho_projector.h>
+#include <laser_scan_sparsifier/laser_scan_sparsifier.h>
+#include <laser_scan_splitter/laser_scan_splitter.h>
+#include <scan_tools_common/scan_binning.h>
+#include <scan_tools_common/scan_change.h>
+#include <scan_tools_common/scan_geometry.h>
+#include <scan_tools_common/scan_mask.h>
+#include <scan_tools_common/shadow_filter.h>
+#include <scan_tools_common/temporal_filter.h>
+
+#include "benchmark_scans.h"
+
+namespace scan_tools
+{
+
+static void BM_OrthoProjection(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg;
+  makeRoomScan(state.range(0), scan_msg);
+
+  ScanGeometryPtr geometry = ScanGeometryCache::get(
+    scan_msg.angle_min, scan_msg.angle_increment, scan_msg.ranges.size());
+
+  // laser tilted by a few degrees
+  tf::Transform ortho_to_laser;
+  ortho_to_laser.setOrigin(tf::Vector3(0.1, 0.0, 0.3));
+  ortho_to_laser.setRotation(tf::createQuaternionFromRPY(0.05, -0.03, 0.0));
+
+  LaserOrthoProjector::PointCloudT cloud;
+
+  for (auto _ : state)
+  {
+    LaserOrthoProjector::projectScan(scan_msg, ortho_to_laser, *geometry, cloud);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OrthoProjection)->Apply(BeamCounts);
+
+// The same projection, binned into a 0.25 deg LaserScan instead of a cloud
+static void BM_OrthoProjectionToScan(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg;
+  makeRoomScan(state.range(0), scan_msg);
+
+  ScanGeometryPtr geometry = ScanGeometryCache::get(
+    scan_msg.angle_min, scan_msg.angle_increment, scan_msg.ranges.size());
+
+  tf::Transform ortho_to_laser;
+  ortho_to_laser.setOrigin(tf::Vector3(0.1, 0.0, 0.3));
+  ortho_to_laser.setRotation(tf::createQuaternionFromRPY(0.05, -0.03, 0.0));
+
+  sensor_msgs::LaserScan scan_ortho;
+  scan_ortho.angle_min       = -M_PI;
+  scan_ortho.angle_increment = M_PI / 720.0;
+  scan_ortho.angle_max       = M_PI;
+  scan_ortho.range_min       = 0.0;
+  scan_ortho.range_max       = scan_msg.range_max;
+
+  ScanBinningBuffers buffers;
+
+  for (auto _ : state)
+  {
+    scan_ortho.ranges.assign(1441, std::numeric_limits<float>::infinity());
+    binScan(scan_msg, planarProjection(ortho_to_laser), *geometry, scan_ortho, buffers);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OrthoProjectionToScan)->Apply(BeamCounts);
+
+// Per scan geometry check of a node, with the geometry unchanged
+static void BM_ScanGeometryUpdate(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg;
+  makeRoomScan(state.range(0), scan_msg);
+
+  ScanGeometryPtr geometry;
+
+  for (auto _ : state)
+  {
+    ScanGeometryCache::update(geometry, scan_msg.angle_min,
+                              scan_msg.angle_increment, scan_msg.ranges.size());
+    benchmark::DoNotOptimize(geometry.get());
+  }
+}
+BENCHMARK(BM_ScanGeometryUpdate)->Apply(BeamCounts);
+
+// Building the tables of a new geometry, as on the first scan
+static void BM_ScanGeometryBuild(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg;
+  makeRoomScan(state.range(0), scan_msg);
+
+  for (auto _ : state)
+  {
+    ScanGeometry geometry(scan_msg.angle_min, scan_msg.angle_increment,
+                          scan_msg.ranges.size());
+    benchmark::DoNotOptimize(geometry.cos());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ScanGeometryBuild)->Apply(BeamCounts);
+
+static void BM_Sparsify(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg, scan_sparse;
+  makeRoomScan(state.range(0), scan_msg);
+
+  for (auto _ : state)
+  {
+    LaserScanSparsifier::sparsifyScan(scan_msg, 2, scan_sparse);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Sparsify)->Apply(BeamCounts);
+
+// levels 2, 4 and 8 of the sparsifier's ~levels, each reduced from the
+// one before, against each reduced from the full scan as separate
+// sparsifiers would (and these also receive and copy the full scan)
+static void BM_SparsifyPyramid(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg, scan_2, scan_4, scan_8;
+  makeRoomScan(state.range(0), scan_msg);
+
+  LaserScanSparsifier::Reduction reduction =
+    state.range(1) ? LaserScanSparsifier::MIN : LaserScanSparsifier::STRIDE;
+
+  for (auto _ : state)
+  {
+    LaserScanSparsifier::sparsifyScan(scan_msg, 2, scan_2, reduction);
+    LaserScanSparsifier::sparsifyScan(scan_2, 2, scan_4, reduction);
+    LaserScanSparsifier::sparsifyScan(scan_4, 2, scan_8, reduction);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SparsifyPyramid)->ArgsProduct({{1081, 2880}, {0, 1}});
+
+static void BM_SparsifyLevelsSeparately(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg, scan_2, scan_4, scan_8;
+  makeRoomScan(state.range(0), scan_msg);
+
+  LaserScanSparsifier::Reduction reduction =
+    state.range(1) ? LaserScanSparsifier::MIN : LaserScanSparsifier::STRIDE;
+
+  for (auto _ : state)
+  {
+    LaserScanSparsifier::sparsifyScan(scan_msg, 2, scan_2, reduction);
+    LaserScanSparsifier::sparsifyScan(scan_msg, 4, scan_4, reduction);
+    LaserScanSparsifier::sparsifyScan(scan_msg, 8, scan_8, reduction);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SparsifyLevelsSeparately)->ArgsProduct({{1081, 2880}, {0, 1}});
+
+// the change test of the sparsifier's publish_on_change mode, against a
+// scan taken 10 cm away
+static void BM_ScanChange(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg, reference;
+  makeRoomScan(state.range(0), scan_msg, 0.4, -0.2);
+  makeRoomScan(state.range(0), reference);
+
+  double change = 0.0;
+  for (auto _ : state)
+  {
+    change = scanChange(scan_msg, reference, 0.05);
+    benchmark::DoNotOptimize(change);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["changed"] = change;
+}
+BENCHMARK(BM_ScanChange)->Apply(BeamCounts);
+
+// masking the back 90 degrees and a 0.6 x 0.4 m body around the laser,
+// as the sparsifier does with ~mask/ parameters
+static void BM_ScanMask(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg, scan_masked;
+  makeRoomScan(state.range(0), scan_msg);
+
+  std::vector<double> footprint;
+  footprint.push_back( 0.1); footprint.push_back( 0.2);
+  footprint.push_back(-0.5); footprint.push_back( 0.2);
+  footprint.push_back(-0.5); footprint.push_back(-0.2);
+  footprint.push_back( 0.1); footprint.push_back(-0.2);
+
+  ScanMask mask;
+  mask.addSector(0.75 * M_PI, -0.75 * M_PI);
+  mask.setFootprint(footprint);
+
+  for (auto _ : state)
+  {
+    scan_masked.ranges = scan_msg.ranges;  // as the sparse scan would be
+    scan_masked.angle_min = scan_msg.angle_min;
+    mask.update(scan_msg.angle_min, scan_msg.angle_increment, scan_msg.ranges.size());
+    mask.apply(scan_masked);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["beams_out"] = scan_masked.ranges.size();
+}
+BENCHMARK(BM_ScanMask)->Apply(BeamCounts);
+
+static void BM_ShadowFilter(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg;
+  makeRoomScan(state.range(0), scan_msg);
+
+  ShadowFilter filter(10.0 * M_PI / 180.0, 3);
+  unsigned int veiling = 0;
+
+  for (auto _ : state)
+  {
+    veiling = filter.detect(scan_msg);
+    benchmark::DoNotOptimize(veiling);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["veiling"] = veiling;
+}
+BENCHMARK(BM_ShadowFilter)->Apply(BeamCounts);
+
+// a laser standing still, with a history of 5 scans
+static void BM_TemporalFilter(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg;
+  makeRoomScan(state.range(0), scan_msg);
+
+  TemporalFilter filter(5, 0.1f);
+  for (int k = 0; k < 5; ++k)
+    filter.detect(scan_msg);
+
+  unsigned int outliers = 0;
+
+  for (auto _ : state)
+  {
+    outliers = filter.detect(scan_msg);
+    benchmark::DoNotOptimize(outliers);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["outliers"] = outliers;
+}
+BENCHMARK(BM_TemporalFilter)->Apply(BeamCounts);
+
+// a scan 10 cm and 1 degree from the keyframe, with two people in it,
+// masked as in the laser_scan_matcher
+static void BM_DynamicMask(benchmark::State& state)
+{
+  sensor_msgs::LaserScan keyframe, scan_msg;
+  makeRoomScan(state.range(0), keyframe);
+  makeRoomScan(state.range(0), scan_msg, 0.4, -0.2, 0.0175);
+
+  for (int i = state.range(0) / 3; i < state.range(0) / 3 + state.range(0) / 30; ++i)
+    scan_msg.ranges[i] = 1.0;
+  for (int i = state.range(0) / 2; i < state.range(0) / 2 + state.range(0) / 40; ++i)
+    scan_msg.ranges[i] = 2.0;
+
+  ScanGeometryPtr geometry = ScanGeometryCache::get(
+    scan_msg.angle_min, scan_msg.angle_increment, scan_msg.ranges.size());
+
+  PlanarProjection keyframe_to_laser;
+  keyframe_to_laser.r00 = cos(0.0175); keyframe_to_laser.r01 = -sin(0.0175); keyframe_to_laser.tx = 0.1;
+  keyframe_to_laser.r10 = sin(0.0175); keyframe_to_laser.r11 =  cos(0.0175); keyframe_to_laser.ty = 0.0;
+  keyframe_to_laser.r20 = 0.0;         keyframe_to_laser.r21 = 0.0;          keyframe_to_laser.tz = 0.0;
+
+  ScanBinningBuffers buffers;
+  std::vector<int32_t> flags;
+  unsigned int masked = 0;
+
+  for (auto _ : state)
+  {
+    projectScan(scan_msg.ranges.data(), scan_msg.ranges.size(),
+                scan_msg.range_min, scan_msg.range_max,
+                keyframe_to_laser, *geometry,
+                keyframe.angle_min, keyframe.angle_increment, keyframe.ranges.size(),
+                0.0f, keyframe.range_max, buffers);
+    masked = flagCloserBeams(buffers, keyframe.ranges.data(), keyframe.ranges.size(),
+                             keyframe.range_min, keyframe.range_max, 0.5f, flags);
+    benchmark::DoNotOptimize(masked);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["masked"] = masked;
+}
+BENCHMARK(BM_DynamicMask)->Apply(BeamCounts);
+
+// split into two halves, as in the splitter demo
+static void BM_Split(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg, scan_left, scan_right;
+  makeRoomScan(state.range(0), scan_msg);
+
+  int half = state.range(0) / 2;
+
+  for (auto _ : state)
+  {
+    LaserScanSplitter::splitScan(scan_msg, 0, half, "laser_left", scan_left);
+    LaserScanSplitter::splitScan(scan_msg, half, state.range(0) - half, "laser_right", scan_right);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Split)->Apply(BeamCounts);
+
+} // namespace scan_tools
@@ -0,0 +1,764 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*  Offline accuracy vs. runtime evaluation of the scan matchers.
+ *
+ *  Runs LaserScanMatcher's CSM pipeline and PolarMatcher over a dataset
+ *  with ground truth (synthetic, or NCD odometry), for every point of a
+ *  parameter grid. Each configuration runs in its own process, so CSM's
+ *  global state is not shared, and the results are printed as a table
+ *  with the configurations on the ATE vs. mean runtime Pareto front
+ *  marked.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <boost/chrono.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <laser_scan_matcher/compact_scan.h>
+#include <laser_scan_matcher/csm_params.h>
+#include <laser_scan_matcher/scan_conversion.h>
+#include <polar_scan_matcher/polar_match.h>
+#include <ncd_parser/ncd_reader.h>
+#include <scan_tools_benchmarks/scan_simulator.h>
+
+#include "trajectory_metrics.h"
+
+namespace scan_tools
+{
+
+static const double ROS_TO_PM = 100.0;   // convert from cm to m
+
+typedef boost::chrono::steady_clock Clock;
+
+// **** parameters of one configuration
+
+// Parameter values by name, with the getParam interface loadCSMParams
+// expects from a NodeHandle
+class ParamMap
+{
+  public:
+
+    void set(const std::string& name, double value) { values_[name] = value; }
+
+    bool getParam(const std::string& name, double& value) const
+    {
+      std::map<std::string, double>::const_iterator it = values_.find(name);
+      if (it == values_.end()) return false;
+      value = it->second;
+      return true;
+    }
+
+    bool getParam(const std::string& name, int& value) const
+    {
+      double d;
+      if (!getParam(name, d)) return false;
+      value = (int)d;
+      return true;
+    }
+
+    std::string label() const
+    {
+      std::string s;
+      char buf[64];
+      for (std::map<std::string, double>::const_iterator it = values_.begin();
+           it != values_.end(); ++it)
+      {
+        snprintf(buf, sizeof(buf), "%s%s=%g", s.empty() ? "" : " ",
+                 it->first.c_str(), it->second);
+        s += buf;
+      }
+      return s.empty() ? "defaults" : s;
+    }
+
+  private:
+
+    std::map<std::string, double> values_;
+};
+
+enum Matcher { CSM, PSM };
+
+struct Configuration
+{
+  Matcher matcher;
+  ParamMap params;
+};
+
+// Plain data, sent back from the worker process through a pipe
+struct RunResult
+{
+  int ok;
+  int scans;
+  int failures;
+  double ate;          // [m]
+  double rpe_trans;    // [m]
+  double rpe_rot;      // [rad]
+  double time_mean;    // [ms]
+  double time_p95;     // [ms]
+  double time_max;     // [ms]
+};
+
+struct Dataset
+{
+  std::vector<sensor_msgs::LaserScan> scans;
+  std::vector<double> times;
+  std::vector<SimPose> ground_truth;
+};
+
+// **** datasets
+
+static bool loadSynthetic(const std::string& world_name, int beams, double speed,
+                          double noise, uint64_t seed, Dataset& data)
+{
+  SimWorld world;
+  std::vector<SimPose> waypoints;
+
+  if (world_name == "corridor")
+  {
+    world = SimWorld::corridor();
+    waypoints.push_back(SimPose( 1.0, 0.0, 0.0));
+    waypoints.push_back(SimPose(45.0, 0.0, 0.0));
+  }
+  else if (world_name == "open" || world_name == "cluttered")
+  {
+    // a square loop, turning along each side
+    double r = 4.0;
+    if (world_name == "open")
+    {
+      world = SimWorld::open();
+      r = 15.0;
+    }
+    else
+      world = SimWorld::cluttered(20.0, 60, seed);
+
+    waypoints.push_back(SimPose(-r, -r, 0.0));
+    waypoints.push_back(SimPose( r, -r, M_PI / 2.0));
+    waypoints.push_back(SimPose( r,  r, M_PI));
+    waypoints.push_back(SimPose(-r,  r, -M_PI / 2.0));
+    waypoints.push_back(SimPose(-r, -r, 0.0));
+  }
+  else
+    return false;
+
+  SimScanConfig config;
+  config.beams = beams;
+  config.noise_stddev = noise;
+  config.seed = seed;
+
+  ScanSimulator simulator(world, config);
+  simulator.simulate(SimTrajectory(waypoints, speed), data.scans, data.ground_truth);
+
+  data.times.resize(data.scans.size());
+  for (unsigned int i = 0; i < data.scans.size(); ++i)
+    data.times[i] = i / config.rate;
+
+  return true;
+}
+
+// The odometry of the New College Dataset, interpolated at the scan
+// times, serves as the reference trajectory
+static bool loadNCD(const std::string& filename, bool left, Dataset& data)
+{
+  NCDReader reader;
+  if (!reader.open(filename)) return false;
+
+  std::vector<sensor_msgs::LaserScan> scans;
+  std::vector<double> scan_times;
+  std::vector<SimPose> odom;
+  std::vector<double> odom_times;
+
+  NCDRecord record;
+  NCDRecord::Type laser = left ? NCDRecord::LASER_LEFT : NCDRecord::LASER_RIGHT;
+
+  while (reader.next(record))
+  {
+    if (record.type == NCDRecord::ODOMETRY)
+    {
+      odom.push_back(SimPose(record.x, record.y, record.theta));
+      odom_times.push_back(record.time);
+    }
+    else if (record.type == laser)
+    {
+      scans.push_back(record.scan);
+      scan_times.push_back(record.time);
+    }
+  }
+
+  for (unsigned int i = 0; i < scans.size(); ++i)
+  {
+    double t = scan_times[i];
+    unsigned int j = std::upper_bound(odom_times.begin(), odom_times.end(), t) - odom_times.begin();
+    if (j == 0 || j >= odom_times.size()) continue;   // outside of the odometry
+
+    const SimPose& a = odom[j-1];
+    const SimPose& b = odom[j];
+    double dt = odom_times[j] - odom_times[j-1];
+    double f = dt > 0.0 ? (t - odom_times[j-1]) / dt : 0.0;
+    double dth = atan2(sin(b.theta - a.theta), cos(b.theta - a.theta));
+
+    data.scans.push_back(scans[i]);
+    data.times.push_back(t);
+    data.ground_truth.push_back(SimPose(a.x + f * (b.x - a.x),
+                                        a.y + f * (b.y - a.y),
+                                        a.theta + f * dth));
+  }
+
+  return !data.scans.empty();
+}
+
+// **** matchers
+
+static double elapsedMs(const Clock::time_point& start)
+{
+  return boost::chrono::duration<double, boost::milli>(Clock::now() - start).count();
+}
+
+// Same keyframe based use of CSM as LaserScanMatcher::processScan, with
+// the laser at the base and no prediction
+static void runCSM(const Dataset& data, const ParamMap& params,
+                   std::vector<SimPose>& estimate,
+                   std::vector<double>& durations, int& failures)
+{
+  sm_params input;
+  sm_result output;
+  memset(&input,  0, sizeof(input));
+  memset(&output, 0, sizeof(output));
+
+  loadCSMParams(params, input);
+  input.laser[0] = 0.0;
+  input.laser[1] = 0.0;
+  input.laser[2] = 0.0;
+  input.min_reading = data.scans[0].range_min;
+  input.max_reading = data.scans[0].range_max;
+
+  double kf_dist_linear = 0.10;
+  double kf_dist_angular = 10.0 * (M_PI / 180.0);
+  params.getParam("kf_dist_linear", kf_dist_linear);
+  params.getParam("kf_dist_angular", kf_dist_angular);
+
+  CompactScan keyframe_scan, curr_scan;
+  SimPose keyframe_pose, last_pose;
+
+  laserScanToCompactScan(data.scans[0], keyframe_scan);
+  estimate.push_back(last_pose);
+
+  for (unsigned int i = 1; i < data.scans.size(); ++i)
+  {
+    Clock::time_point start = Clock::now();
+
+    laserScanToCompactScan(data.scans[i], curr_scan);
+
+    LDP prev_ldp_scan = keyframe_scan.ldp();
+    LDP curr_ldp_scan = curr_scan.ldp();
+
+    for (int k = 0; k < 3; ++k)
+    {
+      prev_ldp_scan->odometry[k]  = 0.0;
+      prev_ldp_scan->estimate[k]  = 0.0;
+      prev_ldp_scan->true_pose[k] = 0.0;
+    }
+
+    input.laser_ref  = prev_ldp_scan;
+    input.laser_sens = curr_ldp_scan;
+
+    SimPose pred_offset = relativePose(keyframe_pose, last_pose);
+    input.first_guess[0] = pred_offset.x;
+    input.first_guess[1] = pred_offset.y;
+    input.first_guess[2] = pred_offset.theta;
+
+    if (output.cov_x_m)  { gsl_matrix_free(output.cov_x_m);  output.cov_x_m  = 0; }
+    if (output.dx_dy1_m) { gsl_matrix_free(output.dx_dy1_m); output.dx_dy1_m = 0; }
+    if (output.dx_dy2_m) { gsl_matrix_free(output.dx_dy2_m); output.dx_dy2_m = 0; }
+
+    sm_icp(&input, &output);
+
+    SimPose meas_offset;
+    if (output.valid)
+    {
+      meas_offset = SimPose(output.x[0], output.x[1], output.x[2]);
+      last_pose = composePoses(keyframe_pose, meas_offset);
+    }
+    else
+      failures++;
+
+    if (fabs(meas_offset.theta) > kf_dist_angular ||
+        meas_offset.x * meas_offset.x + meas_offset.y * meas_offset.y >
+        kf_dist_linear * kf_dist_linear)
+    {
+      keyframe_scan.swap(curr_scan);
+      keyframe_pose = last_pose;
+    }
+
+    durations.push_back(elapsedMs(start));
+    estimate.push_back(last_pose);
+  }
+
+  if (output.cov_x_m)  gsl_matrix_free(output.cov_x_m);
+  if (output.dx_dy1_m) gsl_matrix_free(output.dx_dy1_m);
+  if (output.dx_dy2_m) gsl_matrix_free(output.dx_dy2_m);
+}
+
+// Same conversion as PSMNode::rosToPMScan, with a zero pose
+static void toPMScan(PolarMatcher& matcher, const sensor_msgs::LaserScan& scan,
+                     PMScan& pm_scan)
+{
+  pm_scan.rx = 0.0;
+  pm_scan.ry = 0.0;
+  pm_scan.th = 0.0;
+
+  for (unsigned int i = 0; i < scan.ranges.size(); ++i)
+  {
+    if (scan.ranges[i] == 0)
+      pm_scan.r[i] = 99999;
+    else
+      pm_scan.r[i] = scan.ranges[i] * ROS_TO_PM;
+    pm_scan.x[i] = pm_scan.r[i] * matcher.pm_co[i];
+    pm_scan.y[i] = pm_scan.r[i] * matcher.pm_si[i];
+    pm_scan.bad[i] = 0;
+  }
+
+  matcher.pm_median_filter  (&pm_scan);
+  matcher.pm_find_far_points(&pm_scan);
+  matcher.pm_segment_scan   (&pm_scan);
+}
+
+// Same scan to scan use of PolarMatcher as PSMNode, without odometry
+static void runPSM(const Dataset& data, const ParamMap& params,
+                   std::vector<SimPose>& estimate,
+                   std::vector<double>& durations, int& failures)
+{
+  // **** PSM parameters, with the defaults of PSMNode
+
+  double min_valid_points = 200, search_window = 40, max_error = 0.20;
+  double max_iterations = 20, stop_condition = 0.01;
+  params.getParam("min_valid_points", min_valid_points);
+  params.getParam("search_window", search_window);
+  params.getParam("max_error", max_error);
+  params.getParam("max_iterations", max_iterations);
+  params.getParam("stop_condition", stop_condition);
+
+  const sensor_msgs::LaserScan& first = data.scans[0];
+  const int n = first.ranges.size();
+
+  PolarMatcher matcher;
+  matcher.PM_L_POINTS         = n;
+  matcher.PM_FOV              = (first.angle_max - first.angle_min) * 180.0 / M_PI;
+  matcher.PM_MAX_RANGE        = first.range_max * ROS_TO_PM;
+  matcher.PM_TIME_DELAY       = 0.00;
+  matcher.PM_MIN_VALID_POINTS = min_valid_points;
+  matcher.PM_SEARCH_WINDOW    = search_window;
+  matcher.PM_MAX_ERROR        = max_error * ROS_TO_PM;
+  matcher.PM_MAX_ITER         = max_iterations;
+  matcher.PM_MAX_ITER_ICP     = max_iterations;
+  matcher.PM_STOP_COND        = stop_condition * ROS_TO_PM;
+  matcher.PM_STOP_COND_ICP    = stop_condition * ROS_TO_PM;
+  matcher.pm_init();
+
+  PMScan prev_scan(n), curr_scan(n);
+  toPMScan(matcher, first, prev_scan);
+
+  SimPose pose;
+  estimate.push_back(pose);
+
+  for (unsigned int i = 1; i < data.scans.size(); ++i)
+  {
+    Clock::time_point start = Clock::now();
+
+    prev_scan.rx = 0;
+    prev_scan.ry = 0;
+    prev_scan.th = 0;
+    toPMScan(matcher, data.scans[i], curr_scan);
+
+    try
+    {
+      matcher.pm_psm(&prev_scan, &curr_scan);
+
+      // rotate by -90 degrees, since polar scan matcher assumes a
+      // different laser frame, and scale down by 100
+      pose = composePoses(pose, SimPose( curr_scan.ry / ROS_TO_PM,
+                                        -curr_scan.rx / ROS_TO_PM,
+                                         curr_scan.th));
+    }
+    catch(int err)
+    {
+      failures++;
+    }
+
+    std::swap(prev_scan, curr_scan);
+
+    durations.push_back(elapsedMs(start));
+    estimate.push_back(pose);
+  }
+}
+
+static RunResult runConfiguration(const Dataset& data, const Configuration& config,
+                                  double rpe_delta)
+{
+  std::vector<SimPose> estimate;
+  std::vector<double> durations;
+
+  RunResult result;
+  memset(&result, 0, sizeof(result));
+
+  if (config.matcher == CSM)
+    runCSM(data, config.params, estimate, durations, result.failures);
+  else
+    runPSM(data, config.params, estimate, durations, result.failures);
+
+  RuntimeStats runtime = runtimeStats(durations);
+
+  result.ok        = 1;
+  result.scans     = estimate.size();
+  result.ate       = absoluteTrajectoryError(data.ground_truth, estimate);
+  result.time_mean = runtime.mean;
+  result.time_p95  = runtime.p95;
+  result.time_max  = runtime.max;
+  relativePoseError(data.ground_truth, estimate, data.times, rpe_delta,
+                    result.rpe_trans, result.rpe_rot);
+  return result;
+}
+
+// Runs every configuration in a child process, at most jobs at a time
+static void runAll(const Dataset& data, const std::vector<Configuration>& configs,
+                   double rpe_delta, unsigned int jobs,
+                   std::vector<RunResult>& results)
+{
+  results.resize(configs.size());
+  memset(&results[0], 0, results.size() * sizeof(RunResult));
+
+  std::map<pid_t, std::pair<unsigned int, int> > running;  // pid -> config, pipe
+  unsigned int next = 0;
+
+  while (next < configs.size() || !running.empty())
+  {
+    while (next < configs.size() && running.size() < jobs)
+    {
+      int fds[2];
+      if (pipe(fds) != 0)
+      {
+        perror("pipe");
+        exit(1);
+      }
+
+      pid_t pid = fork();
+      if (pid == 0)
+      {
+        close(fds[0]);
+        RunResult result = runConfiguration(data, configs[next], rpe_delta);
+        ssize_t written = write(fds[1], &result, sizeof(result));
+        _exit(written == sizeof(result) ? 0 : 1);
+      }
+      if (pid < 0)
+      {
+        perror("fork");
+        exit(1);
+      }
+
+      close(fds[1]);
+      running[pid] = std::make_pair(next, fds[0]);
+      next++;
+    }
+
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) break;
+
+    std::map<pid_t, std::pair<unsigned int, int> >::iterator it = running.find(pid);
+    if (it == running.end()) continue;
+
+    RunResult result;
+    if (read(it->second.second, &result, sizeof(result)) == sizeof(result))
+      results[it->second.first] = result;
+    else
+      fprintf(stderr, "configuration %u failed\n", it->second.first);
+
+    close(it->second.second);
+    running.erase(it);
+  }
+}
+
+// **** command line
+
+struct GridAxis
+{
+  std::string name;
+  std::vector<double> values;
+};
+
+static bool parseGridAxis(const std::string& s, GridAxis& axis)
+{
+  std::string::size_type eq = s.find('=');
+  if (eq == std::string::npos || eq == 0) return false;
+
+  axis.name = s.substr(0, eq);
+
+  std::string::size_type pos = eq + 1;
+  while (pos <= s.size())
+  {
+    std::string::size_type comma = s.find(',', pos);
+    if (comma == std::string::npos) comma = s.size();
+
+    char* end;
+    std::string token = s.substr(pos, comma - pos);
+    double value = strtod(token.c_str(), &end);
+    if (token.empty() || *end != '\0') return false;
+    axis.values.push_back(value);
+
+    pos = comma + 1;
+  }
+  return true;
+}
+
+// Cartesian product of the grid axes, for each matcher
+static void expandGrid(const std::vector<GridAxis>& grid,
+                       const std::vector<Matcher>& matchers,
+                       std::vector<Configuration>& configs)
+{
+  std::vector<ParamMap> points(1);
+
+  for (unsigned int a = 0; a < grid.size(); ++a)
+  {
+    std::vector<ParamMap> expanded;
+    for (unsigned int p = 0; p < points.size(); ++p)
+      for (unsigned int v = 0; v < grid[a].values.size(); ++v)
+      {
+        ParamMap params = points[p];
+        params.set(grid[a].name, grid[a].values[v]);
+        expanded.push_back(params);
+      }
+    points.swap(expanded);
+  }
+
+  for (unsigned int m = 0; m < matchers.size(); ++m)
+    for (unsigned int p = 0; p < points.size(); ++p)
+    {
+      Configuration config;
+      config.matcher = matchers[m];
+      config.params = points[p];
+      configs.push_back(config);
+    }
+}
+
+static void usage()
+{
+  printf(
+    "usage: scan_matcher_evaluation [options]\n"
+    "\n"
+    "data (one of):\n"
+    "  --synthetic WORLD    corridor (default), open or cluttered\n"
+    "  --ncd FILE           New College Dataset .alog file, odometry as reference\n"
+    "\n"
+    "  --ncd_laser SIDE     left (default) or right\n"
+    "  --beams N            synthetic beam count (1081)\n"
+    "  --speed V            synthetic speed [m/s] (1.0)\n"
+    "  --noise S            synthetic range noise stddev [m] (0.01)\n"
+    "  --seed N             synthetic seed (42)\n"
+    "\n"
+    "evaluation:\n"
+    "  --matcher M          csm, psm or both (default)\n"
+    "  --grid NAME=V1,V2    parameter values to sweep, repeatable; the names\n"
+    "                       are the ROS parameters of the matcher nodes\n"
+    "  --rpe_delta T        RPE time window [s] (1.0)\n"
+    "  --jobs N             parallel configurations (number of cores)\n"
+    "  --csv FILE           also write the results as CSV\n");
+}
+
+} // namespace scan_tools
+
+using namespace scan_tools;
+
+int main(int argc, char** argv)
+{
+  std::string synthetic = "corridor";
+  std::string ncd_file;
+  std::string ncd_laser = "left";
+  std::string matcher = "both";
+  std::string csv_file;
+  int beams = 1081;
+  double speed = 1.0;
+  double noise = 0.01;
+  uint64_t seed = 42;
+  double rpe_delta = 1.0;
+  unsigned int jobs = std::max(1u, boost::thread::hardware_concurrency());
+  std::vector<GridAxis> grid;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help")
+    {
+      usage();
+      return 0;
+    }
+    if (i + 1 >= argc)
+    {
+      usage();
+      return 1;
+    }
+
+    std::string value = argv[++i];
+
+    if      (arg == "--synthetic") synthetic = value;
+    else if (arg == "--ncd")       ncd_file  = value;
+    else if (arg == "--ncd_laser") ncd_laser = value;
+    else if (arg == "--beams")     beams     = atoi(value.c_str());
+    else if (arg == "--speed")     speed     = atof(value.c_str());
+    else if (arg == "--noise")     noise     = atof(value.c_str());
+    else if (arg == "--seed")      seed      = strtoull(value.c_str(), NULL, 10);
+    else if (arg == "--matcher")   matcher   = value;
+    else if (arg == "--rpe_delta") rpe_delta = atof(value.c_str());
+    else if (arg == "--jobs")      jobs      = std::max(1, atoi(value.c_str()));
+    else if (arg == "--csv")       csv_file  = value;
+    else if (arg == "--grid")
+    {
+      GridAxis axis;
+      if (!parseGridAxis(value, axis))
+      {
+        fprintf(stderr, "invalid grid axis: %s\n", value.c_str());
+        return 1;
+      }
+      grid.push_back(axis);
+    }
+    else
+    {
+      usage();
+      return 1;
+    }
+  }
+
+  // **** load the data
+
+  Dataset data;
+
+  if (!ncd_file.empty())
+  {
+    if (!loadNCD(ncd_file, ncd_laser != "right", data))
+    {
+      fprintf(stderr, "could not read scans with odometry from %s\n", ncd_file.c_str());
+      return 1;
+    }
+  }
+  else if (!loadSynthetic(synthetic, beams, speed, noise, seed, data))
+  {
+    fprintf(stderr, "unknown synthetic world: %s\n", synthetic.c_str());
+    return 1;
+  }
+
+  if (data.scans.size() < 2)
+  {
+    fprintf(stderr, "not enough scans\n");
+    return 1;
+  }
+
+  // **** run the grid
+
+  std::vector<Matcher> matchers;
+  if (matcher == "csm" || matcher == "both") matchers.push_back(CSM);
+  if (matcher == "psm" || matcher == "both") matchers.push_back(PSM);
+  if (matchers.empty())
+  {
+    fprintf(stderr, "unknown matcher: %s\n", matcher.c_str());
+    return 1;
+  }
+
+  std::vector<Configuration> configs;
+  expandGrid(grid, matchers, configs);
+
+  fprintf(stderr, "%u scans, %u configurations, %u jobs\n",
+          (unsigned int)data.scans.size(), (unsigned int)configs.size(), jobs);
+
+  std::vector<RunResult> results;
+  runAll(data, configs, rpe_delta, jobs, results);
+
+  // **** Pareto front of ATE vs. mean runtime, over the completed runs
+
+  std::vector<unsigned int> order;
+  std::vector<double> ate, runtime;
+  for (unsigned int i = 0; i < results.size(); ++i)
+    if (results[i].ok)
+    {
+      order.push_back(i);
+      ate.push_back(results[i].ate);
+      runtime.push_back(results[i].time_mean);
+    }
+
+  std::vector<bool> front = paretoFront(ate, runtime);
+  std::vector<bool> on_front(results.size(), false);
+  for (unsigned int k = 0; k < order.size(); ++k)
+    on_front[order[k]] = front[k];
+
+  // fastest first
+  std::sort(order.begin(), order.end(), [&results](unsigned int a, unsigned int b)
+    { return results[a].time_mean < results[b].time_mean; });
+
+  FILE* csv = NULL;
+  if (!csv_file.empty())
+  {
+    csv = fopen(csv_file.c_str(), "w");
+    if (!csv) fprintf(stderr, "could not open %s\n", csv_file.c_str());
+    else fprintf(csv, "pareto,matcher,params,ate_m,rpe_trans_m,rpe_rot_deg,"
+                      "time_mean_ms,time_p95_ms,time_max_ms,failures,scans\n");
+  }
+
+  printf("%-6s %-7s %9s %9s %9s %9s %9s %9s %6s  %s\n", "pareto", "matcher",
+         "ate[m]", "rpe[m]", "rpe[deg]", "mean[ms]", "p95[ms]", "max[ms]",
+         "fail", "params");
+
+  for (unsigned int k = 0; k < order.size(); ++k)
+  {
+    unsigned int i = order[k];
+    const RunResult& r = results[i];
+    const char* name = configs[i].matcher == CSM ? "csm" : "psm";
+    std::string label = configs[i].params.label();
+
+    printf("%-6s %-7s %9.4f %9.4f %9.3f %9.3f %9.3f %9.3f %6d  %s\n",
+           on_front[i] ? "*" : "", name, r.ate, r.rpe_trans, r.rpe_rot * 180.0 / M_PI,
+           r.time_mean, r.time_p95, r.time_max, r.failures, label.c_str());
+
+    if (csv)
+      fprintf(csv, "%d,%s,\"%s\",%f,%f,%f,%f,%f,%f,%d,%d\n", on_front[i] ? 1 : 0,
+              name, label.c_str(), r.ate, r.rpe_trans, r.rpe_rot * 180.0 / M_PI,
+              r.time_mean, r.time_p95, r.time_max, r.failures, r.scans);
+  }
+
+  if (csv) fclose(csv);
+
+  return order.size() == configs.size() ? 0 : 1;
+}
@@ -0,0 +1,399 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <scan_tools_benchmarks/scan_simulator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <boost/thread/thread.hpp>
+
+namespace scan_tools
+{
+
+namespace
+{
+
+// splitmix64, to derive independent per-scan seeds from the base seed
+uint64_t mixSeed(uint64_t seed, uint64_t index)
+{
+  uint64_t z = seed + 0x9E3779B97F4A7C15ULL * (index + 1);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+double normalizeAngle(double a)
+{
+  return atan2(sin(a), cos(a));
+}
+
+} // namespace
+
+// **** SimWorld
+
+void SimWorld::addSegment(double x1, double y1, double x2, double y2, float intensity)
+{
+  x_.push_back(x1);
+  y_.push_back(y1);
+  ex_.push_back(x2 - x1);
+  ey_.push_back(y2 - y1);
+  intensity_.push_back(intensity);
+}
+
+void SimWorld::addPolygon(const std::vector<SimPose>& vertices, bool closed, float intensity)
+{
+  for (unsigned int i = 1; i < vertices.size(); ++i)
+    addSegment(vertices[i-1].x, vertices[i-1].y, vertices[i].x, vertices[i].y, intensity);
+
+  if (closed && vertices.size() > 2)
+    addSegment(vertices.back().x, vertices.back().y, vertices[0].x, vertices[0].y, intensity);
+}
+
+void SimWorld::addBox(double cx, double cy, double width, double height, float intensity)
+{
+  double hw = width / 2.0, hh = height / 2.0;
+  std::vector<SimPose> vertices;
+  vertices.push_back(SimPose(cx - hw, cy - hh));
+  vertices.push_back(SimPose(cx + hw, cy - hh));
+  vertices.push_back(SimPose(cx + hw, cy + hh));
+  vertices.push_back(SimPose(cx - hw, cy + hh));
+  addPolygon(vertices, true, intensity);
+}
+
+SimWorld SimWorld::corridor(double length, double width)
+{
+  SimWorld world;
+  const double door = 1.0;     // door width
+  const double spacing = 5.0;  // door spacing
+  const double depth = 0.3;    // door recess
+
+  // walls at y = +-width/2, interrupted by recessed doors
+  for (int side = -1; side <= 1; side += 2)
+  {
+    double y = side * width / 2.0;
+    double x = 0.0;
+    while (x < length)
+    {
+      double wall_end = std::min(x + spacing - door, length);
+      world.addSegment(x, y, wall_end, y);
+      if (wall_end >= length) break;
+
+      double door_end = std::min(wall_end + door, length);
+      double y_door = y + side * depth;
+      world.addSegment(wall_end, y, wall_end, y_door);
+      world.addSegment(wall_end, y_door, door_end, y_door, 300.0);  // doors are darker
+      world.addSegment(door_end, y_door, door_end, y);
+      x = door_end;
+    }
+  }
+
+  // end walls
+  world.addSegment(0.0, -width / 2.0, 0.0, width / 2.0);
+  world.addSegment(length, -width / 2.0, length, width / 2.0);
+
+  return world;
+}
+
+SimWorld SimWorld::open(double size)
+{
+  SimWorld world;
+  world.addBox(0.0, 0.0, size, size);
+
+  // a sparse grid of pillars
+  const double spacing = 10.0;
+  for (double x = -size / 2.0 + spacing; x < size / 2.0; x += spacing)
+    for (double y = -size / 2.0 + spacing; y < size / 2.0; y += spacing)
+      world.addBox(x, y, 0.4, 0.4, 2000.0);
+
+  return world;
+}
+
+SimWorld SimWorld::cluttered(double size, int obstacles, uint64_t seed)
+{
+  SimWorld world;
+  world.addBox(0.0, 0.0, size, size);
+
+  std::mt19937_64 rng(mixSeed(seed, 0));
+  std::uniform_real_distribution<double> position(-size / 2.0 + 1.0, size / 2.0 - 1.0);
+  std::uniform_real_distribution<double> extent(0.1, 1.0);
+  std::uniform_real_distribution<double> reflectivity(200.0, 2000.0);
+
+  for (int i = 0; i < obstacles; ++i)
+  {
+    double x = position(rng);
+    double y = position(rng);
+
+    // keep the center free for the trajectories
+    if (fabs(x) < 1.0 && fabs(y) < 1.0) continue;
+
+    world.addBox(x, y, extent(rng), extent(rng), reflectivity(rng));
+  }
+
+  return world;
+}
+
+void SimWorld::castRays(const SimPose& pose, unsigned int n,
+                        const float* a_cos, const float* a_sin,
+                        float* ranges, float* incidence, float* intensities) const
+{
+  const unsigned int m = x_.size();
+  const float no_hit = std::numeric_limits<float>::max();
+
+  // beam directions in the world frame
+  std::vector<float> c(n), s(n);
+  const float pc = cos(pose.theta);
+  const float ps = sin(pose.theta);
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    c[i] = pc * a_cos[i] - ps * a_sin[i];
+    s[i] = ps * a_cos[i] + pc * a_sin[i];
+  }
+
+  std::vector<float> best_t(n, no_hit);
+  std::vector<int>   best_j(n, -1);
+
+  float* bt = best_t.data();
+  int*   bj = best_j.data();
+  const float* bc = c.data();
+  const float* bs = s.data();
+
+  // one segment at a time against all beams: the inner loop has no
+  // control flow and runs over contiguous beam arrays, so it vectorizes
+  for (unsigned int j = 0; j < m; ++j)
+  {
+    // beam: t * (c, s), segment: w + u * e, w relative to the sensor
+    const float wx = x_[j] - pose.x;
+    const float wy = y_[j] - pose.y;
+    const float ex = ex_[j];
+    const float ey = ey_[j];
+    const float t_num = wx * ey - wy * ex;
+
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      float den = bc[i] * ey - bs[i] * ex;
+      float u_num = wx * bs[i] - wy * bc[i];
+
+      // t > 0 and u in [0, 1], checked without dividing by den
+      float sign = den < 0.0f ? -1.0f : 1.0f;
+      float a_den = den * sign;
+      float t_n = t_num * sign;
+      float u_n = u_num * sign;
+
+      float t = t_n / (a_den + 1e-30f);
+      bool hit = (a_den > 1e-12f) & (t_n > 0.0f) & (u_n >= 0.0f) & (u_n <= a_den) & (t < bt[i]);
+      bt[i] = hit ? t : bt[i];
+      bj[i] = hit ? (int)j : bj[i];
+    }
+  }
+
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    int j = bj[i];
+    if (j < 0)
+    {
+      ranges[i] = -1.0f;
+      incidence[i] = 0.0f;
+      intensities[i] = 0.0f;
+    }
+    else
+    {
+      float len = sqrt(ex_[j] * ex_[j] + ey_[j] * ey_[j]);
+      ranges[i] = bt[i];
+      incidence[i] = fabs(bc[i] * ey_[j] - bs[i] * ex_[j]) / len;
+      intensities[i] = intensity_[j];
+    }
+  }
+}
+
+// **** SimTrajectory
+
+SimTrajectory::SimTrajectory(const std::vector<SimPose>& waypoints, double speed):
+  waypoints_(waypoints)
+{
+  double t = 0.0;
+  for (unsigned int i = 0; i < waypoints_.size(); ++i)
+  {
+    if (i > 0)
+    {
+      double dx = waypoints_[i].x - waypoints_[i-1].x;
+      double dy = waypoints_[i].y - waypoints_[i-1].y;
+      t += sqrt(dx*dx + dy*dy) / speed;
+    }
+    times_.push_back(t);
+  }
+}
+
+SimPose SimTrajectory::poseAt(double t) const
+{
+  if (waypoints_.empty()) return SimPose();
+  if (t <= 0.0) return waypoints_.front();
+  if (t >= times_.back()) return waypoints_.back();
+
+  unsigned int i = std::upper_bound(times_.begin(), times_.end(), t) - times_.begin();
+  const SimPose& a = waypoints_[i-1];
+  const SimPose& b = waypoints_[i];
+
+  double dt = times_[i] - times_[i-1];
+  double f = dt > 0.0 ? (t - times_[i-1]) / dt : 1.0;
+
+  return SimPose(a.x + f * (b.x - a.x),
+                 a.y + f * (b.y - a.y),
+                 normalizeAngle(a.theta + f * normalizeAngle(b.theta - a.theta)));
+}
+
+// **** ScanSimulator
+
+SimScanConfig::SimScanConfig():
+  fov(1.5 * M_PI),
+  beams(1081),
+  range_min(0.05),
+  range_max(30.0),
+  rate(40.0),
+  noise_stddev(0.01),
+  dropout_prob(0.01),
+  intensities(true),
+  intensity_noise(0.05),
+  seed(42),
+  frame_id("laser")
+{
+
+}
+
+ScanSimulator::ScanSimulator(const SimWorld& world, const SimScanConfig& config):
+  world_(world),
+  config_(config)
+{
+  double increment = config_.beams > 1 ? config_.fov / (config_.beams - 1) : 0.0;
+
+  a_cos_.resize(config_.beams);
+  a_sin_.resize(config_.beams);
+  for (int i = 0; i < config_.beams; ++i)
+  {
+    double angle = -config_.fov / 2.0 + i * increment;
+    a_cos_[i] = cos(angle);
+    a_sin_[i] = sin(angle);
+  }
+}
+
+void ScanSimulator::simulate(const SimPose& pose, uint64_t index,
+                             sensor_msgs::LaserScan& scan) const
+{
+  const int n = config_.beams;
+
+  scan.header.frame_id = config_.frame_id;
+  scan.header.seq = index;
+  scan.header.stamp = ros::Time(index / config_.rate);
+  scan.angle_min = -config_.fov / 2.0;
+  scan.angle_increment = n > 1 ? config_.fov / (n - 1) : 0.0;
+  scan.angle_max = scan.angle_min + scan.angle_increment * (n - 1);
+  scan.scan_time = 1.0 / config_.rate;
+  scan.time_increment = scan.scan_time / n;
+  scan.range_min = config_.range_min;
+  scan.range_max = config_.range_max;
+
+  std::vector<float> incidence(n);
+  std::vector<float> intensities(n);
+  scan.ranges.resize(n);
+
+  world_.castRays(pose, n, a_cos_.data(), a_sin_.data(),
+                  scan.ranges.data(), incidence.data(), intensities.data());
+
+  // **** noise, dropouts and out of range readings
+
+  std::mt19937_64 rng(mixSeed(config_.seed, index));
+  std::normal_distribution<float> range_noise(0.0, config_.noise_stddev);
+  std::normal_distribution<float> intensity_noise(0.0, config_.intensity_noise);
+  std::uniform_real_distribution<float> uniform(0.0, 1.0);
+
+  const float out_of_range = config_.range_max + 1.0;
+
+  if (config_.intensities)
+    scan.intensities.resize(n);
+  else
+    scan.intensities.clear();
+
+  for (int i = 0; i < n; ++i)
+  {
+    float r = scan.ranges[i];
+
+    // always draw the same numbers per beam, so that a hit or miss does
+    // not shift the noise of the following beams
+    float dr = config_.noise_stddev > 0.0 ? range_noise(rng) : 0.0f;
+    float di = config_.intensity_noise > 0.0 ? intensity_noise(rng) : 0.0f;
+    bool dropout = uniform(rng) < config_.dropout_prob;
+
+    if (r < 0.0f || r > config_.range_max)
+      scan.ranges[i] = out_of_range;
+    else if (dropout)
+      scan.ranges[i] = 0.0f;
+    else
+      scan.ranges[i] = std::max(r + dr, 0.0f);
+
+    if (config_.intensities)
+    {
+      bool valid = scan.ranges[i] > 0.0f && scan.ranges[i] < out_of_range;
+      scan.intensities[i] = valid ? 
+        std::max(intensities[i] * incidence[i] * (1.0f + di), 0.0f) : 0.0f;
+    }
+  }
+}
+
+void ScanSimulator::simulate(const SimTrajectory& trajectory,
+                             std::vector<sensor_msgs::LaserScan>& scans,
+                             std::vector<SimPose>& poses,
+                             unsigned int threads) const
+{
+  const unsigned int count = trajectory.duration() * config_.rate + 1;
+
+  scans.resize(count);
+  poses.resize(count);
+
+  for (unsigned int i = 0; i < count; ++i)
+    poses[i] = trajectory.poseAt(i / config_.rate);
+
+  if (threads == 0)
+    threads = std::max(1u, boost::thread::hardware_concurrency());
+  threads = std::min(threads, count);
+
+  // interleaved, since the scan cost varies along the trajectory
+  boost::thread_group group;
+  for (unsigned int k = 0; k < threads; ++k)
+  {
+    group.create_thread([this, k, threads, count, &scans, &poses]()
+    {
+      for (unsigned int i = k; i < count; i += threads)
+        simulate(poses[i], i, scans[i]);
+    });
+  }
+  group.join_all();
+}
+
+} // namespace scan_tools
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <scan_tools_benchmarks/scan_simulator.h>
+
+#include "benchmark_scans.h"
+
+namespace scan_tools
+{
+
+enum Environment { CORRIDOR, OPEN, CLUTTERED };
+
+static SimWorld makeWorld(int environment)
+{
+  switch (environment)
+  {
+    case CORRIDOR: return SimWorld::corridor();
+    case OPEN:     return SimWorld::open();
+    default:       return SimWorld::cluttered();
+  }
+}
+
+static void EnvironmentsAndBeamCounts(benchmark::internal::Benchmark* b)
+{
+  b->ArgNames({"env", "beams"});
+  for (int env = CORRIDOR; env <= CLUTTERED; ++env)
+    for (int beams : {181, 541, 1081, 2880})
+      b->Args({env, beams});
+}
+
+// A single scan, in the corridor (0), open hall (1) or cluttered room (2)
+static void BM_SimulateScan(benchmark::State& state)
+{
+  SimScanConfig config;
+  config.beams = state.range(1);
+  config.fov = benchmarkFov(config.beams);
+
+  ScanSimulator simulator(makeWorld(state.range(0)), config);
+  sensor_msgs::LaserScan scan;
+  uint64_t index = 0;
+
+  for (auto _ : state)
+  {
+    simulator.simulate(SimPose(1.0, 0.2, 0.1), index++, scan);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * config.beams);
+}
+BENCHMARK(BM_SimulateScan)->Apply(EnvironmentsAndBeamCounts);
+
+// 10 s down the corridor at 40 Hz (401 scans), with 1..N threads
+static void BM_SimulateTrajectory(benchmark::State& state)
+{
+  SimScanConfig config;
+  ScanSimulator simulator(SimWorld::corridor(), config);
+
+  std::vector<SimPose> waypoints;
+  waypoints.push_back(SimPose(1.0, 0.0, 0.0));
+  waypoints.push_back(SimPose(11.0, 0.0, 0.0));
+  SimTrajectory trajectory(waypoints, 1.0);
+
+  std::vector<sensor_msgs::LaserScan> scans;
+  std::vector<SimPose> poses;
+
+  for (auto _ : state)
+    simulator.simulate(trajectory, scans, poses, state.range(0));
+
+  state.SetItemsProcessed(state.iterations() * scans.size());
+}
+BENCHMARK(BM_SimulateTrajectory)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+} // namespace scan_tools
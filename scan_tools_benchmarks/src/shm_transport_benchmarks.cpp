@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <unistd.h>
+
+#include <boost/lexical_cast.hpp>
+#include <ros/serialization.h>
+
+#include <scan_tools_common/laser_scan_view.h>
+#include <scan_tools_common/shm_scan_ring.h>
+
+#include "benchmark_scans.h"
+
+namespace scan_tools
+{
+
+// A scan through the shared memory ring: the writer's copy in, and the
+// reader's in place access and check for an overwrite
+static void BM_ShmScanRingWriteRead(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg;
+  makeRoomScan(state.range(0), scan_msg);
+
+  std::string name = "scan_tools_benchmark_" + boost::lexical_cast<std::string>(getpid());
+  boost::shared_ptr<ShmScanRing> writer = ShmScanRing::create(name, 16, state.range(0));
+  boost::shared_ptr<ShmScanRing> reader = ShmScanRing::open(name);
+  if (!writer || !reader)
+  {
+    state.SkipWithError("could not create the shared memory segment");
+    return;
+  }
+
+  scan_tools_common::ShmScanRef ref;
+  LaserScanView view;
+  float sum = 0.0;
+
+  for (auto _ : state)
+  {
+    writer->write(scan_msg, ref);
+    reader->read(ref, view);
+    sum += view.ranges[view.size - 1];
+    benchmark::DoNotOptimize(reader->valid(ref));
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ShmScanRingWriteRead)->Apply(BeamCounts);
+
+// The serialization and deserialization that TCPROS does for every
+// scan, without the socket
+static void BM_LaserScanSerialization(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg, scan_copy;
+  makeRoomScan(state.range(0), scan_msg);
+
+  uint32_t length = ros::serialization::serializationLength(scan_msg);
+  std::vector<uint8_t> buffer(length);
+
+  for (auto _ : state)
+  {
+    ros::serialization::OStream out(buffer.data(), length);
+    ros::serialization::serialize(out, scan_msg);
+    ros::serialization::IStream in(buffer.data(), length);
+    ros::serialization::deserialize(in, scan_copy);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LaserScanSerialization)->Apply(BeamCounts);
+
+} // namespace scan_tools
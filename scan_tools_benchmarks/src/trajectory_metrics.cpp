@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "trajectory_metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace scan_tools
+{
+
+static double wrapAngle(double a)
+{
+  return atan2(sin(a), cos(a));
+}
+
+SimPose composePoses(const SimPose& a, const SimPose& b)
+{
+  double c = cos(a.theta);
+  double s = sin(a.theta);
+  return SimPose(a.x + c * b.x - s * b.y,
+                 a.y + s * b.x + c * b.y,
+                 wrapAngle(a.theta + b.theta));
+}
+
+SimPose invertPose(const SimPose& a)
+{
+  double c = cos(a.theta);
+  double s = sin(a.theta);
+  return SimPose(-c * a.x - s * a.y,
+                  s * a.x - c * a.y,
+                 -a.theta);
+}
+
+SimPose relativePose(const SimPose& a, const SimPose& b)
+{
+  return composePoses(invertPose(a), b);
+}
+
+double absoluteTrajectoryError(const std::vector<SimPose>& ground_truth,
+                               const std::vector<SimPose>& estimate)
+{
+  const unsigned int n = std::min(ground_truth.size(), estimate.size());
+  if (n == 0) return 0.0;
+
+  // **** centroids
+
+  double gx = 0.0, gy = 0.0, ex = 0.0, ey = 0.0;
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    gx += ground_truth[i].x; gy += ground_truth[i].y;
+    ex += estimate[i].x;     ey += estimate[i].y;
+  }
+  gx /= n; gy /= n; ex /= n; ey /= n;
+
+  // **** rotation maximizing the correlation of the centered points
+
+  double sc = 0.0, ss = 0.0;
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    double px = estimate[i].x - ex,     py = estimate[i].y - ey;
+    double qx = ground_truth[i].x - gx, qy = ground_truth[i].y - gy;
+    sc += px * qx + py * qy;
+    ss += px * qy - py * qx;
+  }
+  double theta = atan2(ss, sc);
+  double c = cos(theta);
+  double s = sin(theta);
+
+  // **** residuals after alignment
+
+  double sum = 0.0;
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    double px = estimate[i].x - ex, py = estimate[i].y - ey;
+    double dx = gx + c * px - s * py - ground_truth[i].x;
+    double dy = gy + s * px + c * py - ground_truth[i].y;
+    sum += dx * dx + dy * dy;
+  }
+  return sqrt(sum / n);
+}
+
+void relativePoseError(const std::vector<SimPose>& ground_truth,
+                       const std::vector<SimPose>& estimate,
+                       const std::vector<double>& times, double delta,
+                       double& translation_rmse, double& rotation_rmse)
+{
+  const unsigned int n = std::min(ground_truth.size(), estimate.size());
+  double sum_t = 0.0, sum_r = 0.0;
+  int count = 0;
+
+  unsigned int j = 0;
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    // times are increasing, so j only moves forward
+    j = std::max(j, i + 1);
+    while (j < n && times[j] - times[i] < delta) ++j;
+    if (j >= n) break;
+
+    SimPose gt_motion  = relativePose(ground_truth[i], ground_truth[j]);
+    SimPose est_motion = relativePose(estimate[i], estimate[j]);
+    SimPose error = relativePose(gt_motion, est_motion);
+
+    sum_t += error.x * error.x + error.y * error.y;
+    sum_r += error.theta * error.theta;
+    count++;
+  }
+
+  translation_rmse = count > 0 ? sqrt(sum_t / count) : 0.0;
+  rotation_rmse    = count > 0 ? sqrt(sum_r / count) : 0.0;
+}
+
+RuntimeStats runtimeStats(std::vector<double> durations)
+{
+  RuntimeStats stats;
+  if (durations.empty()) return stats;
+
+  std::sort(durations.begin(), durations.end());
+
+  double sum = 0.0;
+  for (unsigned int i = 0; i < durations.size(); ++i)
+    sum += durations[i];
+
+  stats.mean = sum / durations.size();
+  stats.p95  = durations[(durations.size() - 1) * 95 / 100];
+  stats.max  = durations.back();
+  return stats;
+}
+
+std::vector<bool> paretoFront(const std::vector<double>& a,
+                              const std::vector<double>& b)
+{
+  std::vector<bool> front(a.size(), true);
+
+  for (unsigned int i = 0; i < a.size(); ++i)
+    for (unsigned int j = 0; j < a.size() && front[i]; ++j)
+    {
+      if (j == i) continue;
+      if (a[j] <= a[i] && b[j] <= b[i] && (a[j] < a[i] || b[j] < b[i]))
+        front[i] = false;
+    }
+
+  return front;
+}
+
+} // namespace scan_tools
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_BENCHMARKS_TRAJECTORY_METRICS_H
+#define SCAN_TOOLS_BENCHMARKS_TRAJECTORY_METRICS_H
+
+#include <vector>
+#include <scan_tools_benchmarks/scan_simulator.h>
+
+namespace scan_tools
+{
+
+// **** 2D pose algebra
+
+SimPose composePoses(const SimPose& a, const SimPose& b);  // a * b
+SimPose invertPose(const SimPose& a);
+SimPose relativePose(const SimPose& a, const SimPose& b);  // a^-1 * b
+
+/**
+ * Absolute trajectory error: RMSE of the position error after the
+ * estimate has been rigidly aligned (rotation and translation, closed
+ * form) to the ground truth.
+ */
+double absoluteTrajectoryError(const std::vector<SimPose>& ground_truth,
+                               const std::vector<SimPose>& estimate);
+
+/**
+ * Relative pose error over a fixed time window: RMSE of the translation
+ * [m] and rotation [rad] error of the motion between each pose and the
+ * first pose at least delta seconds later.
+ */
+void relativePoseError(const std::vector<SimPose>& ground_truth,
+                       const std::vector<SimPose>& estimate,
+                       const std::vector<double>& times, double delta,
+                       double& translation_rmse, double& rotation_rmse);
+
+struct RuntimeStats
+{
+  RuntimeStats(): mean(0.0), p95(0.0), max(0.0) { }
+
+  double mean;
+  double p95;
+  double max;
+};
+
+RuntimeStats runtimeStats(std::vector<double> durations);
+
+/**
+ * Marks the entries for which no other entry is at least as good in
+ * both a and b and strictly better in one of them (lower is better).
+ */
+std::vector<bool> paretoFront(const std::vector<double>& a,
+                              const std::vector<double>& b);
+
+} // namespace scan_tools
+
+#endif // SCAN_TOOLS_BENCHMARKS_TRAJECTORY_METRICS_H
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pcl/filters/voxel_grid.h>
+
+#include <scan_to_cloud_converter/scan_to_cloud_converter.h>
+#include <scan_tools_common/voxel_hash.h>
+
+#include "benchmark_scans.h"
+
+namespace scan_tools
+{
+
+typedef ScanToCloudConverter::PointCloudT PointCloudT;
+
+static const float LEAF_SIZE = 0.05;
+
+// The converter's built-in downsampling, from the scan to the cloud
+static void BM_VoxelHashDownsample(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg;
+  makeRoomScan(state.range(0), scan_msg);
+
+  ScanGeometryPtr geometry = ScanGeometryCache::get(
+    scan_msg.angle_min, scan_msg.angle_increment, scan_msg.ranges.size());
+
+  VoxelHash2D voxels(LEAF_SIZE, state.range(1) ? VoxelHash2D::NEAREST : VoxelHash2D::CENTROID);
+  PointCloudT cloud;
+
+  for (auto _ : state)
+  {
+    ScanToCloudConverter::downsampleScan(LaserScanView(scan_msg), *geometry, voxels, cloud);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["points_out"] = cloud.points.size();
+}
+BENCHMARK(BM_VoxelHashDownsample)->ArgsProduct({{181, 541, 1081, 2880}, {0, 1}});
+
+// The same, through the converter's one point per beam cloud and a PCL
+// VoxelGrid, as a separate filter node would do it
+static void BM_PclVoxelGridDownsample(benchmark::State& state)
+{
+  sensor_msgs::LaserScan scan_msg;
+  makeRoomScan(state.range(0), scan_msg);
+
+  ScanGeometryPtr geometry = ScanGeometryCache::get(
+    scan_msg.angle_min, scan_msg.angle_increment, scan_msg.ranges.size());
+
+  PointCloudT::Ptr cloud(new PointCloudT());
+  PointCloudT cloud_filtered;
+
+  pcl::VoxelGrid<ScanToCloudConverter::PointT> voxel_grid;
+  voxel_grid.setLeafSize(LEAF_SIZE, LEAF_SIZE, LEAF_SIZE);
+
+  for (auto _ : state)
+  {
+    ScanToCloudConverter::convertScan(scan_msg, *geometry, *cloud);
+    voxel_grid.setInputCloud(cloud);
+    voxel_grid.filter(cloud_filtered);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["points_out"] = cloud_filtered.points.size();
+}
+BENCHMARK(BM_PclVoxelGridDownsample)->Apply(BeamCounts);
+
+} // namespace scan_tools
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_COMMON_LASER_SCAN_VIEW_H
+#define SCAN_TOOLS_COMMON_LASER_SCAN_VIEW_H
+
+#include <sensor_msgs/LaserScan.h>
+
+namespace scan_tools
+{
+
+/**
+ * A laser scan whose header, ranges and intensities are held elsewhere,
+ * e.g. by a LaserScan message or in shared memory. Valid as long as they
+ * are.
+ */
+struct LaserScanView
+{
+  LaserScanView():
+    header(NULL), angle_min(0), angle_max(0), angle_increment(0),
+    time_increment(0), scan_time(0), range_min(0), range_max(0),
+    size(0), ranges(NULL), intensities(NULL)
+  { }
+
+  explicit LaserScanView(const sensor_msgs::LaserScan& scan):
+    header(&scan.header),
+    angle_min(scan.angle_min),
+    angle_max(scan.angle_max),
+    angle_increment(scan.angle_increment),
+    time_increment(scan.time_increment),
+    scan_time(scan.scan_time),
+    range_min(scan.range_min),
+    range_max(scan.range_max),
+    size(scan.ranges.size()),
+    ranges(scan.ranges.empty() ? NULL : &scan.ranges[0]),
+    intensities(scan.intensities.size() == scan.ranges.size() && !scan.ranges.empty() ?
+                &scan.intensities[0] : NULL)
+  { }
+
+  const std_msgs::Header* header;
+
+  float angle_min;
+  float angle_max;
+  float angle_increment;
+  float time_increment;
+  float scan_time;
+  float range_min;
+  float range_max;
+
+  unsigned int size;
+  const float* ranges;
+  const float* intensities;   // NULL if the scan has none
+};
+
+} // namespace scan_tools
+
+#endif // SCAN_TOOLS_COMMON_LASER_SCAN_VIEW_H
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_COMMON_REALTIME_H
+#define SCAN_TOOLS_COMMON_REALTIME_H
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/thread.hpp>
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+
+namespace scan_tools
+{
+
+// Scheduling of a processing thread
+struct RealtimeParams
+{
+  RealtimeParams(): policy("other"), priority(0), lock_memory(false) { }
+
+  std::string policy;     // other, fifo or rr
+  int priority;           // for fifo and rr
+  std::vector<int> cpus;  // to pin the thread to, any if empty
+  bool lock_memory;       // mlockall, for the whole process
+
+  bool enabled() const { return policy != "other" || !cpus.empty() || lock_memory; }
+};
+
+// Reads policy, priority, cpus and lock_memory from nh
+void loadRealtimeParams(const ros::NodeHandle& nh, RealtimeParams& params);
+
+/**
+ * Applies params to the calling thread. Whatever cannot be applied, e.g.
+ * for lack of permissions, is logged and skipped.
+ *
+ * @returns True if everything was applied.
+ */
+bool applyRealtimeParams(const RealtimeParams& params);
+
+/**
+ * A thread with the given scheduling that serves its own callback queue.
+ * Subscribing through a node handle that uses queue() moves those
+ * callbacks off the spinner threads.
+ */
+class CallbackThread : private boost::noncopyable
+{
+  public:
+
+    // name shows up in top -H, truncated to 15 characters
+    CallbackThread(const RealtimeParams& params, const std::string& name);
+    ~CallbackThread();
+
+    ros::CallbackQueue* queue() { return &queue_; }
+
+  private:
+
+    RealtimeParams params_;
+    std::string name_;
+
+    ros::CallbackQueue queue_;
+    boost::atomic<bool> running_;
+    boost::thread thread_;
+
+    void run();
+};
+
+// Running mean, standard deviation and maximum of a series of values
+class JitterStats
+{
+  public:
+
+    JitterStats(): count_(0), mean_(0.0), m2_(0.0), max_(0.0) { }
+
+    void add(double x)
+    {
+      count_++;
+      double delta = x - mean_;
+      mean_ += delta / count_;
+      m2_ += delta * (x - mean_);
+      if (count_ == 1 || x > max_) max_ = x;
+    }
+
+    int count() const { return count_; }
+    double mean() const { return mean_; }
+    double stdDev() const { return count_ > 1 ? std::sqrt(m2_ / (count_ - 1)) : 0.0; }
+    double max() const { return max_; }
+
+  private:
+
+    int count_;
+    double mean_;
+    double m2_;
+    double max_;
+};
+
+} // namespace scan_tools
+
+#endif // SCAN_TOOLS_COMMON_REALTIME_H
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_COMMON_SCAN_BINNING_H
+#define SCAN_TOOLS_COMMON_SCAN_BINNING_H
+
+#include <limits>
+#include <vector>
+#include <stdint.h>
+#include <sensor_msgs/LaserScan.h>
+
+#include <scan_tools_common/scan_geometry.h>
+
+namespace scan_tools
+{
+
+/**
+ * The part of a laser pose that moves the beams (which lie in the laser's
+ * xy plane) into the target frame: target = R * laser + t. Binning drops
+ * z, which makes it an orthogonal projection onto the target xy plane.
+ */
+struct PlanarProjection
+{
+  float r00, r01, tx;
+  float r10, r11, ty;
+  float r20, r21, tz;
+};
+
+// From a tf::Transform (or anything with the same accessors)
+template <typename TransformT>
+PlanarProjection planarProjection(const TransformT& target_to_laser)
+{
+  PlanarProjection p;
+  p.r00 = target_to_laser.getBasis().getRow(0).x();
+  p.r01 = target_to_laser.getBasis().getRow(0).y();
+  p.r10 = target_to_laser.getBasis().getRow(1).x();
+  p.r11 = target_to_laser.getBasis().getRow(1).y();
+  p.r20 = target_to_laser.getBasis().getRow(2).x();
+  p.r21 = target_to_laser.getBasis().getRow(2).y();
+  p.tx  = target_to_laser.getOrigin().x();
+  p.ty  = target_to_laser.getOrigin().y();
+  p.tz  = target_to_laser.getOrigin().z();
+  return p;
+}
+
+// Reused from scan to scan, so that binning does not allocate
+struct ScanBinningBuffers
+{
+  std::vector<float>   ranges;  // from the target frame origin
+  std::vector<int32_t> bins;    // -1 for beams that are dropped
+};
+
+/**
+ * Projects the valid beams of a scan (ranges in (in_min, in_max)) into
+ * the target plane, and stores their range around the target origin and
+ * the bin they fall into, of bins bins from angle_min in steps of
+ * angle_increment. Beams get bin -1 if they are invalid, end outside of
+ * [out_min, out_max] around the target origin or outside of the bins, or if
+ * their endpoint lies below z_min or above z_max in the target frame.
+ * Bins that cover the full circle wrap around.
+ *
+ * @param geometry  cosine and sine of each beam angle of the scan
+ * @returns The number of valid beams dropped for their height.
+ */
+unsigned int projectScan(const float* ranges, unsigned int size,
+                         float in_min, float in_max,
+                         const PlanarProjection& projection,
+                         const ScanGeometry& geometry,
+                         float angle_min, float angle_increment, int bins,
+                         float out_min, float out_max,
+                         ScanBinningBuffers& buffers,
+                         float z_min = -std::numeric_limits<float>::infinity(),
+                         float z_max =  std::numeric_limits<float>::infinity());
+
+/**
+ * Bins the valid beams of scan_msg, projected into the target plane, by
+ * their angle around the target origin. binned must have its angles and
+ * range limits set, and holds the closest beam of each bin so far (+inf
+ * if none); beams outside of its range limits are dropped, as are beams
+ * their endpoint lies below z_min or above z_max in the target frame.
+ * Intensities are carried along if both scans have them.
+ *
+ * @param geometry  cosine and sine of each beam angle of scan_msg
+ * @returns The number of valid beams dropped for their height.
+ */
+unsigned int binScan(const sensor_msgs::LaserScan& scan_msg,
+                     const PlanarProjection& projection,
+                     const ScanGeometry& geometry,
+                     sensor_msgs::LaserScan& binned,
+                     ScanBinningBuffers& buffers,
+                     float z_min = -std::numeric_limits<float>::infinity(),
+                     float z_max =  std::numeric_limits<float>::infinity());
+
+/**
+ * Flags the beams projected by projectScan() that end more than min_gap
+ * in front of a reference scan with the bins as beams, e.g. new obstacles
+ * in front of an earlier scan. A beam is compared to the closest valid
+ * reference beam (within (range_min, range_max)) of its bin and the two
+ * next to it, so that beams next to an edge of the reference are not
+ * flagged; nor are beams on bins without valid reference beams.
+ *
+ * @returns The number of beams flagged.
+ */
+unsigned int flagCloserBeams(const ScanBinningBuffers& buffers,
+                             const float* reference, int reference_size,
+                             float range_min, float range_max, float min_gap,
+                             std::vector<int32_t>& flags);
+
+} // namespace scan_tools
+
+#endif // SCAN_TOOLS_COMMON_SCAN_BINNING_H
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_COMMON_SCAN_CHANGE_H
+#define SCAN_TOOLS_COMMON_SCAN_CHANGE_H
+
+#include <sensor_msgs/LaserScan.h>
+
+namespace scan_tools
+{
+
+/**
+ * Fraction of the beams that changed between two scans of the same
+ * laser. A beam changed if it is valid (within (range_min, range_max))
+ * in only one of the scans, or if its ranges are more than tolerance
+ * apart. Beams invalid in both scans are masked out, so that a static
+ * scene with many no-return beams does not dilute the change.
+ *
+ * @returns The fraction in [0, 1] of the beams valid in either scan, 0
+ *          if there are none, 1 if the scans differ in size.
+ */
+double scanChange(const sensor_msgs::LaserScan& scan_msg,
+                  const sensor_msgs::LaserScan& reference,
+                  float tolerance);
+
+} // namespace scan_tools
+
+#endif // SCAN_TOOLS_COMMON_SCAN_CHANGE_H
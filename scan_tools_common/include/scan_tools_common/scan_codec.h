@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_COMMON_SCAN_CODEC_H
+#define SCAN_TOOLS_COMMON_SCAN_CODEC_H
+
+#include <vector>
+#include <stdint.h>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <ros/ros.h>
+#include <sensor_msgs/LaserScan.h>
+
+#include <scan_tools_common/CompressedLaserScan.h>
+
+namespace scan_tools
+{
+
+/**
+ * Ranges are quantized to uint16 multiples of the resolution (1 mm by
+ * default, so up to 65.5 m). The differences between neighbouring beams
+ * are zigzag coded and bit packed in blocks of 32, each block with the
+ * bit width of its largest difference. Smooth surfaces take a few bits
+ * per beam, jumps only widen their own block.
+ *
+ * Special values: NaN and negative ranges, and ranges beyond 65534
+ * units, decode to 0; +inf stays +inf.
+ */
+void encodeRanges(const std::vector<float>& ranges, double resolution,
+                  std::vector<uint8_t>& data);
+
+// False if data is not a valid encoding of beams ranges
+bool decodeRanges(const std::vector<uint8_t>& data, unsigned int beams,
+                  double resolution, std::vector<float>& ranges);
+
+// Encodes scan into compressed, with intensities scaled to 8 bits between their minimum and maximum
+void compressScan(const sensor_msgs::LaserScan& scan, double range_resolution,
+                  scan_tools_common::CompressedLaserScan& compressed);
+
+// False if compressed is corrupt
+bool decompressScan(const scan_tools_common::CompressedLaserScan& compressed,
+                    sensor_msgs::LaserScan& scan);
+
+/**
+ * Subscribes to a CompressedLaserScan topic, and hands the decompressed
+ * scans to a LaserScan callback, so a node can take either transport.
+ */
+class CompressedScanSubscriber : private boost::noncopyable
+{
+  public:
+
+    typedef boost::function<void (const sensor_msgs::LaserScan::ConstPtr&)> Callback;
+
+    CompressedScanSubscriber(ros::NodeHandle nh, const std::string& topic,
+                             uint32_t queue_size, const Callback& callback);
+
+  private:
+
+    ros::Subscriber subscriber_;
+    Callback callback_;
+
+    void compressedCallback(const scan_tools_common::CompressedLaserScan::ConstPtr& compressed);
+};
+
+} // namespace scan_tools
+
+#endif // SCAN_TOOLS_COMMON_SCAN_CODEC_H
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_COMMON_SCAN_GEOMETRY_H
+#define SCAN_TOOLS_COMMON_SCAN_GEOMETRY_H
+
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/align/aligned_allocator.hpp>
+
+namespace scan_tools
+{
+
+/**
+ * The beam angles of a scan, and their sines and cosines, in double
+ * and float precision. Immutable once built, and shared between all
+ * users of the same geometry through ScanGeometryCache.
+ *
+ * The tables are 32 byte aligned.
+ */
+class ScanGeometry : private boost::noncopyable
+{
+  public:
+
+    ScanGeometry(double angle_min, double angle_increment, unsigned int size);
+
+    double angleMin() const { return angle_min_; }
+    double angleIncrement() const { return angle_increment_; }
+    unsigned int size() const { return size_; }
+
+    bool matches(double angle_min, double angle_increment, unsigned int size) const
+    {
+      return size == size_ && angle_min == angle_min_ && angle_increment == angle_increment_;
+    }
+
+    const double* angles() const { return angles_.data(); }
+    const double* cos() const { return cos_.data(); }
+    const double* sin() const { return sin_.data(); }
+
+    const float* cosFloat() const { return cos_f_.data(); }
+    const float* sinFloat() const { return sin_f_.data(); }
+
+  private:
+
+    template <typename T>
+    struct Table { typedef std::vector<T, boost::alignment::aligned_allocator<T, 32> > type; };
+
+    double angle_min_;
+    double angle_increment_;
+    unsigned int size_;
+
+    Table<double>::type angles_;
+    Table<double>::type cos_;
+    Table<double>::type sin_;
+    Table<float>::type cos_f_;
+    Table<float>::type sin_f_;
+};
+
+typedef boost::shared_ptr<const ScanGeometry> ScanGeometryPtr;
+
+/**
+ * Process wide cache of scan geometries, keyed on (angle_min,
+ * angle_increment, size), so all nodelets of a manager share the tables
+ * of the same scanner. A geometry stays cached as long as it is held by
+ * someone. Thread safe.
+ */
+class ScanGeometryCache
+{
+  public:
+
+    static ScanGeometryPtr get(double angle_min, double angle_increment, unsigned int size);
+
+    /**
+     * Keeps geometry if it still matches, otherwise replaces it from the
+     * cache. Meant to be called for every scan: the check is O(1), the
+     * tables are only looked up or built when the geometry changes.
+     *
+     * @returns True if geometry was replaced.
+     */
+    static bool update(ScanGeometryPtr& geometry,
+                       double angle_min, double angle_increment, unsigned int size)
+    {
+      if (geometry && geometry->matches(angle_min, angle_increment, size)) return false;
+      geometry = get(angle_min, angle_increment, size);
+      return true;
+    }
+};
+
+} // namespace scan_tools
+
+#endif // SCAN_TOOLS_COMMON_SCAN_GEOMETRY_H
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_COMMON_SCAN_MASK_H
+#define SCAN_TOOLS_COMMON_SCAN_MASK_H
+
+#include <vector>
+#include <stdint.h>
+#include <sensor_msgs/LaserScan.h>
+
+namespace scan_tools
+{
+
+/**
+ * Masks the beams of a laser that are of no use: those in given angular
+ * sectors, and those that hit the robot itself, i.e. end within a
+ * footprint polygon around the laser. The mask is precomputed per beam,
+ * and only rebuilt when the scan geometry changes; applying it is a blend
+ * over the ranges. Optionally, the scan is cropped to the span between
+ * the first and the last beam outside of the sectors.
+ */
+class ScanMask
+{
+  public:
+
+    ScanMask();
+
+    // Masks the beams with angles from angle_min to angle_max, wrapping
+    // around if angle_min > angle_max
+    void addSector(double angle_min, double angle_max);
+
+    // Polygon (x0, y0, x1, y1, ...) in the laser frame, around its origin
+    void setFootprint(const std::vector<double>& xy);
+
+    void setCrop(bool crop) { crop_ = crop; size_ = 0; }
+
+    bool empty() const { return sectors_.empty() && footprint_.empty(); }
+
+    /**
+     * Rebuilds the mask if the geometry does not match. O(1) otherwise.
+     *
+     * @returns True if the mask was rebuilt.
+     */
+    bool update(double angle_min, double angle_increment, unsigned int size);
+
+    /**
+     * Writes NaN into the masked beams of scan, and crops it. scan must
+     * have the geometry of the last update().
+     */
+    void apply(sensor_msgs::LaserScan& scan) const;
+
+    // Of the last update()
+    unsigned int sectorMaskedCount() const { return sector_masked_; }
+    unsigned int footprintBeamCount() const { return footprint_beams_; }
+    unsigned int croppedSize() const { return last_ >= first_ ? last_ - first_ + 1 : 0; }
+
+  private:
+
+    std::vector<double> sectors_;     // angle_min, angle_max pairs
+    std::vector<double> footprint_;   // x, y pairs
+    bool crop_;
+
+    // geometry the mask was built for
+    double angle_min_;
+    double angle_increment_;
+    unsigned int size_;
+
+    std::vector<int32_t> keep_;       // all ones for beams outside of the sectors
+    std::vector<float> min_range_;    // footprint range per beam, 0 outside of it
+    int first_, last_;                // span of the cropped scan
+
+    unsigned int sector_masked_;
+    unsigned int footprint_beams_;
+
+    double footprintRange(double angle) const;
+};
+
+} // namespace scan_tools
+
+#endif // SCAN_TOOLS_COMMON_SCAN_MASK_H
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_COMMON_SHADOW_FILTER_H
+#define SCAN_TOOLS_COMMON_SHADOW_FILTER_H
+
+#include <cmath>
+#include <vector>
+#include <stdint.h>
+#include <sensor_msgs/LaserScan.h>
+
+namespace scan_tools
+{
+
+/**
+ * Detects veiling (shadow) points: the spurious returns a laser reports
+ * between an edge and the background behind it. Two returns k beams apart
+ * are a veil if the line through them is seen from the laser under an
+ * angle of less than min_angle, i.e. if the farther one is more than
+ * cos(k*inc) + sin(k*inc) / tan(min_angle) times the nearer one. The
+ * farther point of such a pair is flagged. The factor is precomputed per
+ * offset k up to the window, and only rebuilt when the angle increment
+ * changes.
+ */
+class ShadowFilter
+{
+  public:
+
+    explicit ShadowFilter(double min_angle = 10.0 * M_PI / 180.0, int window = 2);
+
+    void setMinAngle(double min_angle);
+    void setWindow(int window);
+
+    double minAngle() const { return min_angle_; }
+    int window() const { return window_; }
+
+    /**
+     * Flags the veiling beams of the ranges. Beams out of [range_min,
+     * range_max] are never flagged, and never veil others.
+     *
+     * @returns The number of beams flagged.
+     */
+    unsigned int detect(const float* ranges, unsigned int size, float angle_increment,
+                        float range_min, float range_max);
+
+    unsigned int detect(const sensor_msgs::LaserScan& scan);
+
+    // Of the last detect()
+    bool veiling(unsigned int i) const { return flags_[i] != 0; }
+
+    // Detects, and writes NaN into the veiling beams of scan
+    unsigned int filter(sensor_msgs::LaserScan& scan);
+
+  private:
+
+    double min_angle_;
+    int window_;
+
+    float angle_increment_;           // the factors were built for
+    std::vector<float> factors_;      // per offset, factors_[k - 1]
+    std::vector<int32_t> flags_;      // all ones for veiling beams
+
+    void updateFactors(float angle_increment);
+};
+
+} // namespace scan_tools
+
+#endif // SCAN_TOOLS_COMMON_SHADOW_FILTER_H
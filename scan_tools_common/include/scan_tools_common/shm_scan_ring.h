@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_COMMON_SHM_SCAN_RING_H
+#define SCAN_TOOLS_COMMON_SHM_SCAN_RING_H
+
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <sensor_msgs/LaserScan.h>
+
+#include <scan_tools_common/ShmScanRef.h>
+#include <scan_tools_common/laser_scan_view.h>
+
+namespace scan_tools
+{
+
+/**
+ * A ring of fixed size LaserScan slots in a named shared memory segment,
+ * for a single writer process and any number of readers. The writer
+ * overwrites the oldest slot and never waits; each slot is guarded by a
+ * sequence counter, so readers detect when the scan they read was
+ * overwritten.
+ *
+ * The scans are announced with ShmScanRef messages over ROS, which also
+ * carry the header.
+ */
+class ShmScanRing : private boost::noncopyable
+{
+  public:
+
+    /**
+     * Creates the segment name, replacing any previous one, with slots
+     * scans of up to max_beams beams. The writer removes the segment
+     * again when the ring is destroyed.
+     *
+     * @returns NULL if the segment could not be created.
+     */
+    static boost::shared_ptr<ShmScanRing> create(const std::string& name,
+                                                 unsigned int slots,
+                                                 unsigned int max_beams);
+
+    /**
+     * Replaces ring, which has to be a writer's, by a new segment of the
+     * same name with max_beams beams per slot. The old ring no longer
+     * removes the name on destruction, which now belongs to the new one.
+     * Readers that still map the old segment notice the new session.
+     *
+     * @returns False if the segment could not be created; ring is kept.
+     */
+    static bool replace(boost::shared_ptr<ShmScanRing>& ring, unsigned int max_beams);
+
+    // Maps the existing segment name, NULL if there is no ring of that name
+    static boost::shared_ptr<ShmScanRing> open(const std::string& name);
+
+    ~ShmScanRing();
+
+    const std::string& name() const { return name_; }
+    uint64_t session() const;
+    unsigned int slots() const;
+    unsigned int maxBeams() const;
+
+    /**
+     * Writes scan into the next slot and fills ref. Writer only.
+     *
+     * @returns False if the scan has more than maxBeams() beams.
+     */
+    bool write(const sensor_msgs::LaserScan& scan, scan_tools_common::ShmScanRef& ref);
+
+    /**
+     * Points view at the scan of ref, in place. The writer may overwrite
+     * it at any time, so check valid() once done reading.
+     *
+     * @returns False if the scan is not in the ring (anymore).
+     */
+    bool read(const scan_tools_common::ShmScanRef& ref, LaserScanView& view) const;
+
+    // True if the scan of ref has not been overwritten
+    bool valid(const scan_tools_common::ShmScanRef& ref) const;
+
+  private:
+
+    struct RingHeader;
+    struct SlotHeader;
+
+    std::string name_;
+    bool owner_;
+    uint64_t sequence_;   // of the last scan written
+
+    boost::interprocess::mapped_region region_;
+
+    ShmScanRing(const std::string& name, bool owner): name_(name), owner_(owner), sequence_(0) { }
+
+    const RingHeader* ring() const;
+    SlotHeader* slot(unsigned int i) const;
+
+    static uint64_t slotSize(unsigned int max_beams);
+};
+
+/**
+ * Reads the scans announced by ShmScanRef messages, mapping their segment
+ * on first use, and again whenever the writer recreated it.
+ */
+class ShmScanReader
+{
+  public:
+
+    bool read(const scan_tools_common::ShmScanRef& ref, LaserScanView& view);
+    bool valid(const scan_tools_common::ShmScanRef& ref) const;
+
+  private:
+
+    boost::shared_ptr<ShmScanRing> ring_;
+};
+
+} // namespace scan_tools
+
+#endif // SCAN_TOOLS_COMMON_SHM_SCAN_RING_H
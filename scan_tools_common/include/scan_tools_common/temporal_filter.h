@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_COMMON_TEMPORAL_FILTER_H
+#define SCAN_TOOLS_COMMON_TEMPORAL_FILTER_H
+
+#include <vector>
+#include <stdint.h>
+#include <sensor_msgs/LaserScan.h>
+
+namespace scan_tools
+{
+
+/**
+ * Detects sporadic returns (dust, rain, reflections off the floor) of a
+ * laser that stands still: beams whose range is more than tolerance from
+ * the median of the same beam over the last history scans. Beams without
+ * a return count as infinitely far, so that a return where the history
+ * has none is an outlier too.
+ *
+ * The history is a ring of scans, stored beam-major per scan, so that
+ * the medians of 4 adjacent beams are taken at once by a sorting network.
+ * If more than max_outlier_fraction of the valid beams of a scan are
+ * outliers, the laser is taken to be moving: nothing is flagged, and the
+ * history starts over from that scan. Nothing is flagged either until the
+ * history is full.
+ */
+class TemporalFilter
+{
+  public:
+
+    static const int MAX_HISTORY = 15;
+
+    explicit TemporalFilter(int history = 5, float tolerance = 0.1f,
+                            double max_outlier_fraction = 0.2);
+
+    void setHistory(int history);
+    void setTolerance(float tolerance) { tolerance_ = tolerance; }
+    void setMaxOutlierFraction(double fraction) { max_outlier_fraction_ = fraction; }
+
+    // Drops the history, e.g. when the laser is known to move
+    void reset() { count_ = 0; }
+
+    // Takes the scan of the last detect() out of the history again, e.g.
+    // if it turned out to be torn; the oldest scan it replaced is lost
+    void rollback();
+
+    /**
+     * Flags the outliers of the ranges, then adds them to the history.
+     * Ranges out of [range_min, range_max] are never flagged. The history
+     * starts over if the size changes.
+     *
+     * @returns The number of beams flagged.
+     */
+    unsigned int detect(const float* ranges, unsigned int size,
+                        float range_min, float range_max);
+
+    unsigned int detect(const sensor_msgs::LaserScan& scan);
+
+    // Of the last detect()
+    bool outlier(unsigned int i) const { return flags_[i] != 0; }
+
+    // Whether the last detect() found the scan consistent with the full
+    // history
+    bool stationary() const { return stationary_; }
+
+    // Detects, and writes NaN into the outliers of scan
+    unsigned int filter(sensor_msgs::LaserScan& scan);
+
+  private:
+
+    int history_;
+    float tolerance_;
+    double max_outlier_fraction_;
+
+    unsigned int size_;               // beams per scan
+    unsigned int stride_;             // size_, rounded up to 4
+    std::vector<float> ring_;         // history_ scans of stride_ ranges, +inf if invalid
+    int next_;                        // scan to overwrite next
+    int count_;                       // scans in the ring
+
+    std::vector<int32_t> flags_;      // all ones for outliers
+    bool stationary_;
+};
+
+} // namespace scan_tools
+
+#endif // SCAN_TOOLS_COMMON_TEMPORAL_FILTER_H
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_COMMON_TRACE_H
+#define SCAN_TOOLS_COMMON_TRACE_H
+
+#include <cmath>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <ros/ros.h>
+
+namespace scan_tools
+{
+
+/**
+ * Counts of values in power of two bins, the first one below 1/32 ms and
+ * the last one above 131 s, updated without locking.
+ */
+class TraceHistogram : private boost::noncopyable
+{
+  public:
+
+    static const int BINS = 24;
+
+    TraceHistogram();
+
+    void add(double ms);
+
+    // upper bound of bin i, ms
+    static double bound(int i) { return std::ldexp(1.0 / 64.0, i + 1); }
+
+    uint64_t count(int i) const { return bins_[i].load(boost::memory_order_relaxed); }
+
+  private:
+
+    boost::atomic<uint64_t> bins_[BINS];
+};
+
+// Histograms of a traced callback
+struct TracePoint : private boost::noncopyable
+{
+  explicit TracePoint(const std::string& name): name(name) { }
+
+  std::string name;
+  TraceHistogram entry_age;
+  TraceHistogram exit_age;
+  TraceHistogram duration;
+};
+
+// One invocation of a traced callback, for the message with the given stamp
+struct TraceSpan
+{
+  const TracePoint* point;
+  ros::Time stamp;
+  char frame_id[32];        // truncated
+  int64_t begin;            // us, wall clock
+  int64_t end;              // us, wall clock
+  double entry_age;         // ms
+};
+
+/**
+ * Process wide tracer of the scan_tools callbacks.
+ *
+ * Tracing is enabled by the SCAN_TOOLS_TRACE environment variable. If it
+ * is a file name, every span is also recorded into a buffer of the thread
+ * that ran the callback, and all buffers are written to that file in
+ * Chrome trace (also read by Perfetto) JSON format when the process exits.
+ * A %p in the file name is replaced by the process id.
+ *
+ * The histograms of all trace points are published once a second on the
+ * trace topic of the first node handle passed to advertise().
+ */
+class Tracer : private boost::noncopyable
+{
+  public:
+
+    static Tracer& instance();
+
+    bool enabled() const { return enabled_; }
+    bool recording() const { return !filename_.empty(); }
+
+    // The trace point of the given name, created on first use
+    TracePoint& point(const std::string& name);
+
+    // Appends span to the buffer of the calling thread; no locking once
+    // the thread has its buffer
+    void record(const TraceSpan& span);
+
+    // Starts publishing the histograms, if no other node did already
+    void advertise(ros::NodeHandle nh);
+
+    bool writeChromeTrace(const std::string& filename);
+
+  private:
+
+    // Written by its thread only; the oldest spans are overwritten once
+    // it is full
+    struct Buffer
+    {
+      static const unsigned int SIZE = 1 << 16;
+
+      explicit Buffer(int tid): tid(tid), spans(SIZE), count(0) { }
+
+      int tid;
+      std::vector<TraceSpan> spans;
+      boost::atomic<uint64_t> count;
+    };
+
+    Tracer();
+
+    bool enabled_;
+    std::string filename_;
+
+    boost::mutex mutex_;
+    std::map<std::string, TracePoint*> points_;
+    std::list<boost::shared_ptr<Buffer> > buffers_;
+    boost::thread_specific_ptr<Buffer> thread_buffer_;
+
+    ros::Publisher publisher_;
+    ros::WallTimer timer_;
+
+    void publishHistograms(const ros::WallTimerEvent& event);
+
+    static void keepBuffer(Buffer*) { }  // buffers outlive their threads
+    static void writeAtExit();
+};
+
+/**
+ * Traces the enclosing scope as one invocation of point, for the message
+ * with the given stamp and frame. Does nothing unless tracing is enabled.
+ */
+class ScopedTrace : private boost::noncopyable
+{
+  public:
+
+    ScopedTrace(TracePoint& point, const ros::Time& stamp, const std::string& frame_id)
+    {
+      if (Tracer::instance().enabled()) begin(point, stamp, frame_id);
+      else point_ = NULL;
+    }
+
+    ~ScopedTrace()
+    {
+      if (point_) end();
+    }
+
+  private:
+
+    TracePoint* point_;
+    ros::WallTime begin_;
+    TraceSpan span_;
+
+    void begin(TracePoint& point, const ros::Time& stamp, const std::string& frame_id);
+    void end();
+};
+
+} // namespace scan_tools
+
+// Traces the rest of the enclosing scope as the callback name, for the
+// message with the given stamp and frame
+#define SCAN_TOOLS_TRACE(name, stamp, frame_id) \
+  static scan_tools::TracePoint& scan_tools_trace_point_ = \
+    scan_tools::Tracer::instance().point(name); \
+  scan_tools::ScopedTrace scan_tools_trace_(scan_tools_trace_point_, stamp, frame_id)
+
+#endif // SCAN_TOOLS_COMMON_TRACE_H
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_COMMON_VOXEL_HASH_H
+#define SCAN_TOOLS_COMMON_VOXEL_HASH_H
+
+#include <vector>
+#include <stdint.h>
+
+namespace scan_tools
+{
+
+/**
+ * Downsamples 2D points to one point per occupied square cell, in a
+ * single pass: a flat open addressing table maps cells to their
+ * accumulators. Table and cells are kept from one clear() to the next, so
+ * that once sized for the largest scan, downsampling does not allocate.
+ * Cells come out in the order they were first hit, which for a scan is
+ * the order of the beams.
+ */
+class VoxelHash2D
+{
+  public:
+
+    enum Mode
+    {
+      CENTROID,   // mean of the points of a cell
+      NEAREST     // point of a cell closest to its center
+    };
+
+    VoxelHash2D(double leaf_size = 0.05, Mode mode = CENTROID);
+
+    void setLeafSize(double leaf_size) { clear(); leaf_size_ = leaf_size; inv_leaf_size_ = 1.0 / leaf_size; }
+    void setMode(Mode mode) { clear(); mode_ = mode; }
+
+    double leafSize() const { return leaf_size_; }
+    Mode mode() const { return mode_; }
+
+    // Empties the cells, in O(occupied cells)
+    void clear();
+
+    // Makes room for points in up to size cells without growing
+    void reserve(unsigned int size);
+
+    // Drops NaN points and those too far out for their cell index
+    void add(float x, float y);
+
+    unsigned int size() const { return cells_.size(); }
+
+    // The downsampled point of cell i, in [0, size())
+    void point(unsigned int i, float& x, float& y) const;
+
+  private:
+
+    struct Cell
+    {
+      int32_t ix, iy;
+      uint32_t slot;      // in table_, for clear()
+      uint32_t count;
+      float x, y;         // sum of the points, or nearest point
+      float d2;           // of the nearest point to the center
+    };
+
+    double leaf_size_;
+    double inv_leaf_size_;
+    Mode mode_;
+
+    std::vector<int32_t> table_;  // index into cells_, -1 for empty slots
+    std::vector<Cell> cells_;
+    int32_t last_;                // cell of the last point, -1 if none
+
+    int32_t find(int32_t ix, int32_t iy) const;
+    void insert(int32_t ix, int32_t iy, float x, float y, float fx, float fy);
+    void rehash(unsigned int capacity);
+
+    uint32_t hash(int32_t ix, int32_t iy) const
+    {
+      return ((uint32_t)ix * 73856093u) ^ ((uint32_t)iy * 19349663u);
+    }
+};
+
+} // namespace scan_tools
+
+#endif // SCAN_TOOLS_COMMON_VOXEL_HASH_H
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "scan_tools_common/realtime.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+namespace scan_tools
+{
+
+void loadRealtimeParams(const ros::NodeHandle& nh, RealtimeParams& params)
+{
+  if (!nh.getParam("policy", params.policy))
+    params.policy = "other";
+  if (!nh.getParam("priority", params.priority))
+    params.priority = params.policy == "other" ? 0 : 50;
+  if (!nh.getParam("cpus", params.cpus))
+    params.cpus.clear();
+  if (!nh.getParam("lock_memory", params.lock_memory))
+    params.lock_memory = false;
+}
+
+bool applyRealtimeParams(const RealtimeParams& params)
+{
+  bool ok = true;
+
+  // **** scheduling policy and priority
+
+  int policy;
+  if      (params.policy == "other") policy = SCHED_OTHER;
+  else if (params.policy == "fifo")  policy = SCHED_FIFO;
+  else if (params.policy == "rr")    policy = SCHED_RR;
+  else
+  {
+    ROS_WARN("Unknown scheduling policy %s, keeping the default", params.policy.c_str());
+    policy = SCHED_OTHER;
+    ok = false;
+  }
+
+  if (policy != SCHED_OTHER)
+  {
+    sched_param sched;
+    sched.sched_priority = std::max(sched_get_priority_min(policy),
+                           std::min(sched_get_priority_max(policy), params.priority));
+
+    int error = pthread_setschedparam(pthread_self(), policy, &sched);
+    if (error != 0)
+    {
+      ROS_WARN("Could not set scheduling policy %s, priority %d: %s. "
+        "Real-time scheduling needs CAP_SYS_NICE or an rtprio limit "
+        "(/etc/security/limits.conf), continuing with the default",
+        params.policy.c_str(), sched.sched_priority, strerror(error));
+      ok = false;
+    }
+  }
+
+  // **** cpu affinity
+
+  if (!params.cpus.empty())
+  {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+
+    bool valid = true;
+    for (unsigned int i = 0; i < params.cpus.size(); ++i)
+    {
+      if (params.cpus[i] < 0 || params.cpus[i] >= CPU_SETSIZE) valid = false;
+      else CPU_SET(params.cpus[i], &cpus);
+    }
+
+    int error = valid ? pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) : EINVAL;
+    if (error != 0)
+    {
+      ROS_WARN("Could not pin the thread to the given cpus: %s, "
+        "continuing on any cpu", strerror(error));
+      ok = false;
+    }
+  }
+
+  // **** memory locking
+
+  if (params.lock_memory)
+  {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+    {
+      ROS_WARN("Could not lock the process memory: %s. Locking needs "
+        "CAP_IPC_LOCK or a big enough memlock limit (ulimit -l), "
+        "continuing without", strerror(errno));
+      ok = false;
+    }
+  }
+
+  return ok;
+}
+
+CallbackThread::CallbackThread(const RealtimeParams& params, const std::string& name):
+  params_(params),
+  name_(name),
+  running_(true)
+{
+  thread_ = boost::thread(boost::bind(&CallbackThread::run, this));
+}
+
+CallbackThread::~CallbackThread()
+{
+  running_ = false;
+  thread_.join();
+}
+
+void CallbackThread::run()
+{
+  pthread_setname_np(pthread_self(), name_.substr(0, 15).c_str());
+
+  if (applyRealtimeParams(params_))
+    ROS_INFO("Thread %s: policy %s, priority %d, %d pinned cpus%s", name_.c_str(),
+      params_.policy.c_str(), params_.priority, (int)params_.cpus.size(),
+      params_.lock_memory ? ", memory locked" : "");
+
+  while (running_ && ros::ok())
+    queue_.callAvailable(ros::WallDuration(0.1));
+}
+
+} // namespace scan_tools
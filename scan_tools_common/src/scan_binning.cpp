@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "scan_tools_common/scan_binning.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) && !defined(SCAN_TOOLS_NO_SIMD)
+#include <emmintrin.h>
+#define SCAN_BINNING_SSE2
+#endif
+
+namespace scan_tools
+{
+
+// atan2 to within 1e-5 rad, far below any bin size. Same polynomial in
+// both versions, so that they bin alike.
+static const float ATAN_C1 = -0.0464964749f;
+static const float ATAN_C2 =  0.15931422f;
+static const float ATAN_C3 = -0.327622764f;
+
+static inline float fastAtan2(float y, float x)
+{
+  float ax = std::fabs(x), ay = std::fabs(y);
+  float a = std::min(ax, ay) / (std::max(ax, ay) + 1e-30f);
+  float s = a * a;
+  float r = ((ATAN_C1 * s + ATAN_C2) * s + ATAN_C3) * s * a + a;
+  if (ay > ax) r = (float)M_PI_2 - r;
+  if (x < 0.0f) r = (float)M_PI - r;
+  if (y < 0.0f) r = -r;
+  return r;
+}
+
+#ifdef SCAN_BINNING_SSE2
+static inline __m128 fastAtan2(__m128 y, __m128 x)
+{
+  const __m128 sign_mask = _mm_set1_ps(-0.0f);
+
+  __m128 ax = _mm_andnot_ps(sign_mask, x);
+  __m128 ay = _mm_andnot_ps(sign_mask, y);
+  __m128 a = _mm_div_ps(_mm_min_ps(ax, ay), _mm_add_ps(_mm_max_ps(ax, ay), _mm_set1_ps(1e-30f)));
+  __m128 s = _mm_mul_ps(a, a);
+
+  __m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ATAN_C1), s), _mm_set1_ps(ATAN_C2));
+  r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(ATAN_C3));
+  r = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(r, s), a), a);
+
+  __m128 steep = _mm_cmpgt_ps(ay, ax);
+  r = _mm_or_ps(_mm_andnot_ps(steep, r),
+                _mm_and_ps(steep, _mm_sub_ps(_mm_set1_ps((float)M_PI_2), r)));
+
+  __m128 left = _mm_cmplt_ps(x, _mm_setzero_ps());
+  r = _mm_or_ps(_mm_andnot_ps(left, r),
+                _mm_and_ps(left, _mm_sub_ps(_mm_set1_ps((float)M_PI), r)));
+
+  // copy the sign of y
+  return _mm_or_ps(r, _mm_and_ps(y, sign_mask));
+}
+#endif
+
+unsigned int projectScan(const float* ranges, unsigned int n,
+                         float in_min, float in_max,
+                         const PlanarProjection& projection,
+                         const ScanGeometry& geometry,
+                         float angle_min, float angle_increment, int bins,
+                         float out_min, float out_max,
+                         ScanBinningBuffers& buffers,
+                         float z_min, float z_max)
+{
+  buffers.ranges.resize(n);
+  buffers.bins.resize(n);
+
+  const float r00 = projection.r00, r01 = projection.r01, tx = projection.tx;
+  const float r10 = projection.r10, r11 = projection.r11, ty = projection.ty;
+  const float r20 = projection.r20, r21 = projection.r21, tz = projection.tz;
+
+  const float inv_increment = 1.0 / angle_increment;
+
+  // bins around the full circle wrap around: shift the bin coordinate so
+  // that atan2 (-pi to pi) starts within the first turn of bins, then
+  // beams past the last bin continue at the first one
+  float shift = 0.0f;
+  float wrap_at = std::numeric_limits<float>::infinity();
+  if (bins > 0 && bins * angle_increment >= 2.0 * M_PI - 0.5 * angle_increment)
+  {
+    float t_min = (-M_PI - angle_min) * inv_increment + 0.5;
+    shift = bins * std::floor(t_min / bins);
+    wrap_at = bins;
+  }
+
+  const float* cos_a  = geometry.cosFloat();
+  const float* sin_a  = geometry.sinFloat();
+
+  float*   out_ranges = buffers.ranges.data();
+  int32_t* out_bins   = buffers.bins.data();
+
+  unsigned int i = 0;
+  unsigned int dropped = 0;   // for their height
+
+#ifdef SCAN_BINNING_SSE2
+  for (; i + 4 <= n; i += 4)
+  {
+    __m128 r = _mm_loadu_ps(ranges + i);
+    __m128 valid = _mm_and_ps(_mm_cmpgt_ps(r, _mm_set1_ps(in_min)),
+                              _mm_cmplt_ps(r, _mm_set1_ps(in_max)));
+
+    __m128 x = _mm_mul_ps(r, _mm_loadu_ps(cos_a + i));
+    __m128 y = _mm_mul_ps(r, _mm_loadu_ps(sin_a + i));
+
+    __m128 tx4 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(r00), x),
+                                       _mm_mul_ps(_mm_set1_ps(r01), y)), _mm_set1_ps(tx));
+    __m128 ty4 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(r10), x),
+                                       _mm_mul_ps(_mm_set1_ps(r11), y)), _mm_set1_ps(ty));
+    __m128 tz4 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(r20), x),
+                                       _mm_mul_ps(_mm_set1_ps(r21), y)), _mm_set1_ps(tz));
+
+    __m128 in_band = _mm_and_ps(_mm_cmpge_ps(tz4, _mm_set1_ps(z_min)),
+                                _mm_cmple_ps(tz4, _mm_set1_ps(z_max)));
+    dropped += __builtin_popcount(_mm_movemask_ps(_mm_andnot_ps(in_band, valid)));
+    valid = _mm_and_ps(valid, in_band);
+
+    __m128 rho = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(tx4, tx4), _mm_mul_ps(ty4, ty4)));
+    valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(rho, _mm_set1_ps(out_min)),
+                                         _mm_cmple_ps(rho, _mm_set1_ps(out_max))));
+
+    __m128 t = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(fastAtan2(ty4, tx4), _mm_set1_ps(angle_min)),
+                                     _mm_set1_ps(inv_increment)), _mm_set1_ps(0.5f - shift));
+    t = _mm_sub_ps(t, _mm_and_ps(_mm_cmpge_ps(t, _mm_set1_ps(wrap_at)),
+                                 _mm_set1_ps((float)bins)));
+    valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(t, _mm_setzero_ps()),
+                                         _mm_cmplt_ps(t, _mm_set1_ps((float)bins))));
+
+    __m128i valid_i = _mm_castps_si128(valid);
+    __m128i bin = _mm_or_si128(_mm_and_si128(valid_i, _mm_cvttps_epi32(t)),
+                               _mm_andnot_si128(valid_i, _mm_set1_epi32(-1)));
+
+    _mm_storeu_ps(out_ranges + i, rho);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out_bins + i), bin);
+  }
+#endif
+
+  for (; i < n; i++)
+  {
+    float r = ranges[i];
+    out_bins[i] = -1;
+    if (!(r > in_min && r < in_max)) continue;
+
+    float x = r * cos_a[i];
+    float y = r * sin_a[i];
+    float tx_i = r00 * x + r01 * y + tx;
+    float ty_i = r10 * x + r11 * y + ty;
+    float tz_i = r20 * x + r21 * y + tz;
+
+    if (!(tz_i >= z_min && tz_i <= z_max))
+    {
+      dropped++;
+      continue;
+    }
+
+    float rho = std::sqrt(tx_i * tx_i + ty_i * ty_i);
+    if (!(rho >= out_min && rho <= out_max)) continue;
+
+    float t = (fastAtan2(ty_i, tx_i) - angle_min) * inv_increment + (0.5f - shift);
+    if (t >= wrap_at) t -= bins;
+    if (!(t >= 0.0f && t < bins)) continue;
+
+    out_ranges[i] = rho;
+    out_bins[i] = (int32_t)t;
+  }
+
+  return dropped;
+}
+
+unsigned int binScan(const sensor_msgs::LaserScan& scan_msg,
+                     const PlanarProjection& projection,
+                     const ScanGeometry& geometry,
+                     sensor_msgs::LaserScan& binned,
+                     ScanBinningBuffers& buffers,
+                     float z_min, float z_max)
+{
+  unsigned int n = scan_msg.ranges.size();
+
+  unsigned int dropped = projectScan(
+    scan_msg.ranges.data(), n, scan_msg.range_min, scan_msg.range_max,
+    projection, geometry,
+    binned.angle_min, binned.angle_increment, binned.ranges.size(),
+    binned.range_min, binned.range_max,
+    buffers, z_min, z_max);
+
+  // **** keep the closest beam per bin
+
+  const float*   out_ranges = buffers.ranges.data();
+  const int32_t* out_bins   = buffers.bins.data();
+
+  float* binned_ranges = binned.ranges.data();
+  bool intensities = !binned.intensities.empty() && scan_msg.intensities.size() == n;
+
+  for (unsigned int i = 0; i < n; i++)
+  {
+    int32_t b = out_bins[i];
+    if (b < 0 || out_ranges[i] >= binned_ranges[b]) continue;
+
+    binned_ranges[b] = out_ranges[i];
+    if (intensities) binned.intensities[b] = scan_msg.intensities[i];
+  }
+
+  return dropped;
+}
+
+unsigned int flagCloserBeams(const ScanBinningBuffers& buffers,
+                             const float* reference, int reference_size,
+                             float range_min, float range_max, float min_gap,
+                             std::vector<int32_t>& flags)
+{
+  unsigned int n = buffers.bins.size();
+  flags.assign(n, 0);
+
+  unsigned int count = 0;
+
+  for (unsigned int i = 0; i < n; i++)
+  {
+    int32_t b = buffers.bins[i];
+    if (b < 0) continue;
+
+    // the closest valid reference beam of the bin and its neighbours
+    float closest = std::numeric_limits<float>::infinity();
+    for (int j = std::max(b - 1, 0); j <= std::min(b + 1, reference_size - 1); j++)
+    {
+      float r = reference[j];
+      if (r > range_min && r < range_max && r < closest) closest = r;
+    }
+
+    if (closest != std::numeric_limits<float>::infinity() &&
+        buffers.ranges[i] < closest - min_gap)
+    {
+      flags[i] = -1;
+      count++;
+    }
+  }
+
+  return count;
+}
+
+} // namespace scan_tools
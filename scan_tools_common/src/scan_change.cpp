@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "scan_tools_common/scan_change.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) && !defined(SCAN_TOOLS_NO_SIMD)
+#include <emmintrin.h>
+#define SCAN_CHANGE_SSE2
+#endif
+
+namespace scan_tools
+{
+
+double scanChange(const sensor_msgs::LaserScan& scan_msg,
+                  const sensor_msgs::LaserScan& reference,
+                  float tolerance)
+{
+  if (scan_msg.ranges.size() != reference.ranges.size()) return 1.0;
+
+  const unsigned int n = scan_msg.ranges.size();
+  const float* a = scan_msg.ranges.data();
+  const float* b = reference.ranges.data();
+
+  const float a_min = scan_msg.range_min,  a_max = scan_msg.range_max;
+  const float b_min = reference.range_min, b_max = reference.range_max;
+
+  unsigned int valid = 0;     // in either scan
+  unsigned int changed = 0;
+  unsigned int i = 0;
+
+#ifdef SCAN_CHANGE_SSE2
+  const __m128 sign_mask = _mm_set1_ps(-0.0f);
+  const __m128 tol = _mm_set1_ps(tolerance);
+
+  for (; i + 4 <= n; i += 4)
+  {
+    __m128 ra = _mm_loadu_ps(a + i);
+    __m128 rb = _mm_loadu_ps(b + i);
+
+    // ordered compares, so that NaN is invalid
+    __m128 va = _mm_and_ps(_mm_cmpgt_ps(ra, _mm_set1_ps(a_min)), _mm_cmplt_ps(ra, _mm_set1_ps(a_max)));
+    __m128 vb = _mm_and_ps(_mm_cmpgt_ps(rb, _mm_set1_ps(b_min)), _mm_cmplt_ps(rb, _mm_set1_ps(b_max)));
+
+    __m128 far = _mm_cmpgt_ps(_mm_andnot_ps(sign_mask, _mm_sub_ps(ra, rb)), tol);
+    __m128 c = _mm_or_ps(_mm_xor_ps(va, vb), _mm_and_ps(_mm_and_ps(va, vb), far));
+
+    valid   += __builtin_popcount(_mm_movemask_ps(_mm_or_ps(va, vb)));
+    changed += __builtin_popcount(_mm_movemask_ps(c));
+  }
+#endif
+
+  for (; i < n; ++i)
+  {
+    bool va = a[i] > a_min && a[i] < a_max;
+    bool vb = b[i] > b_min && b[i] < b_max;
+
+    if (va || vb) valid++;
+    if (va != vb || (va && std::fabs(a[i] - b[i]) > tolerance)) changed++;
+  }
+
+  return valid > 0 ? (double)changed / valid : 0.0;
+}
+
+} // namespace scan_tools
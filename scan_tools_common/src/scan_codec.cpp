@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "scan_tools_common/scan_codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) && !defined(SCAN_TOOLS_NO_SIMD)
+#include <emmintrin.h>
+#define SCAN_CODEC_SSE2
+#endif
+
+namespace scan_tools
+{
+
+static const unsigned int BLOCK_SIZE = 32;
+static const unsigned int MAX_BITS   = 17;      // of a zigzag coded uint16 difference
+static const int32_t      RANGE_INF  = 65535;
+static const float        RANGE_MAX  = 65534.0f;
+
+// **** range quantization
+
+static inline uint16_t quantizeRange(float range, float inv_resolution)
+{
+  if (range == std::numeric_limits<float>::infinity()) return RANGE_INF;
+  if (!(range > 0.0f)) return 0;   // NaN and negative ranges
+
+  // beyond the resolution's reach, invalid rather than a wrong range
+  float q = range * inv_resolution + 0.5f;
+  return q < RANGE_MAX + 1.0f ? (uint16_t)q : 0;
+}
+
+static inline uint32_t zigzag(int32_t d)
+{
+  return ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t z)
+{
+  return (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+}
+
+// z[i] = zigzag(q[i] - q[i - 1]), for i in [0, n); q[-1] must be readable
+static void zigzagDeltas(const uint16_t* q, unsigned int n, uint32_t* z)
+{
+  unsigned int i = 0;
+
+#ifdef SCAN_CODEC_SSE2
+  const __m128i zero = _mm_setzero_si128();
+
+  for (; i + 8 <= n; i += 8)
+  {
+    __m128i curr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i));
+    __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i - 1));
+
+    __m128i d_lo = _mm_sub_epi32(_mm_unpacklo_epi16(curr, zero), _mm_unpacklo_epi16(prev, zero));
+    __m128i d_hi = _mm_sub_epi32(_mm_unpackhi_epi16(curr, zero), _mm_unpackhi_epi16(prev, zero));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(z + i),
+      _mm_xor_si128(_mm_slli_epi32(d_lo, 1), _mm_srai_epi32(d_lo, 31)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(z + i + 4),
+      _mm_xor_si128(_mm_slli_epi32(d_hi, 1), _mm_srai_epi32(d_hi, 31)));
+  }
+#endif
+
+  for (; i < n; ++i)
+    z[i] = zigzag((int32_t)q[i] - (int32_t)q[(int)i - 1]);
+}
+
+/**
+ * Undoes zigzagDeltas, continuing from the range unit prev, and writes
+ * the ranges. Returns the last range unit; any unit outside of uint16
+ * sets bits above the 16th in bad.
+ */
+static int32_t integrateDeltas(const uint32_t* z, unsigned int n, int32_t prev,
+                               float resolution, float* ranges, uint32_t& bad)
+{
+  unsigned int i = 0;
+
+#ifdef SCAN_CODEC_SSE2
+  const __m128i zero    = _mm_setzero_si128();
+  const __m128i one     = _mm_set1_epi32(1);
+  const __m128i inf_q   = _mm_set1_epi32(RANGE_INF);
+  const __m128  inf     = _mm_set1_ps(std::numeric_limits<float>::infinity());
+  const __m128  res     = _mm_set1_ps(resolution);
+
+  __m128i prev_q = _mm_set1_epi32(prev);
+  __m128i bad_q  = zero;
+
+  for (; i + 4 <= n; i += 4)
+  {
+    __m128i zz = _mm_loadu_si128(reinterpret_cast<const __m128i*>(z + i));
+    __m128i d  = _mm_xor_si128(_mm_srli_epi32(zz, 1), _mm_sub_epi32(zero, _mm_and_si128(zz, one)));
+
+    // prefix sum over the four lanes
+    d = _mm_add_epi32(d, _mm_slli_si128(d, 4));
+    d = _mm_add_epi32(d, _mm_slli_si128(d, 8));
+
+    __m128i q = _mm_add_epi32(d, prev_q);
+    prev_q = _mm_shuffle_epi32(q, _MM_SHUFFLE(3, 3, 3, 3));
+    bad_q  = _mm_or_si128(bad_q, q);
+
+    __m128 r = _mm_mul_ps(_mm_cvtepi32_ps(q), res);
+    __m128 is_inf = _mm_castsi128_ps(_mm_cmpeq_epi32(q, inf_q));
+    _mm_storeu_ps(ranges + i, _mm_or_ps(_mm_andnot_ps(is_inf, r), _mm_and_ps(is_inf, inf)));
+  }
+
+  prev = _mm_cvtsi128_si32(prev_q);
+
+  uint32_t bad_lanes[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(bad_lanes), bad_q);
+  bad |= bad_lanes[0] | bad_lanes[1] | bad_lanes[2] | bad_lanes[3];
+#endif
+
+  for (; i < n; ++i)
+  {
+    prev += unzigzag(z[i]);
+    bad |= (uint32_t)prev;
+    ranges[i] = prev == RANGE_INF ?
+      std::numeric_limits<float>::infinity() : prev * resolution;
+  }
+
+  return prev;
+}
+
+// **** bit packing
+
+static inline unsigned int bitWidth(uint32_t v)
+{
+  unsigned int bits = 0;
+  while (v) { ++bits; v >>= 1; }
+  return bits;
+}
+
+static uint8_t* packBlock(const uint32_t* z, unsigned int n, unsigned int bits, uint8_t* out)
+{
+  uint64_t acc = 0;
+  unsigned int filled = 0;
+
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    acc |= (uint64_t)z[i] << filled;
+    filled += bits;
+    while (filled >= 8)
+    {
+      *out++ = (uint8_t)acc;
+      acc >>= 8;
+      filled -= 8;
+    }
+  }
+  if (filled > 0) *out++ = (uint8_t)acc;
+
+  return out;
+}
+
+static const uint8_t* unpackBlock(const uint8_t* in, unsigned int n, unsigned int bits, uint32_t* z)
+{
+  const uint32_t mask = (1u << bits) - 1;
+  uint64_t acc = 0;
+  unsigned int filled = 0;
+
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    while (filled < bits)
+    {
+      acc |= (uint64_t)*in++ << filled;
+      filled += 8;
+    }
+    z[i] = (uint32_t)acc & mask;
+    acc >>= bits;
+    filled -= bits;
+  }
+
+  return in;
+}
+
+// **** ranges
+
+void encodeRanges(const std::vector<float>& ranges, double resolution,
+                  std::vector<uint8_t>& data)
+{
+  unsigned int n = ranges.size();
+  float inv_resolution = 1.0 / resolution;
+
+  // q[0] is the unit before the first beam
+  std::vector<uint16_t> q(n + 1);
+  q[0] = 0;
+  for (unsigned int i = 0; i < n; ++i)
+    q[i + 1] = quantizeRange(ranges[i], inv_resolution);
+
+  // worst case: every block at full width
+  unsigned int blocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  data.resize(blocks + (n * MAX_BITS + 7) / 8 + blocks);
+  uint8_t* out = data.data();
+
+  uint32_t z[BLOCK_SIZE];
+  for (unsigned int b = 0; b < n; b += BLOCK_SIZE)
+  {
+    unsigned int size = std::min(BLOCK_SIZE, n - b);
+    zigzagDeltas(&q[b + 1], size, z);
+
+    uint32_t any = 0;
+    for (unsigned int i = 0; i < size; ++i) any |= z[i];
+    unsigned int bits = bitWidth(any);
+
+    *out++ = bits;
+    out = packBlock(z, size, bits, out);
+  }
+
+  data.resize(out - data.data());
+}
+
+bool decodeRanges(const std::vector<uint8_t>& data, unsigned int beams,
+                  double resolution, std::vector<float>& ranges)
+{
+  // every block carries at least its header byte, so a beam count the data
+  // cannot hold is rejected before allocating for it
+  if (data.size() < beams / BLOCK_SIZE + (beams % BLOCK_SIZE != 0)) return false;
+
+  ranges.resize(beams);
+
+  const uint8_t* in  = data.data();
+  const uint8_t* end = in + data.size();
+
+  int32_t prev = 0;
+  uint32_t bad = 0;
+  uint32_t z[BLOCK_SIZE];
+
+  for (unsigned int b = 0; b < beams; b += BLOCK_SIZE)
+  {
+    unsigned int size = std::min(BLOCK_SIZE, beams - b);
+
+    if (in == end) return false;
+    unsigned int bits = *in++;
+    if (bits > MAX_BITS || (unsigned int)(end - in) < (size * bits + 7) / 8)
+      return false;
+
+    in = unpackBlock(in, size, bits, z);
+    prev = integrateDeltas(z, size, prev, resolution, &ranges[b], bad);
+  }
+
+  // trailing bytes or units outside of uint16 mean corrupt data
+  return in == end && (bad >> 16) == 0;
+}
+
+// **** scans
+
+void compressScan(const sensor_msgs::LaserScan& scan, double range_resolution,
+                  scan_tools_common::CompressedLaserScan& compressed)
+{
+  compressed.header          = scan.header;
+  compressed.angle_min       = scan.angle_min;
+  compressed.angle_max       = scan.angle_max;
+  compressed.angle_increment = scan.angle_increment;
+  compressed.time_increment  = scan.time_increment;
+  compressed.scan_time       = scan.scan_time;
+  compressed.range_min       = scan.range_min;
+  compressed.range_max       = scan.range_max;
+
+  if (scan.range_max / range_resolution >= RANGE_MAX + 0.5f)
+    ROS_WARN_ONCE("Range resolution %.4f m cannot represent ranges up to %.2f m, "
+      "compressed ranges beyond %.2f m are invalid", range_resolution,
+      scan.range_max, RANGE_MAX * range_resolution);
+
+  compressed.beams            = scan.ranges.size();
+  compressed.range_resolution = range_resolution;
+  encodeRanges(scan.ranges, range_resolution, compressed.ranges);
+
+  // intensities: linear between the extremes of this scan
+
+  const std::vector<float>& intensities = scan.intensities;
+  unsigned int n = intensities.size();
+
+  float i_min =  std::numeric_limits<float>::infinity();
+  float i_max = -std::numeric_limits<float>::infinity();
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    if (!std::isfinite(intensities[i])) continue;
+    i_min = std::min(i_min, intensities[i]);
+    i_max = std::max(i_max, intensities[i]);
+  }
+  if (i_min > i_max) i_min = i_max = 0.0;
+
+  float scale = i_max > i_min ? 255.0 / (i_max - i_min) : 0.0;
+
+  compressed.intensity_min = i_min;
+  compressed.intensity_max = i_max;
+  compressed.intensities.resize(n);
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    compressed.intensities[i] = std::isfinite(intensities[i]) ?
+      (uint8_t)((intensities[i] - i_min) * scale + 0.5f) : 0;
+  }
+}
+
+bool decompressScan(const scan_tools_common::CompressedLaserScan& compressed,
+                    sensor_msgs::LaserScan& scan)
+{
+  if (!compressed.intensities.empty() &&
+      compressed.intensities.size() != compressed.beams)
+    return false;
+
+  if (!(compressed.range_resolution > 0.0) ||
+      !decodeRanges(compressed.ranges, compressed.beams,
+                    compressed.range_resolution, scan.ranges))
+    return false;
+
+  scan.header          = compressed.header;
+  scan.angle_min       = compressed.angle_min;
+  scan.angle_max       = compressed.angle_max;
+  scan.angle_increment = compressed.angle_increment;
+  scan.time_increment  = compressed.time_increment;
+  scan.scan_time       = compressed.scan_time;
+  scan.range_min       = compressed.range_min;
+  scan.range_max       = compressed.range_max;
+
+  unsigned int n = compressed.intensities.size();
+  float step = (compressed.intensity_max - compressed.intensity_min) / 255.0;
+
+  scan.intensities.resize(n);
+  for (unsigned int i = 0; i < n; ++i)
+    scan.intensities[i] = compressed.intensity_min + compressed.intensities[i] * step;
+
+  return true;
+}
+
+// **** subscriber adaptor
+
+CompressedScanSubscriber::CompressedScanSubscriber(
+  ros::NodeHandle nh, const std::string& topic,
+  uint32_t queue_size, const Callback& callback):
+  callback_(callback)
+{
+  subscriber_ = nh.subscribe(
+    topic, queue_size, &CompressedScanSubscriber::compressedCallback, this);
+}
+
+void CompressedScanSubscriber::compressedCallback(
+  const scan_tools_common::CompressedLaserScan::ConstPtr& compressed)
+{
+  sensor_msgs::LaserScan::Ptr scan = boost::make_shared<sensor_msgs::LaserScan>();
+
+  if (!decompressScan(*compressed, *scan))
+  {
+    ROS_WARN_THROTTLE(1.0, "Dropping a corrupt compressed scan on %s",
+      subscriber_.getTopic().c_str());
+    return;
+  }
+
+  callback_(scan);
+}
+
+} // namespace scan_tools
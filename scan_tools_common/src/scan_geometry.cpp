@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "scan_tools_common/scan_geometry.h"
+
+#include <cmath>
+#include <map>
+#include <boost/thread/mutex.hpp>
+#include <boost/tuple/tuple.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
+#include <boost/weak_ptr.hpp>
+
+namespace scan_tools
+{
+
+ScanGeometry::ScanGeometry(double angle_min, double angle_increment, unsigned int size):
+  angle_min_(angle_min),
+  angle_increment_(angle_increment),
+  size_(size),
+  angles_(size), cos_(size), sin_(size), cos_f_(size), sin_f_(size)
+{
+  for (unsigned int i = 0; i < size; ++i)
+  {
+    double angle = angle_min + i * angle_increment;
+    angles_[i] = angle;
+    cos_[i] = std::cos(angle);
+    sin_[i] = std::sin(angle);
+    cos_f_[i] = cos_[i];
+    sin_f_[i] = sin_[i];
+  }
+}
+
+ScanGeometryPtr ScanGeometryCache::get(double angle_min, double angle_increment, unsigned int size)
+{
+  typedef boost::tuple<double, double, unsigned int> Key;
+  typedef std::map<Key, boost::weak_ptr<const ScanGeometry> > Map;
+
+  static boost::mutex mutex;
+  static Map cache;
+
+  Key key(angle_min, angle_increment, size);
+
+  boost::mutex::scoped_lock lock(mutex);
+
+  Map::iterator it = cache.find(key);
+  if (it != cache.end())
+  {
+    ScanGeometryPtr geometry = it->second.lock();
+    if (geometry) return geometry;
+  }
+
+  // drop the geometries nobody uses anymore
+  for (Map::iterator e = cache.begin(); e != cache.end(); )
+  {
+    if (e->second.expired()) cache.erase(e++);
+    else ++e;
+  }
+
+  ScanGeometryPtr geometry(new ScanGeometry(angle_min, angle_increment, size));
+  cache[key] = geometry;
+  return geometry;
+}
+
+} // namespace scan_tools
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "scan_tools_common/scan_mask.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) && !defined(SCAN_TOOLS_NO_SIMD)
+#include <emmintrin.h>
+#define SCAN_MASK_SSE2
+#endif
+
+namespace scan_tools
+{
+
+static inline double normalizeAngle(double a)
+{
+  return std::atan2(std::sin(a), std::cos(a));
+}
+
+ScanMask::ScanMask():
+  crop_(true),
+  angle_min_(0.0),
+  angle_increment_(0.0),
+  size_(0),
+  first_(0),
+  last_(-1),
+  sector_masked_(0),
+  footprint_beams_(0)
+{
+}
+
+void ScanMask::addSector(double angle_min, double angle_max)
+{
+  sectors_.push_back(normalizeAngle(angle_min));
+  sectors_.push_back(normalizeAngle(angle_max));
+  size_ = 0;
+}
+
+void ScanMask::setFootprint(const std::vector<double>& xy)
+{
+  footprint_ = xy;
+  if (footprint_.size() % 2) footprint_.pop_back();
+  size_ = 0;
+}
+
+// Farthest crossing of the beam with the footprint edges, 0 if none
+double ScanMask::footprintRange(double angle) const
+{
+  const double dx = std::cos(angle), dy = std::sin(angle);
+  const unsigned int n = footprint_.size() / 2;
+
+  double range = 0.0;
+  for (unsigned int j = 0; j < n; ++j)
+  {
+    unsigned int k = (j + 1) % n;
+    double px = footprint_[2 * j], py = footprint_[2 * j + 1];
+    double ex = footprint_[2 * k] - px, ey = footprint_[2 * k + 1] - py;
+
+    // t * d = p + u * e
+    double det = ex * dy - ey * dx;
+    if (std::fabs(det) < 1e-12) continue;
+
+    double t = (ex * py - ey * px) / det;
+    double u = (dx * py - dy * px) / det;
+
+    if (t > 0.0 && u >= 0.0 && u <= 1.0) range = std::max(range, t);
+  }
+  return range;
+}
+
+bool ScanMask::update(double angle_min, double angle_increment, unsigned int size)
+{
+  if (size == size_ && angle_min == angle_min_ && angle_increment == angle_increment_)
+    return false;
+
+  angle_min_ = angle_min;
+  angle_increment_ = angle_increment;
+  size_ = size;
+
+  keep_.assign(size, -1);
+  min_range_.assign(size, 0.0f);
+  first_ = 0;
+  last_ = (int)size - 1;
+  sector_masked_ = 0;
+  footprint_beams_ = 0;
+
+  bool first_found = false;
+  for (unsigned int i = 0; i < size; ++i)
+  {
+    double a = normalizeAngle(angle_min + i * angle_increment);
+
+    for (unsigned int s = 0; s < sectors_.size(); s += 2)
+    {
+      double s_min = sectors_[s], s_max = sectors_[s + 1];
+      bool inside = s_min <= s_max ? (a >= s_min && a <= s_max)
+                                   : (a >= s_min || a <= s_max);
+      if (inside) keep_[i] = 0;
+    }
+
+    if (!keep_[i])
+    {
+      sector_masked_++;
+      continue;
+    }
+
+    if (!first_found) first_ = i;
+    first_found = true;
+    last_ = i;
+
+    if (!footprint_.empty())
+    {
+      min_range_[i] = footprintRange(a);
+      if (min_range_[i] > 0.0f) footprint_beams_++;
+    }
+  }
+
+  if (!first_found) last_ = -1;
+  if (!crop_)
+  {
+    first_ = 0;
+    last_ = (int)size - 1;
+  }
+
+  return true;
+}
+
+void ScanMask::apply(sensor_msgs::LaserScan& scan) const
+{
+  if (scan.ranges.size() != size_) return;
+
+  const float invalid = std::numeric_limits<float>::quiet_NaN();
+
+  // cropping moves the beams towards the front, never past a later read
+  float* ranges = scan.ranges.data();
+  const int32_t* keep = keep_.data();
+  const float* min_range = min_range_.data();
+
+  const int first = first_;
+  const int end = last_ + 1;
+  int i = first;
+
+#ifdef SCAN_MASK_SSE2
+  const __m128 v_invalid = _mm_set1_ps(invalid);
+
+  for (; i + 4 <= end; i += 4)
+  {
+    __m128 r = _mm_loadu_ps(ranges + i);
+    __m128 k = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(keep + i)));
+
+    // beyond the footprint, and NaN stays NaN either way
+    __m128 m = _mm_and_ps(k, _mm_cmpge_ps(r, _mm_loadu_ps(min_range + i)));
+
+    _mm_storeu_ps(ranges + i - first, _mm_or_ps(_mm_and_ps(m, r), _mm_andnot_ps(m, v_invalid)));
+  }
+#endif
+
+  for (; i < end; ++i)
+  {
+    float r = ranges[i];
+    ranges[i - first] = (keep[i] && r >= min_range[i]) ? r : invalid;
+  }
+
+  unsigned int size = croppedSize();
+  if (size == scan.ranges.size()) return;
+
+  scan.ranges.resize(size);
+  if (scan.intensities.size() == size_)
+  {
+    scan.intensities.erase(scan.intensities.begin(), scan.intensities.begin() + first);
+    scan.intensities.resize(size);
+  }
+
+  scan.angle_min = angle_min_ + first * angle_increment_;
+  scan.angle_max = scan.angle_min + ((int)size - 1) * angle_increment_;
+}
+
+} // namespace scan_tools
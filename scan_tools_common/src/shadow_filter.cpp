@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "scan_tools_common/shadow_filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) && !defined(SCAN_TOOLS_NO_SIMD)
+#include <emmintrin.h>
+#define SHADOW_FILTER_SSE2
+#endif
+
+namespace scan_tools
+{
+
+ShadowFilter::ShadowFilter(double min_angle, int window):
+  min_angle_(min_angle),
+  window_(std::max(window, 1)),
+  angle_increment_(0)
+{
+}
+
+void ShadowFilter::setMinAngle(double min_angle)
+{
+  min_angle_ = min_angle;
+  factors_.clear();
+}
+
+void ShadowFilter::setWindow(int window)
+{
+  window_ = std::max(window, 1);
+  factors_.clear();
+}
+
+void ShadowFilter::updateFactors(float angle_increment)
+{
+  if ((int)factors_.size() == window_ && angle_increment == angle_increment_) return;
+
+  angle_increment_ = angle_increment;
+  factors_.resize(window_);
+
+  const double cot = 1.0 / std::tan(min_angle_);
+  for (int k = 1; k <= window_; ++k)
+  {
+    double a = k * std::fabs((double)angle_increment);
+    // at least 1, so that only the farther point of a pair is flagged
+    factors_[k - 1] = std::max(1.0, std::cos(a) + std::sin(a) * cot);
+  }
+}
+
+static inline bool valid(float r, float range_min, float range_max)
+{
+  return r >= range_min && r <= range_max;
+}
+
+// beam i is veiling if it is farther than t[k - 1] times a beam k to
+// either side, both valid
+static inline bool veilingBeam(const float* r, int n, int i, int window, const float* t,
+                               float range_min, float range_max)
+{
+  if (!valid(r[i], range_min, range_max)) return false;
+
+  for (int k = 1; k <= window; ++k)
+  {
+    if (i + k < n && valid(r[i + k], range_min, range_max) && r[i] > r[i + k] * t[k - 1]) return true;
+    if (i - k >= 0 && valid(r[i - k], range_min, range_max) && r[i] > r[i - k] * t[k - 1]) return true;
+  }
+  return false;
+}
+
+unsigned int ShadowFilter::detect(const float* r, unsigned int size, float angle_increment,
+                                  float range_min, float range_max)
+{
+  updateFactors(angle_increment);
+  flags_.assign(size, 0);
+
+  const int n = size;
+  const int w = window_;
+  const float* t = factors_.data();
+
+  // the first window beams have neighbours on one side only
+  const int begin = std::min(w, n);
+  unsigned int count = 0;
+  int i = 0;
+
+  for (; i < begin; ++i)
+    if (veilingBeam(r, n, i, w, t, range_min, range_max)) { flags_[i] = -1; count++; }
+
+#ifdef SHADOW_FILTER_SSE2
+  const __m128 lo = _mm_set1_ps(range_min);
+  const __m128 hi = _mm_set1_ps(range_max);
+
+  // each lane only writes the flag of its own beam
+  for (; i + w + 4 <= n; i += 4)
+  {
+    __m128 ri = _mm_loadu_ps(r + i);
+    // ordered compares, so that NaN is invalid
+    __m128 vi = _mm_and_ps(_mm_cmpge_ps(ri, lo), _mm_cmple_ps(ri, hi));
+    __m128 veil = _mm_setzero_ps();
+
+    for (int k = 1; k <= w; ++k)
+    {
+      __m128 tk = _mm_set1_ps(t[k - 1]);
+      __m128 rp = _mm_loadu_ps(r + i + k);
+      __m128 rm = _mm_loadu_ps(r + i - k);
+      __m128 vp = _mm_and_ps(_mm_cmpge_ps(rp, lo), _mm_cmple_ps(rp, hi));
+      __m128 vm = _mm_and_ps(_mm_cmpge_ps(rm, lo), _mm_cmple_ps(rm, hi));
+      veil = _mm_or_ps(veil, _mm_and_ps(vp, _mm_cmpgt_ps(ri, _mm_mul_ps(rp, tk))));
+      veil = _mm_or_ps(veil, _mm_and_ps(vm, _mm_cmpgt_ps(ri, _mm_mul_ps(rm, tk))));
+    }
+    veil = _mm_and_ps(veil, vi);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&flags_[i]), _mm_castps_si128(veil));
+
+    int mask = _mm_movemask_ps(veil);
+    count += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+  }
+#endif
+
+  for (; i < n; ++i)
+    if (veilingBeam(r, n, i, w, t, range_min, range_max)) { flags_[i] = -1; count++; }
+
+  return count;
+}
+
+unsigned int ShadowFilter::detect(const sensor_msgs::LaserScan& scan)
+{
+  return detect(scan.ranges.data(), scan.ranges.size(), scan.angle_increment,
+                scan.range_min, scan.range_max);
+}
+
+unsigned int ShadowFilter::filter(sensor_msgs::LaserScan& scan)
+{
+  unsigned int count = detect(scan);
+  if (count == 0) return 0;
+
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  for (unsigned int i = 0; i < scan.ranges.size(); ++i)
+    if (flags_[i]) scan.ranges[i] = nan;
+
+  return count;
+}
+
+} // namespace scan_tools
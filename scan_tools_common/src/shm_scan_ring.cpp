@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "scan_tools_common/shm_scan_ring.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <unistd.h>
+#include <boost/atomic.hpp>
+#include <boost/static_assert.hpp>
+
+namespace scan_tools
+{
+
+namespace ipc = boost::interprocess;
+
+BOOST_STATIC_ASSERT_MSG(BOOST_ATOMIC_INT64_LOCK_FREE == 2,
+  "the slot sequence counters have to be lock free to work across processes");
+
+static const uint32_t RING_MAGIC   = 0x5343414e;  // "SCAN"
+static const uint32_t RING_VERSION = 1;
+
+struct ShmScanRing::RingHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t session;
+  uint32_t slots;
+  uint32_t max_beams;
+  uint64_t slot_size;   // bytes, including the slot header
+  char padding[32];     // slots start on a cache line
+};
+
+// followed by max_beams ranges and max_beams intensities
+struct ShmScanRing::SlotHeader
+{
+  boost::atomic<uint64_t> state;   // 2n - 1 while scan n is written, 2n once done
+
+  float angle_min;
+  float angle_max;
+  float angle_increment;
+  float time_increment;
+  float scan_time;
+  float range_min;
+  float range_max;
+  uint32_t size;
+  uint32_t has_intensities;
+
+  float* ranges() { return reinterpret_cast<float*>(this + 1); }
+};
+
+uint64_t ShmScanRing::slotSize(unsigned int max_beams)
+{
+  uint64_t size = sizeof(SlotHeader) + 2 * sizeof(float) * (uint64_t)max_beams;
+  return (size + 63) & ~(uint64_t)63;
+}
+
+boost::shared_ptr<ShmScanRing> ShmScanRing::create(const std::string& name,
+                                                   unsigned int slots,
+                                                   unsigned int max_beams)
+{
+  boost::shared_ptr<ShmScanRing> ring;
+  if (slots == 0) return ring;
+
+  uint64_t slot_size = slotSize(max_beams);
+
+  try
+  {
+    ipc::shared_memory_object::remove(name.c_str());
+    ipc::shared_memory_object shm(ipc::create_only, name.c_str(), ipc::read_write);
+    shm.truncate(sizeof(RingHeader) + slots * slot_size);
+
+    ring.reset(new ShmScanRing(name, true));
+    ipc::mapped_region region(shm, ipc::read_write);
+    ring->region_.swap(region);
+  }
+  catch (const ipc::interprocess_exception& ex)
+  {
+    ROS_ERROR("Could not create the shared memory segment %s: %s", name.c_str(), ex.what());
+    return boost::shared_ptr<ShmScanRing>();
+  }
+
+  // a new session for every segment, so readers of a previous one notice,
+  // even if it was replaced within the resolution of the clock
+  static boost::atomic<uint64_t> created(0);
+  RingHeader* header = static_cast<RingHeader*>(ring->region_.get_address());
+  header->session = ros::WallTime::now().toNSec() ^ ((uint64_t)getpid() << 48) ^
+                    ((uint64_t)++created << 32);
+  header->slots = slots;
+  header->max_beams = max_beams;
+  header->slot_size = slot_size;
+
+  for (unsigned int i = 0; i < slots; ++i)
+    new (ring->slot(i)) SlotHeader();   // truncate zeroed the rest
+
+  header->version = RING_VERSION;
+  boost::atomic_thread_fence(boost::memory_order_release);
+  header->magic = RING_MAGIC;
+
+  return ring;
+}
+
+bool ShmScanRing::replace(boost::shared_ptr<ShmScanRing>& ring, unsigned int max_beams)
+{
+  boost::shared_ptr<ShmScanRing> replacement = create(ring->name_, ring->slots(), max_beams);
+  if (!replacement) return false;
+
+  // the old ring must not unlink the name of the new one
+  ring->owner_ = false;
+  ring = replacement;
+  return true;
+}
+
+boost::shared_ptr<ShmScanRing> ShmScanRing::open(const std::string& name)
+{
+  boost::shared_ptr<ShmScanRing> ring;
+
+  try
+  {
+    ipc::shared_memory_object shm(ipc::open_only, name.c_str(), ipc::read_only);
+
+    ring.reset(new ShmScanRing(name, false));
+    ipc::mapped_region region(shm, ipc::read_only);
+    ring->region_.swap(region);
+  }
+  catch (const ipc::interprocess_exception& ex)
+  {
+    ROS_WARN_THROTTLE(5.0, "Could not open the shared memory segment %s: %s",
+      name.c_str(), ex.what());
+    return boost::shared_ptr<ShmScanRing>();
+  }
+
+  const RingHeader* header = ring->ring();
+  if (ring->region_.get_size() < sizeof(RingHeader) ||
+      header->magic != RING_MAGIC || header->version != RING_VERSION ||
+      ring->region_.get_size() < sizeof(RingHeader) + header->slots * header->slot_size)
+  {
+    ROS_WARN_THROTTLE(5.0, "Shared memory segment %s is not a scan ring", name.c_str());
+    return boost::shared_ptr<ShmScanRing>();
+  }
+
+  return ring;
+}
+
+ShmScanRing::~ShmScanRing()
+{
+  if (owner_) ipc::shared_memory_object::remove(name_.c_str());
+}
+
+const ShmScanRing::RingHeader* ShmScanRing::ring() const
+{
+  return static_cast<const RingHeader*>(region_.get_address());
+}
+
+ShmScanRing::SlotHeader* ShmScanRing::slot(unsigned int i) const
+{
+  char* base = static_cast<char*>(region_.get_address()) + sizeof(RingHeader);
+  return reinterpret_cast<SlotHeader*>(base + i * ring()->slot_size);
+}
+
+uint64_t ShmScanRing::session() const { return ring()->session; }
+unsigned int ShmScanRing::slots() const { return ring()->slots; }
+unsigned int ShmScanRing::maxBeams() const { return ring()->max_beams; }
+
+bool ShmScanRing::write(const sensor_msgs::LaserScan& scan, scan_tools_common::ShmScanRef& ref)
+{
+  unsigned int n = scan.ranges.size();
+  if (n > maxBeams()) return false;
+
+  uint64_t sequence = ++sequence_;
+  unsigned int i = sequence % slots();
+  SlotHeader* s = slot(i);
+
+  s->state.store(2 * sequence - 1, boost::memory_order_relaxed);
+  boost::atomic_thread_fence(boost::memory_order_release);
+
+  s->angle_min       = scan.angle_min;
+  s->angle_max       = scan.angle_max;
+  s->angle_increment = scan.angle_increment;
+  s->time_increment  = scan.time_increment;
+  s->scan_time       = scan.scan_time;
+  s->range_min       = scan.range_min;
+  s->range_max       = scan.range_max;
+  s->size            = n;
+  s->has_intensities = scan.intensities.size() == n;
+
+  if (n > 0)
+  {
+    std::memcpy(s->ranges(), &scan.ranges[0], n * sizeof(float));
+    if (s->has_intensities)
+      std::memcpy(s->ranges() + maxBeams(), &scan.intensities[0], n * sizeof(float));
+  }
+
+  s->state.store(2 * sequence, boost::memory_order_release);
+
+  ref.header = scan.header;
+  ref.segment = name_;
+  ref.session = session();
+  ref.slot = i;
+  ref.sequence = sequence;
+  return true;
+}
+
+bool ShmScanRing::read(const scan_tools_common::ShmScanRef& ref, LaserScanView& view) const
+{
+  if (ref.session != session() || ref.slot >= slots()) return false;
+
+  SlotHeader* s = slot(ref.slot);
+  if (s->state.load(boost::memory_order_acquire) != 2 * ref.sequence) return false;
+
+  view.header          = &ref.header;
+  view.angle_min       = s->angle_min;
+  view.angle_max       = s->angle_max;
+  view.angle_increment = s->angle_increment;
+  view.time_increment  = s->time_increment;
+  view.scan_time       = s->scan_time;
+  view.range_min       = s->range_min;
+  view.range_max       = s->range_max;
+  view.size            = std::min(s->size, maxBeams());
+  view.ranges          = s->ranges();
+  view.intensities     = s->has_intensities ? s->ranges() + maxBeams() : NULL;
+
+  return valid(ref);
+}
+
+bool ShmScanRing::valid(const scan_tools_common::ShmScanRef& ref) const
+{
+  boost::atomic_thread_fence(boost::memory_order_acquire);
+  return slot(ref.slot)->state.load(boost::memory_order_relaxed) == 2 * ref.sequence;
+}
+
+bool ShmScanReader::read(const scan_tools_common::ShmScanRef& ref, LaserScanView& view)
+{
+  if (!ring_ || ring_->name() != ref.segment || ring_->session() != ref.session)
+  {
+    ring_ = ShmScanRing::open(ref.segment);
+    if (!ring_) return false;
+
+    if (ring_->session() != ref.session)
+    {
+      ring_.reset();  // the ref is from a segment that was replaced since
+      return false;
+    }
+  }
+
+  return ring_->read(ref, view);
+}
+
+bool ShmScanReader::valid(const scan_tools_common::ShmScanRef& ref) const
+{
+  return ring_ && ring_->valid(ref);
+}
+
+} // namespace scan_tools
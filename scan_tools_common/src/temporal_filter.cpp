@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "scan_tools_common/temporal_filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) && !defined(SCAN_TOOLS_NO_SIMD)
+#include <emmintrin.h>
+#define TEMPORAL_FILTER_SSE2
+#endif
+
+namespace scan_tools
+{
+
+const int TemporalFilter::MAX_HISTORY;
+
+TemporalFilter::TemporalFilter(int history, float tolerance, double max_outlier_fraction):
+  tolerance_(tolerance),
+  max_outlier_fraction_(max_outlier_fraction),
+  size_(0),
+  stride_(0),
+  next_(0),
+  count_(0),
+  stationary_(false)
+{
+  setHistory(history);
+}
+
+void TemporalFilter::rollback()
+{
+  if (count_ == 0) return;
+
+  next_ = (next_ + history_ - 1) % history_;
+  count_--;
+}
+
+void TemporalFilter::setHistory(int history)
+{
+  history_ = std::max(1, std::min(history, (int)MAX_HISTORY));
+  size_ = 0;
+}
+
+// odd-even transposition sort: n passes of compare-exchanges between
+// neighbours sort n values, with min and max only
+static inline void sortNetwork(float* v, int n)
+{
+  for (int p = 0; p < n; ++p)
+    for (int j = p & 1; j + 1 < n; j += 2)
+    {
+      float lo = std::min(v[j], v[j + 1]);
+      v[j + 1] = std::max(v[j], v[j + 1]);
+      v[j] = lo;
+    }
+}
+
+#ifdef TEMPORAL_FILTER_SSE2
+static inline void sortNetwork(__m128* v, int n)
+{
+  for (int p = 0; p < n; ++p)
+    for (int j = p & 1; j + 1 < n; j += 2)
+    {
+      __m128 lo = _mm_min_ps(v[j], v[j + 1]);
+      v[j + 1] = _mm_max_ps(v[j], v[j + 1]);
+      v[j] = lo;
+    }
+}
+#endif
+
+unsigned int TemporalFilter::detect(const float* r, unsigned int size,
+                                    float range_min, float range_max)
+{
+  if (size != size_)
+  {
+    size_ = size;
+    stride_ = (size + 3) & ~3u;
+    ring_.assign((size_t)history_ * stride_, std::numeric_limits<float>::infinity());
+    next_ = 0;
+    count_ = 0;
+  }
+
+  flags_.assign(size, 0);
+
+  const float inf = std::numeric_limits<float>::infinity();
+  const bool full = count_ == history_;
+  const int h = history_;
+  const int mid = h / 2;
+  float* row = &ring_[(size_t)next_ * stride_];
+
+  unsigned int valid = 0;
+  unsigned int count = 0;
+  unsigned int i = 0;
+
+  // the medians are taken before the oldest scan, in row, is overwritten
+
+#ifdef TEMPORAL_FILTER_SSE2
+  const __m128 lo = _mm_set1_ps(range_min);
+  const __m128 hi = _mm_set1_ps(range_max);
+  const __m128 tol = _mm_set1_ps(tolerance_);
+  const __m128 sign_mask = _mm_set1_ps(-0.0f);
+  __m128 v[MAX_HISTORY];
+
+  for (; i + 4 <= size; i += 4)
+  {
+    __m128 ri = _mm_loadu_ps(r + i);
+    // ordered compares, so that NaN is invalid
+    __m128 vi = _mm_and_ps(_mm_cmpge_ps(ri, lo), _mm_cmple_ps(ri, hi));
+    int valid_mask = _mm_movemask_ps(vi);
+
+    if (full)
+    {
+      for (int k = 0; k < h; ++k)
+        v[k] = _mm_loadu_ps(&ring_[(size_t)k * stride_ + i]);
+      sortNetwork(v, h);
+
+      // not within tolerance, so that an infinite median flags too
+      __m128 near = _mm_cmple_ps(_mm_andnot_ps(sign_mask, _mm_sub_ps(ri, v[mid])), tol);
+      __m128 out = _mm_andnot_ps(near, vi);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(&flags_[i]), _mm_castps_si128(out));
+
+      int mask = _mm_movemask_ps(out);
+      count += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+    }
+
+    valid += (valid_mask & 1) + ((valid_mask >> 1) & 1) + ((valid_mask >> 2) & 1) + ((valid_mask >> 3) & 1);
+    _mm_storeu_ps(row + i, _mm_or_ps(_mm_and_ps(vi, ri), _mm_andnot_ps(vi, _mm_set1_ps(inf))));
+  }
+#endif
+
+  float v1[MAX_HISTORY];
+
+  for (; i < size; ++i)
+  {
+    bool vi = r[i] >= range_min && r[i] <= range_max;
+
+    if (full)
+    {
+      for (int k = 0; k < h; ++k)
+        v1[k] = ring_[(size_t)k * stride_ + i];
+      sortNetwork(v1, h);
+
+      if (vi && !(std::fabs(r[i] - v1[mid]) <= tolerance_))
+      {
+        flags_[i] = -1;
+        count++;
+      }
+    }
+
+    if (vi) valid++;
+    row[i] = vi ? r[i] : inf;
+  }
+
+  next_ = (next_ + 1) % h;
+  count_ = std::min(count_ + 1, h);
+
+  // too many outliers: the laser moved, and the history is of no use
+  stationary_ = full && count <= max_outlier_fraction_ * valid;
+  if (full && !stationary_)
+  {
+    flags_.assign(size, 0);
+    count = 0;
+    count_ = 1;
+  }
+
+  return count;
+}
+
+unsigned int TemporalFilter::detect(const sensor_msgs::LaserScan& scan)
+{
+  return detect(scan.ranges.data(), scan.ranges.size(), scan.range_min, scan.range_max);
+}
+
+unsigned int TemporalFilter::filter(sensor_msgs::LaserScan& scan)
+{
+  unsigned int count = detect(scan);
+  if (count == 0) return 0;
+
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  for (unsigned int i = 0; i < scan.ranges.size(); ++i)
+    if (flags_[i]) scan.ranges[i] = nan;
+
+  return count;
+}
+
+} // namespace scan_tools
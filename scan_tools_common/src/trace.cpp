@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "scan_tools_common/trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unistd.h>
+
+#include <scan_tools_common/TraceHistogram.h>
+
+namespace scan_tools
+{
+
+TraceHistogram::TraceHistogram()
+{
+  for (int i = 0; i < BINS; ++i)
+    bins_[i].store(0, boost::memory_order_relaxed);
+}
+
+void TraceHistogram::add(double ms)
+{
+  int i = 0;
+  while (i < BINS - 1 && ms >= bound(i)) ++i;
+  bins_[i].fetch_add(1, boost::memory_order_relaxed);
+}
+
+Tracer& Tracer::instance()
+{
+  // never destroyed: spans may still be recorded, and the publisher must
+  // not outlive roscpp, during static destruction
+  static Tracer* tracer = new Tracer();
+  return *tracer;
+}
+
+Tracer::Tracer():
+  enabled_(false),
+  thread_buffer_(&Tracer::keepBuffer)
+{
+  const char* trace = std::getenv("SCAN_TOOLS_TRACE");
+  if (!trace) return;
+
+  enabled_ = true;
+  filename_ = trace;
+
+  std::string::size_type pid = filename_.find("%p");
+  if (pid != std::string::npos)
+  {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "%d", (int)getpid());
+    filename_.replace(pid, 2, buf);
+  }
+
+  if (recording()) std::atexit(&Tracer::writeAtExit);
+}
+
+TracePoint& Tracer::point(const std::string& name)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+
+  TracePoint*& point = points_[name];
+  if (!point) point = new TracePoint(name);  // kept for the whole process
+  return *point;
+}
+
+void Tracer::record(const TraceSpan& span)
+{
+  Buffer* buffer = thread_buffer_.get();
+  if (!buffer)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    buffers_.push_back(boost::shared_ptr<Buffer>(new Buffer(buffers_.size() + 1)));
+    buffer = buffers_.back().get();
+    thread_buffer_.reset(buffer);
+  }
+
+  uint64_t n = buffer->count.load(boost::memory_order_relaxed);
+  buffer->spans[n % Buffer::SIZE] = span;
+  buffer->count.store(n + 1, boost::memory_order_release);
+}
+
+void Tracer::advertise(ros::NodeHandle nh)
+{
+  if (!enabled_) return;
+
+  boost::mutex::scoped_lock lock(mutex_);
+  if (publisher_) return;
+
+  publisher_ = nh.advertise<scan_tools_common::TraceHistogram>("trace", 10);
+  timer_ = nh.createWallTimer(ros::WallDuration(1.0), &Tracer::publishHistograms, this);
+}
+
+void Tracer::publishHistograms(const ros::WallTimerEvent& event)
+{
+  std::vector<TracePoint*> points;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    for (std::map<std::string, TracePoint*>::const_iterator it = points_.begin();
+         it != points_.end(); ++it)
+      points.push_back(it->second);
+  }
+
+  for (unsigned int i = 0; i < points.size(); ++i)
+  {
+    scan_tools_common::TraceHistogram::Ptr msg =
+      boost::make_shared<scan_tools_common::TraceHistogram>();
+
+    msg->header.stamp = ros::Time::now();
+    msg->name = points[i]->name;
+    msg->bounds.resize(TraceHistogram::BINS);
+    msg->entry_age.resize(TraceHistogram::BINS);
+    msg->exit_age.resize(TraceHistogram::BINS);
+    msg->duration.resize(TraceHistogram::BINS);
+
+    for (int b = 0; b < TraceHistogram::BINS; ++b)
+    {
+      msg->bounds[b] = TraceHistogram::bound(b);
+      msg->entry_age[b] = points[i]->entry_age.count(b);
+      msg->exit_age[b] = points[i]->exit_age.count(b);
+      msg->duration[b] = points[i]->duration.count(b);
+    }
+
+    publisher_.publish(msg);
+  }
+}
+
+bool Tracer::writeChromeTrace(const std::string& filename)
+{
+  std::ofstream file(filename.c_str());
+  if (!file.is_open()) return false;
+
+  int pid = getpid();
+
+  file << "{\"traceEvents\":[\n";
+  bool first = true;
+
+  boost::mutex::scoped_lock lock(mutex_);
+
+  for (std::list<boost::shared_ptr<Buffer> >::const_iterator it = buffers_.begin();
+       it != buffers_.end(); ++it)
+  {
+    const Buffer& buffer = **it;
+
+    // spans written while copying may be torn; meant to run once the
+    // traced threads are idle
+    uint64_t n = buffer.count.load(boost::memory_order_acquire);
+    uint64_t oldest = n > Buffer::SIZE ? n - Buffer::SIZE : 0;
+
+    for (uint64_t s = oldest; s < n; ++s)
+    {
+      const TraceSpan& span = buffer.spans[s % Buffer::SIZE];
+
+      char event[512];
+      std::snprintf(event, sizeof(event),
+        "%s{\"name\":\"%s\",\"cat\":\"scan_tools\",\"ph\":\"X\","
+        "\"ts\":%lld,\"dur\":%lld,\"pid\":%d,\"tid\":%d,"
+        "\"args\":{\"stamp\":\"%u.%09u\",\"frame_id\":\"%s\",\"entry_age_ms\":%.3f}}",
+        first ? "" : ",\n", span.point->name.c_str(),
+        (long long)span.begin, (long long)(span.end - span.begin), pid, buffer.tid,
+        span.stamp.sec, span.stamp.nsec, span.frame_id, span.entry_age);
+
+      file << event;
+      first = false;
+    }
+  }
+
+  file << "\n]}\n";
+  return file.good();
+}
+
+void Tracer::writeAtExit()
+{
+  Tracer& tracer = instance();
+  if (!tracer.writeChromeTrace(tracer.filename_))
+    std::fprintf(stderr, "Could not write trace %s\n", tracer.filename_.c_str());
+}
+
+void ScopedTrace::begin(TracePoint& point, const ros::Time& stamp, const std::string& frame_id)
+{
+  point_ = &point;
+  begin_ = ros::WallTime::now();
+
+  span_.point = &point;
+  span_.stamp = stamp;
+  std::strncpy(span_.frame_id, frame_id.c_str(), sizeof(span_.frame_id) - 1);
+  span_.frame_id[sizeof(span_.frame_id) - 1] = '\0';
+  span_.begin = begin_.toNSec() / 1000;
+
+  if (!stamp.isZero())
+  {
+    span_.entry_age = (ros::Time::now() - stamp).toSec() * 1e3;
+    point.entry_age.add(span_.entry_age);
+  }
+  else
+    span_.entry_age = 0.0;
+}
+
+void ScopedTrace::end()
+{
+  ros::WallTime end = ros::WallTime::now();
+
+  span_.end = end.toNSec() / 1000;
+  point_->duration.add((end - begin_).toSec() * 1e3);
+
+  if (!span_.stamp.isZero())
+    point_->exit_age.add((ros::Time::now() - span_.stamp).toSec() * 1e3);
+
+  Tracer& tracer = Tracer::instance();
+  if (tracer.recording()) tracer.record(span_);
+}
+
+} // namespace scan_tools
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "scan_tools_common/voxel_hash.h"
+
+#include <cmath>
+
+namespace scan_tools
+{
+
+// Smallest table. It is kept at most half full, so that probe sequences
+// stay short.
+static const unsigned int MIN_CAPACITY = 1024;
+
+// std::floor is a library call without SSE4.1
+static inline int32_t floorToInt(float f)
+{
+  int32_t i = (int32_t)f;
+  return i - (f < (float)i);
+}
+
+VoxelHash2D::VoxelHash2D(double leaf_size, Mode mode):
+  leaf_size_(leaf_size),
+  inv_leaf_size_(1.0 / leaf_size),
+  mode_(mode),
+  last_(-1)
+{
+  table_.assign(MIN_CAPACITY, -1);
+}
+
+void VoxelHash2D::clear()
+{
+  for (unsigned int i = 0; i < cells_.size(); ++i)
+    table_[cells_[i].slot] = -1;
+  cells_.clear();
+  last_ = -1;
+}
+
+void VoxelHash2D::reserve(unsigned int size)
+{
+  cells_.reserve(size);
+  if (2 * size > table_.size()) rehash(2 * size);
+}
+
+void VoxelHash2D::rehash(unsigned int capacity)
+{
+  unsigned int size = MIN_CAPACITY;
+  while (size < capacity) size *= 2;
+
+  table_.assign(size, -1);
+
+  const uint32_t mask = size - 1;
+  for (unsigned int i = 0; i < cells_.size(); ++i)
+  {
+    Cell& cell = cells_[i];
+    uint32_t slot = hash(cell.ix, cell.iy) & mask;
+    while (table_[slot] >= 0) slot = (slot + 1) & mask;
+
+    table_[slot] = i;
+    cell.slot = slot;
+  }
+}
+
+void VoxelHash2D::add(float x, float y)
+{
+  float fx = x * (float)inv_leaf_size_;
+  float fy = y * (float)inv_leaf_size_;
+
+  // NaN, and points beyond any int32 cell index
+  if (!(std::fabs(fx) < 1e9f && std::fabs(fy) < 1e9f)) return;
+  int32_t ix = floorToInt(fx);
+  int32_t iy = floorToInt(fy);
+
+  // neighbouring beams mostly fall into the same cell, which then needs
+  // no lookup
+  int32_t index = last_;
+  if (index < 0 || cells_[index].ix != ix || cells_[index].iy != iy)
+  {
+    index = find(ix, iy);
+    if (index < 0)
+    {
+      insert(ix, iy, x, y, fx, fy);
+      return;
+    }
+  }
+
+  Cell& cell = cells_[index];
+  cell.count++;
+
+  if (mode_ == CENTROID)
+  {
+    cell.x += x;
+    cell.y += y;
+  }
+  else
+  {
+    // in cell units, so that it is the same for every leaf size
+    float d2 = (fx - ix - 0.5f) * (fx - ix - 0.5f) + (fy - iy - 0.5f) * (fy - iy - 0.5f);
+    if (d2 < cell.d2)
+    {
+      cell.x = x;
+      cell.y = y;
+      cell.d2 = d2;
+    }
+  }
+  last_ = index;
+}
+
+// Index of the cell in cells_, -1 if it is not there
+int32_t VoxelHash2D::find(int32_t ix, int32_t iy) const
+{
+  const uint32_t mask = table_.size() - 1;
+  uint32_t slot = hash(ix, iy) & mask;
+
+  for (;;)
+  {
+    int32_t index = table_[slot];
+    if (index < 0) return -1;
+
+    const Cell& cell = cells_[index];
+    if (cell.ix == ix && cell.iy == iy) return index;
+
+    slot = (slot + 1) & mask;
+  }
+}
+
+void VoxelHash2D::insert(int32_t ix, int32_t iy, float x, float y, float fx, float fy)
+{
+  // keeping the table at most half full
+  if (2 * (cells_.size() + 1) > table_.size())
+    rehash(2 * table_.size());
+
+  const uint32_t mask = table_.size() - 1;
+  uint32_t slot = hash(ix, iy) & mask;
+  while (table_[slot] >= 0) slot = (slot + 1) & mask;
+
+  Cell cell;
+  cell.ix = ix;
+  cell.iy = iy;
+  cell.slot = slot;
+  cell.count = 1;
+  cell.x = x;
+  cell.y = y;
+  cell.d2 = (fx - ix - 0.5f) * (fx - ix - 0.5f) + (fy - iy - 0.5f) * (fy - iy - 0.5f);
+
+  last_ = cells_.size();
+  table_[slot] = last_;
+  cells_.push_back(cell);
+}
+
+void VoxelHash2D::point(unsigned int i, float& x, float& y) const
+{
+  const Cell& cell = cells_[i];
+
+  if (mode_ == CENTROID)
+  {
+    x = cell.x / cell.count;
+    y = cell.y / cell.count;
+  }
+  else
+  {
+    x = cell.x;
+    y = cell.y;
+  }
+}
+
+} // namespace scan_tools
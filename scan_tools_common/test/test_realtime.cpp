@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <scan_tools_common/realtime.h>
+
+using namespace scan_tools;
+
+TEST(JitterStats, meanStdDevMax)
+{
+  JitterStats stats;
+  stats.add(2.0);
+  stats.add(4.0);
+  stats.add(4.0);
+  stats.add(4.0);
+  stats.add(5.0);
+  stats.add(5.0);
+  stats.add(7.0);
+  stats.add(9.0);
+
+  EXPECT_EQ(8, stats.count());
+  EXPECT_DOUBLE_EQ(5.0, stats.mean());
+  EXPECT_NEAR(2.138, stats.stdDev(), 1e-3);
+  EXPECT_DOUBLE_EQ(9.0, stats.max());
+}
+
+TEST(Realtime, defaultsAreNoop)
+{
+  RealtimeParams params;
+  EXPECT_FALSE(params.enabled());
+  EXPECT_TRUE(applyRealtimeParams(params));
+}
+
+TEST(Realtime, pinsToCpu)
+{
+  cpu_set_t original;
+  ASSERT_EQ(0, pthread_getaffinity_np(pthread_self(), sizeof(original), &original));
+
+  int cpu = 0;
+  while (!CPU_ISSET(cpu, &original)) ++cpu;
+
+  RealtimeParams params;
+  params.cpus.push_back(cpu);
+  EXPECT_TRUE(params.enabled());
+  EXPECT_TRUE(applyRealtimeParams(params));
+
+  cpu_set_t pinned;
+  ASSERT_EQ(0, pthread_getaffinity_np(pthread_self(), sizeof(pinned), &pinned));
+  EXPECT_EQ(1, CPU_COUNT(&pinned));
+  EXPECT_TRUE(CPU_ISSET(cpu, &pinned));
+
+  pthread_setaffinity_np(pthread_self(), sizeof(original), &original);
+}
+
+TEST(Realtime, invalidSettingsFallBack)
+{
+  RealtimeParams params;
+  params.policy = "deadline";
+  params.cpus.push_back(-1);
+  EXPECT_FALSE(applyRealtimeParams(params));
+
+  // still running with the default policy
+  int policy;
+  sched_param sched;
+  ASSERT_EQ(0, pthread_getschedparam(pthread_self(), &policy, &sched));
+  EXPECT_EQ(SCHED_OTHER, policy);
+}
+
+TEST(Realtime, fifoAppliedOrFallsBack)
+{
+  // succeeds with CAP_SYS_NICE or an rtprio limit, fails gracefully otherwise
+  RealtimeParams params;
+  params.policy = "fifo";
+  params.priority = 10;
+  bool applied = applyRealtimeParams(params);
+
+  int policy;
+  sched_param sched;
+  ASSERT_EQ(0, pthread_getschedparam(pthread_self(), &policy, &sched));
+  EXPECT_EQ(applied ? SCHED_FIFO : SCHED_OTHER, policy);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
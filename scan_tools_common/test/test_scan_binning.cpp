@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <limits>
+#include <gtest/gtest.h>
+
+#include <scan_tools_common/scan_binning.h>
+#include "test_scans.h"
+
+using namespace scan_tools;
+
+// 361 beams over 360 degrees, inside a round room of radius 4 m, seen
+// from (px, 0)
+static void makeScan(sensor_msgs::LaserScan& scan, double px)
+{
+  makeRegularScan(361, -M_PI, 2.0 * M_PI / 360, 0.0, scan);
+
+  for (unsigned int i = 0; i < scan.ranges.size(); ++i)
+  {
+    double a = scan.angle_min + i * scan.angle_increment;
+    double b = px * std::cos(a);
+    scan.ranges[i] = -b + std::sqrt(b * b - px * px + 16.0);
+  }
+}
+
+static PlanarProjection translation(float tx)
+{
+  PlanarProjection p;
+  p.r00 = 1; p.r01 = 0; p.tx = tx;
+  p.r10 = 0; p.r11 = 1; p.ty = 0;
+  p.r20 = 0; p.r21 = 0; p.tz = 0;
+  return p;
+}
+
+TEST(ScanBinning, binsIntoOwnBeams)
+{
+  sensor_msgs::LaserScan scan, binned;
+  makeScan(scan, 0.0);
+
+  binned = scan;
+  binned.ranges.assign(361, std::numeric_limits<float>::infinity());
+
+  ScanGeometryPtr geometry = ScanGeometryCache::get(
+    scan.angle_min, scan.angle_increment, scan.ranges.size());
+
+  ScanBinningBuffers buffers;
+  EXPECT_EQ(0u, binScan(scan, translation(0), *geometry, binned, buffers));
+
+  // the first and last beams point the same way, into either end
+  for (unsigned int i = 1; i < 360; ++i)
+  {
+    EXPECT_EQ((int)i, buffers.bins[i]);
+    EXPECT_NEAR(4.0, binned.ranges[i], 1e-5);
+  }
+}
+
+TEST(ScanBinning, flagsNewObstacles)
+{
+  sensor_msgs::LaserScan reference, scan;
+  makeScan(reference, 0.0);
+  makeScan(scan, 0.3);
+
+  // someone 1.5 m ahead of the moved laser
+  for (unsigned int i = 175; i <= 185; ++i)
+    scan.ranges[i] = 1.5;
+  // and beams without a return
+  scan.ranges[10] = std::numeric_limits<float>::quiet_NaN();
+  scan.ranges[11] = 0.0;
+
+  ScanGeometryPtr geometry = ScanGeometryCache::get(
+    scan.angle_min, scan.angle_increment, scan.ranges.size());
+
+  ScanBinningBuffers buffers;
+  projectScan(scan.ranges.data(), scan.ranges.size(), scan.range_min, scan.range_max,
+              translation(0.3), *geometry,
+              reference.angle_min, reference.angle_increment, reference.ranges.size(),
+              0.0f, std::numeric_limits<float>::max(), buffers);
+
+  EXPECT_EQ(-1, buffers.bins[10]);
+  EXPECT_EQ(-1, buffers.bins[11]);
+
+  std::vector<int32_t> flags;
+  EXPECT_EQ(11u, flagCloserBeams(buffers, reference.ranges.data(), reference.ranges.size(),
+                                 reference.range_min, reference.range_max, 0.5f, flags));
+
+  for (unsigned int i = 0; i < scan.ranges.size(); ++i)
+    EXPECT_EQ(i >= 175 && i <= 185, flags[i] != 0) << "beam " << i;
+
+  // no reference to compare to
+  for (unsigned int i = 170; i <= 190; ++i)
+    reference.ranges[i] = std::numeric_limits<float>::infinity();
+
+  EXPECT_EQ(0u, flagCloserBeams(buffers, reference.ranges.data(), reference.ranges.size(),
+                                reference.range_min, reference.range_max, 0.5f, flags));
+}
+
+TEST(ScanBinning, flagsAgainstMaskedKeyframe)
+{
+  sensor_msgs::LaserScan reference, keyframe, scan;
+  makeScan(reference, 0.0);
+  makeScan(keyframe, 0.0);
+  makeScan(scan, 0.0);
+
+  // someone 1.5 m ahead when the keyframe is taken, then a bit to the left
+  for (unsigned int i = 175; i <= 185; ++i)
+    keyframe.ranges[i] = 1.5;
+  for (unsigned int i = 190; i <= 200; ++i)
+    scan.ranges[i] = 1.5;
+
+  ScanGeometryPtr geometry = ScanGeometryCache::get(
+    scan.angle_min, scan.angle_increment, scan.ranges.size());
+
+  const float max = std::numeric_limits<float>::max();
+  ScanBinningBuffers buffers;
+  std::vector<int32_t> flags;
+
+  // the keyframe masks its own dynamic beams, as the scan matcher does
+  projectScan(keyframe.ranges.data(), keyframe.ranges.size(), keyframe.range_min,
+              keyframe.range_max, translation(0), *geometry,
+              reference.angle_min, reference.angle_increment, reference.ranges.size(),
+              0.0f, max, buffers);
+  ASSERT_EQ(11u, flagCloserBeams(buffers, reference.ranges.data(), reference.ranges.size(),
+                                 reference.range_min, reference.range_max, 0.5f, flags));
+  for (unsigned int i = 0; i < keyframe.ranges.size(); ++i)
+    if (flags[i]) keyframe.ranges[i] = -1.0f;
+
+  // only the new position is flagged; where the keyframe saw the person,
+  // the scan now sees the wall behind
+  projectScan(scan.ranges.data(), scan.ranges.size(), scan.range_min, scan.range_max,
+              translation(0), *geometry,
+              keyframe.angle_min, keyframe.angle_increment, keyframe.ranges.size(),
+              0.0f, max, buffers);
+  EXPECT_EQ(11u, flagCloserBeams(buffers, keyframe.ranges.data(), keyframe.ranges.size(),
+                                 keyframe.range_min, keyframe.range_max, 0.5f, flags));
+
+  for (unsigned int i = 0; i < scan.ranges.size(); ++i)
+    EXPECT_EQ(i >= 190 && i <= 200, flags[i] != 0) << "beam " << i;
+}
+
+TEST(ScanBinning, wrapsAroundTheFullCircle)
+{
+  // 8 beams straight back, across the seam of atan2 at +-pi
+  const double inc = 2.0 * M_PI / 360;
+  sensor_msgs::LaserScan scan;
+  makeRegularScan(8, M_PI - 3.2 * inc, inc, 2.0, scan);
+
+  ScanGeometryPtr geometry = ScanGeometryCache::get(
+    scan.angle_min, scan.angle_increment, scan.ranges.size());
+
+  const float max = std::numeric_limits<float>::max();
+  ScanBinningBuffers buffers;
+
+  // 360 bins from -pi: the beams just short of pi round into the first bin
+  projectScan(scan.ranges.data(), scan.ranges.size(), scan.range_min, scan.range_max,
+              translation(0), *geometry, -M_PI, inc, 360, 0.0f, max, buffers);
+  for (unsigned int i = 0; i < 8; ++i)
+    EXPECT_EQ((int)(i + 357) % 360, buffers.bins[i]) << "beam " << i;
+
+  // 360 bins from 0: the beams past pi continue on the same turn
+  projectScan(scan.ranges.data(), scan.ranges.size(), scan.range_min, scan.range_max,
+              translation(0), *geometry, 0.0, inc, 360, 0.0f, max, buffers);
+  for (unsigned int i = 0; i < 8; ++i)
+    EXPECT_EQ((int)i + 177, buffers.bins[i]) << "beam " << i;
+
+  // bins over half the circle do not wrap
+  projectScan(scan.ranges.data(), scan.ranges.size(), scan.range_min, scan.range_max,
+              translation(0), *geometry, -M_PI_2, inc, 180, 0.0f, max, buffers);
+  for (unsigned int i = 0; i < 8; ++i)
+    EXPECT_EQ(-1, buffers.bins[i]) << "beam " << i;
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <limits>
+#include <gtest/gtest.h>
+
+#include <scan_tools_common/scan_change.h>
+#include "test_scans.h"
+
+using namespace scan_tools;
+
+// A wall 2 m in front of the laser, beyond range at the sides
+static void makeScan(unsigned int n, sensor_msgs::LaserScan& scan)
+{
+  makeRegularScan(n, -M_PI / 2.0, M_PI / (n - 1), 0.0, scan);
+  scan.range_min = 0.1;
+  scan.range_max = 10.0;
+
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    double a = scan.angle_min + i * scan.angle_increment;
+    double r = 2.0 / std::max(std::cos(a), 1e-3);
+    scan.ranges[i] = r < 30.0 ? r : std::numeric_limits<float>::infinity();
+  }
+}
+
+static unsigned int countValid(const sensor_msgs::LaserScan& scan)
+{
+  unsigned int valid = 0;
+  for (unsigned int i = 0; i < scan.ranges.size(); ++i)
+    if (scan.ranges[i] > scan.range_min && scan.ranges[i] < scan.range_max) valid++;
+  return valid;
+}
+
+TEST(ScanChange, unchanged)
+{
+  sensor_msgs::LaserScan scan, reference;
+  makeScan(1081, scan);
+  reference = scan;
+
+  // noise within the tolerance
+  for (unsigned int i = 0; i < scan.ranges.size(); i += 3)
+    scan.ranges[i] += 0.01;
+
+  EXPECT_EQ(0.0, scanChange(scan, reference, 0.02));
+}
+
+TEST(ScanChange, maskedFraction)
+{
+  sensor_msgs::LaserScan scan, reference;
+  makeScan(1081, scan);
+  reference = scan;
+
+  unsigned int valid = countValid(scan);
+  ASSERT_LT(valid, scan.ranges.size());
+
+  // a box in front of the wall, 0.5 m closer, over 30 beams (odd
+  // offsets, so that the SIMD blocks and the tail both see it)
+  for (unsigned int i = 501; i < 531; ++i)
+    scan.ranges[i] -= 0.5;
+
+  // beams invalid in both scans do not count
+  EXPECT_DOUBLE_EQ(30.0 / valid, scanChange(scan, reference, 0.05));
+
+  // a beam that loses or gains a return changes too, NaN included
+  scan.ranges[540] = std::numeric_limits<float>::quiet_NaN();
+  scan.ranges[1080] = 5.0;
+  EXPECT_DOUBLE_EQ(32.0 / (valid + 1), scanChange(scan, reference, 0.05));
+}
+
+TEST(ScanChange, limitsAreInvalid)
+{
+  sensor_msgs::LaserScan scan, reference;
+  makeScan(9, reference);
+  scan = reference;
+
+  // a beam at either limit is no return, as for the other nodes
+  for (unsigned int i = 0; i < 9; ++i)
+    scan.ranges[i] = i % 2 ? scan.range_min : scan.range_max;
+  reference.ranges.assign(9, scan.range_max);
+
+  EXPECT_EQ(0.0, scanChange(scan, reference, 0.05));
+}
+
+TEST(ScanChange, sizeMismatch)
+{
+  sensor_msgs::LaserScan scan, reference;
+  makeScan(1081, scan);
+  makeScan(541, reference);
+
+  EXPECT_EQ(1.0, scanChange(scan, reference, 0.05));
+
+  sensor_msgs::LaserScan empty;
+  EXPECT_EQ(0.0, scanChange(empty, empty, 0.05));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
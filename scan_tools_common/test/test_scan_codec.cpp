@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <limits>
+#include <gtest/gtest.h>
+
+#include <scan_tools_common/scan_codec.h>
+#include "test_scans.h"
+
+using namespace scan_tools;
+
+// A wall 2 m in front of the laser, with a box in between
+static void makeScan(unsigned int n, sensor_msgs::LaserScan& scan)
+{
+  makeRegularScan(n, -M_PI / 2.0, M_PI / (n - 1), 0.0, scan);
+  scan.range_min = 0.1;
+
+  scan.intensities.resize(n);
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    double a = scan.angle_min + i * scan.angle_increment;
+    scan.ranges[i] = std::min(2.0 / std::max(std::cos(a), 0.07), 30.0);
+    if (i > n / 3 && i < n / 2) scan.ranges[i] = 0.8;
+    scan.intensities[i] = 1000.0 + 500.0 * std::sin(0.1 * i);
+  }
+}
+
+TEST(ScanCodec, roundTrip)
+{
+  sensor_msgs::LaserScan scan, decoded;
+  makeScan(1081, scan);
+
+  scan_tools_common::CompressedLaserScan compressed;
+  compressScan(scan, 0.001, compressed);
+  ASSERT_TRUE(decompressScan(compressed, decoded));
+
+  ASSERT_EQ(scan.ranges.size(), decoded.ranges.size());
+  ASSERT_EQ(scan.intensities.size(), decoded.intensities.size());
+  EXPECT_FLOAT_EQ(scan.angle_increment, decoded.angle_increment);
+
+  double intensity_step = (compressed.intensity_max - compressed.intensity_min) / 255.0;
+  for (unsigned int i = 0; i < scan.ranges.size(); ++i)
+  {
+    EXPECT_NEAR(scan.ranges[i], decoded.ranges[i], 0.0005 + 1e-5);
+    EXPECT_NEAR(scan.intensities[i], decoded.intensities[i], intensity_step / 2.0 + 1e-3);
+  }
+
+  // a smooth scan takes a fraction of the float ranges and intensities
+  unsigned int raw_size = scan.ranges.size() * 2 * sizeof(float);
+  EXPECT_LT(compressed.ranges.size() + compressed.intensities.size(), raw_size / 3);
+}
+
+TEST(ScanCodec, specialValues)
+{
+  std::vector<float> ranges;
+  ranges.push_back(std::numeric_limits<float>::quiet_NaN());
+  ranges.push_back(std::numeric_limits<float>::infinity());
+  ranges.push_back(-1.0);
+  ranges.push_back(100.0);
+  ranges.push_back(1.5);
+
+  std::vector<uint8_t> data;
+  std::vector<float> decoded;
+  encodeRanges(ranges, 0.001, data);
+  ASSERT_TRUE(decodeRanges(data, ranges.size(), 0.001, decoded));
+
+  EXPECT_EQ(0.0, decoded[0]);
+  EXPECT_EQ(std::numeric_limits<float>::infinity(), decoded[1]);
+  EXPECT_EQ(0.0, decoded[2]);
+  EXPECT_EQ(0.0, decoded[3]);
+  EXPECT_NEAR(1.5, decoded[4], 1e-4);
+}
+
+TEST(ScanCodec, rangesBeyondTheLimit)
+{
+  std::vector<float> ranges;
+  ranges.push_back(65.534);   // the largest range at 1 mm
+  ranges.push_back(65.5342);  // rounds to the same unit
+  ranges.push_back(65.535);   // the +inf code, not a range
+  ranges.push_back(80.0);
+  ranges.push_back(3.0);
+
+  std::vector<uint8_t> data;
+  std::vector<float> decoded;
+  encodeRanges(ranges, 0.001, data);
+  ASSERT_TRUE(decodeRanges(data, ranges.size(), 0.001, decoded));
+
+  EXPECT_NEAR(65.534, decoded[0], 1e-4);
+  EXPECT_NEAR(65.534, decoded[1], 1e-4);
+  EXPECT_EQ(0.0, decoded[2]);
+  EXPECT_EQ(0.0, decoded[3]);
+  EXPECT_NEAR(3.0, decoded[4], 1e-4);
+
+  // a coarser resolution reaches further
+  encodeRanges(ranges, 0.002, data);
+  ASSERT_TRUE(decodeRanges(data, ranges.size(), 0.002, decoded));
+
+  EXPECT_NEAR(80.0, decoded[3], 2e-3);
+}
+
+TEST(ScanCodec, partialBlocks)
+{
+  for (unsigned int n = 0; n < 100; ++n)
+  {
+    std::vector<float> ranges(n), decoded;
+    for (unsigned int i = 0; i < n; ++i)
+      ranges[i] = 0.5 + 0.37 * (i % 7);
+
+    std::vector<uint8_t> data;
+    encodeRanges(ranges, 0.01, data);
+    ASSERT_TRUE(decodeRanges(data, n, 0.01, decoded)) << n << " beams";
+    for (unsigned int i = 0; i < n; ++i)
+      EXPECT_NEAR(ranges[i], decoded[i], 0.005 + 1e-5);
+  }
+}
+
+TEST(ScanCodec, rejectsCorruptData)
+{
+  sensor_msgs::LaserScan scan, decoded;
+  makeScan(181, scan);
+
+  scan_tools_common::CompressedLaserScan compressed;
+  compressScan(scan, 0.001, compressed);
+
+  scan_tools_common::CompressedLaserScan truncated = compressed;
+  truncated.ranges.pop_back();
+  EXPECT_FALSE(decompressScan(truncated, decoded));
+
+  scan_tools_common::CompressedLaserScan bad_width = compressed;
+  bad_width.ranges[0] = 40;
+  EXPECT_FALSE(decompressScan(bad_width, decoded));
+
+  scan_tools_common::CompressedLaserScan bad_beams = compressed;
+  bad_beams.beams += 1;
+  EXPECT_FALSE(decompressScan(bad_beams, decoded));
+
+  // a beam count the data cannot hold fails before allocating for it
+  std::vector<float> ranges;
+  EXPECT_FALSE(decodeRanges(compressed.ranges, 0xFFFFFFFF, 0.001, ranges));
+  EXPECT_TRUE(ranges.empty());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
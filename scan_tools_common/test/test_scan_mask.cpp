@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <limits>
+#include <gtest/gtest.h>
+
+#include <scan_tools_common/scan_mask.h>
+#include "test_scans.h"
+
+using namespace scan_tools;
+
+// 271 beams over 270 degrees, all at 3 m
+static void makeScan(sensor_msgs::LaserScan& scan)
+{
+  makeRegularScan(271, -0.75 * M_PI, 1.5 * M_PI / 270, 3.0, scan);
+
+  scan.intensities.assign(271, 0.0);
+  for (unsigned int i = 0; i < scan.intensities.size(); ++i)
+    scan.intensities[i] = i;
+}
+
+static double beamAngle(const sensor_msgs::LaserScan& scan, unsigned int i)
+{
+  return scan.angle_min + i * scan.angle_increment;
+}
+
+TEST(ScanMask, sectorsAndCrop)
+{
+  sensor_msgs::LaserScan scan;
+  makeScan(scan);
+
+  // the outer 45 degrees on each side, and 10 degrees straight ahead
+  ScanMask mask;
+  mask.addSector(-M_PI, -0.5 * M_PI - 0.001);
+  mask.addSector( 0.5 * M_PI + 0.001, M_PI);
+  mask.addSector(-0.0875, 0.0875);
+
+  EXPECT_TRUE(mask.update(scan.angle_min, scan.angle_increment, scan.ranges.size()));
+  EXPECT_FALSE(mask.update(scan.angle_min, scan.angle_increment, scan.ranges.size()));
+
+  mask.apply(scan);
+
+  ASSERT_EQ(181u, scan.ranges.size());
+  ASSERT_EQ(181u, scan.intensities.size());
+  EXPECT_NEAR(-0.5 * M_PI, scan.angle_min, 1e-6);
+  EXPECT_NEAR( 0.5 * M_PI, scan.angle_max, 1e-6);
+  EXPECT_EQ(45.0f, scan.intensities[0]);
+
+  unsigned int masked = 0;
+  for (unsigned int i = 0; i < scan.ranges.size(); ++i)
+  {
+    bool ahead = std::fabs(beamAngle(scan, i)) <= 0.0875;
+    EXPECT_EQ(ahead, (bool)std::isnan(scan.ranges[i])) << i;
+    if (ahead) masked++;
+  }
+  EXPECT_EQ(11u, masked);
+  EXPECT_EQ(90u + 11u, mask.sectorMaskedCount());
+}
+
+TEST(ScanMask, footprint)
+{
+  sensor_msgs::LaserScan scan;
+  makeScan(scan);
+
+  // a 1 x 0.6 m robot body, the laser 0.2 m behind its front edge
+  std::vector<double> footprint;
+  footprint.push_back( 0.2); footprint.push_back( 0.3);
+  footprint.push_back(-0.8); footprint.push_back( 0.3);
+  footprint.push_back(-0.8); footprint.push_back(-0.3);
+  footprint.push_back( 0.2); footprint.push_back(-0.3);
+
+  // the body itself, in the beams towards the back
+  for (unsigned int i = 0; i < scan.ranges.size(); ++i)
+  {
+    double a = beamAngle(scan, i);
+    if (std::fabs(a) > 2.0) scan.ranges[i] = 0.25;
+  }
+  scan.ranges[135] = std::numeric_limits<float>::quiet_NaN();
+
+  ScanMask mask;
+  mask.setFootprint(footprint);
+  mask.update(scan.angle_min, scan.angle_increment, scan.ranges.size());
+  EXPECT_EQ(271u, mask.footprintBeamCount());
+
+  mask.apply(scan);
+  ASSERT_EQ(271u, scan.ranges.size());
+
+  for (unsigned int i = 0; i < scan.ranges.size(); ++i)
+  {
+    double a = beamAngle(scan, i);
+
+    // the body is at least 0.3 m away towards the back
+    if (std::fabs(a) > 2.0 || i == 135)
+      EXPECT_TRUE(std::isnan(scan.ranges[i])) << i;
+    else
+      EXPECT_EQ(3.0f, scan.ranges[i]) << i;
+  }
+}
+
+TEST(ScanMask, noCrop)
+{
+  sensor_msgs::LaserScan scan;
+  makeScan(scan);
+
+  ScanMask mask;
+  mask.setCrop(false);
+  mask.addSector(-M_PI, -0.5 * M_PI);
+  mask.update(scan.angle_min, scan.angle_increment, scan.ranges.size());
+  mask.apply(scan);
+
+  ASSERT_EQ(271u, scan.ranges.size());
+  EXPECT_TRUE(std::isnan(scan.ranges[0]));
+  EXPECT_EQ(3.0f, scan.ranges[270]);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCAN_TOOLS_COMMON_TEST_TEST_SCANS_H
+#define SCAN_TOOLS_COMMON_TEST_TEST_SCANS_H
+
+#include <sensor_msgs/LaserScan.h>
+
+namespace scan_tools
+{
+
+// A scan of n beams from angle_min, angle_increment apart, all at range,
+// and valid within (0.05, 30) m; the tests shape the ranges from there
+inline void makeRegularScan(unsigned int n, double angle_min, double angle_increment,
+                            float range, sensor_msgs::LaserScan& scan)
+{
+  scan.angle_min       = angle_min;
+  scan.angle_increment = angle_increment;
+  scan.angle_max       = angle_min + (n - 1) * angle_increment;
+  scan.range_min       = 0.05;
+  scan.range_max       = 30.0;
+
+  scan.ranges.assign(n, range);
+  scan.intensities.clear();
+}
+
+} // namespace scan_tools
+
+#endif // SCAN_TOOLS_COMMON_TEST_TEST_SCANS_H
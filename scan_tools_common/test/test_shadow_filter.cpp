@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <gtest/gtest.h>
+
+#include <scan_tools_common/shadow_filter.h>
+#include "test_scans.h"
+
+using namespace scan_tools;
+
+// 200 beams over 60 degrees at 2 m
+static void makeScan(sensor_msgs::LaserScan& scan)
+{
+  makeRegularScan(200, -M_PI / 6, M_PI / 3 / 199, 2.0, scan);
+}
+
+TEST(ShadowFilter, wallIsNotVeiling)
+{
+  sensor_msgs::LaserScan scan;
+  makeScan(scan);
+
+  // a wall 2 m ahead, seen at up to 30 degrees of incidence
+  for (unsigned int i = 0; i < scan.ranges.size(); ++i)
+    scan.ranges[i] = 2.0 / std::cos(scan.angle_min + i * scan.angle_increment);
+
+  ShadowFilter filter;
+  EXPECT_EQ(0u, filter.detect(scan));
+}
+
+TEST(ShadowFilter, edgeFlagsTheFartherPoints)
+{
+  sensor_msgs::LaserScan scan;
+  makeScan(scan);
+
+  // foreground up to beam 99, background at 5 m from beam 102, and a
+  // veil in between
+  for (unsigned int i = 100; i < scan.ranges.size(); ++i)
+    scan.ranges[i] = 5.0;
+  scan.ranges[100] = 3.0;
+  scan.ranges[101] = 4.0;
+
+  ShadowFilter filter(10.0 * M_PI / 180.0, 2);
+  EXPECT_EQ(4u, filter.filter(scan));
+
+  EXPECT_FALSE(filter.veiling(99));
+  for (unsigned int i = 100; i < 104; ++i)
+  {
+    EXPECT_TRUE(filter.veiling(i));
+    EXPECT_TRUE(std::isnan(scan.ranges[i]));
+  }
+  EXPECT_FALSE(filter.veiling(104));
+  EXPECT_EQ(5.0f, scan.ranges[104]);
+
+  // the wider window reaches one more background beam
+  scan.ranges[100] = 3.0;
+  scan.ranges[101] = 4.0;
+  for (unsigned int i = 102; i < 104; ++i)
+    scan.ranges[i] = 5.0;
+
+  filter.setWindow(3);
+  EXPECT_EQ(5u, filter.detect(scan));
+  EXPECT_TRUE(filter.veiling(104));
+}
+
+TEST(ShadowFilter, invalidBeamsAreIgnored)
+{
+  sensor_msgs::LaserScan scan;
+  makeScan(scan);
+
+  scan.ranges[50] = std::numeric_limits<float>::quiet_NaN();
+  scan.ranges[51] = std::numeric_limits<float>::infinity();
+  scan.ranges[52] = 40.0;
+  scan.ranges[53] = 0.01;
+
+  // neither veiling, nor veiled by the beam below range_min
+  ShadowFilter filter;
+  EXPECT_EQ(0u, filter.detect(scan));
+}
+
+TEST(ShadowFilter, matchesReference)
+{
+  srand(42);
+
+  for (int window = 1; window <= 4; ++window)
+  for (unsigned int size = 0; size < 40; ++size)
+  {
+    sensor_msgs::LaserScan scan;
+    makeScan(scan);
+    scan.ranges.resize(size);
+
+    for (unsigned int i = 0; i < size; ++i)
+    {
+      int c = rand() % 10;
+      if      (c == 0) scan.ranges[i] = std::numeric_limits<float>::quiet_NaN();
+      else if (c == 1) scan.ranges[i] = std::numeric_limits<float>::infinity();
+      else             scan.ranges[i] = 0.5 + 5.0 * rand() / RAND_MAX;
+    }
+
+    ShadowFilter filter(0.2, window);
+    unsigned int count = filter.detect(scan);
+
+    const double cot = 1.0 / std::tan(0.2);
+    unsigned int expected = 0;
+
+    for (int i = 0; i < (int)size; ++i)
+    {
+      bool veil = false;
+      for (int k = 1; k <= window; ++k)
+      {
+        double a = k * scan.angle_increment;
+        float t = std::max(1.0, std::cos(a) + std::sin(a) * cot);
+
+        for (int j = i - k; j <= i + k; j += 2 * k)
+        {
+          if (j < 0 || j >= (int)size) continue;
+          if (scan.ranges[i] >= scan.range_min && scan.ranges[i] <= scan.range_max &&
+              scan.ranges[j] >= scan.range_min && scan.ranges[j] <= scan.range_max &&
+              scan.ranges[i] > scan.ranges[j] * t)
+            veil = true;
+        }
+      }
+
+      EXPECT_EQ(veil, filter.veiling(i)) << "window " << window << " size " << size << " beam " << i;
+      if (veil) expected++;
+    }
+
+    EXPECT_EQ(expected, count);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sstream>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+#include <scan_tools_common/shm_scan_ring.h>
+#include "test_scans.h"
+
+using namespace scan_tools;
+
+static std::string segmentName()
+{
+  std::stringstream name;
+  name << "test_shm_scan_ring_" << getpid();
+  return name.str();
+}
+
+static void makeScan(unsigned int n, sensor_msgs::LaserScan& scan)
+{
+  makeRegularScan(n, -1.0, 2.0 / n, 2.5, scan);
+}
+
+TEST(ShmScanRing, writeAndRead)
+{
+  boost::shared_ptr<ShmScanRing> ring = ShmScanRing::create(segmentName(), 2, 100);
+  ASSERT_TRUE(ring);
+
+  sensor_msgs::LaserScan scan;
+  makeScan(100, scan);
+
+  scan_tools_common::ShmScanRef ref;
+  ASSERT_TRUE(ring->write(scan, ref));
+
+  ShmScanReader reader;
+  LaserScanView view;
+  ASSERT_TRUE(reader.read(ref, view));
+  EXPECT_EQ(100u, view.size);
+  EXPECT_EQ(2.5f, view.ranges[99]);
+
+  // too big for the slots
+  makeScan(101, scan);
+  EXPECT_FALSE(ring->write(scan, ref));
+}
+
+TEST(ShmScanRing, replaceKeepsTheName)
+{
+  boost::shared_ptr<ShmScanRing> ring = ShmScanRing::create(segmentName(), 2, 100);
+  ASSERT_TRUE(ring);
+
+  sensor_msgs::LaserScan scan;
+  makeScan(100, scan);
+
+  scan_tools_common::ShmScanRef ref;
+  ShmScanReader reader;
+  LaserScanView view;
+  ASSERT_TRUE(ring->write(scan, ref));
+  ASSERT_TRUE(reader.read(ref, view));
+
+  // resize, and drop the old ring as the writer does
+  uint64_t old_session = ring->session();
+  ASSERT_TRUE(ShmScanRing::replace(ring, 200));
+  EXPECT_NE(old_session, ring->session());
+  EXPECT_EQ(200u, ring->maxBeams());
+  EXPECT_EQ(2u, ring->slots());
+
+  makeScan(200, scan);
+  ASSERT_TRUE(ring->write(scan, ref));
+
+  // the reader of the old segment, and a new one, find the new segment
+  ASSERT_TRUE(reader.read(ref, view));
+  EXPECT_EQ(200u, view.size);
+
+  ShmScanReader new_reader;
+  ASSERT_TRUE(new_reader.read(ref, view));
+  EXPECT_EQ(200u, view.size);
+
+  boost::shared_ptr<ShmScanRing> opened = ShmScanRing::open(segmentName());
+  ASSERT_TRUE(opened);
+  EXPECT_EQ(ring->session(), opened->session());
+
+  // the writer removes the name once done
+  opened.reset();
+  ring.reset();
+  EXPECT_FALSE(ShmScanRing::open(segmentName()));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <limits>
+#include <gtest/gtest.h>
+
+#include <scan_tools_common/temporal_filter.h>
+#include "test_scans.h"
+
+using namespace scan_tools;
+
+// 101 beams at 3 m, the last 10 without a return
+static void makeScan(sensor_msgs::LaserScan& scan)
+{
+  makeRegularScan(101, -M_PI / 2, M_PI / 100, 3.0, scan);
+
+  for (unsigned int i = 91; i < 101; ++i)
+    scan.ranges[i] = std::numeric_limits<float>::infinity();
+}
+
+TEST(TemporalFilter, flagsSporadicReturns)
+{
+  sensor_msgs::LaserScan scan;
+  makeScan(scan);
+
+  TemporalFilter filter(5, 0.1f);
+
+  // nothing until the history is full
+  for (int k = 0; k < 5; ++k)
+  {
+    scan.ranges[0] = 3.0 + 0.01 * k;  // noise within tolerance
+    EXPECT_EQ(0u, filter.detect(scan));
+    EXPECT_FALSE(filter.stationary());
+  }
+
+  // dust in front of the wall, and a return where there was none
+  scan.ranges[10] = 1.0;
+  scan.ranges[95] = 2.0;
+
+  EXPECT_EQ(2u, filter.filter(scan));
+  EXPECT_TRUE(filter.stationary());
+  EXPECT_FALSE(filter.outlier(0));
+  EXPECT_TRUE(filter.outlier(10));
+  EXPECT_TRUE(filter.outlier(95));
+  EXPECT_TRUE(std::isnan(scan.ranges[10]));
+  EXPECT_TRUE(std::isnan(scan.ranges[95]));
+
+  // beams losing their return are not flagged
+  makeScan(scan);
+  scan.ranges[20] = std::numeric_limits<float>::quiet_NaN();
+  EXPECT_EQ(0u, filter.detect(scan));
+}
+
+TEST(TemporalFilter, startsOverWhenMoving)
+{
+  sensor_msgs::LaserScan scan;
+  makeScan(scan);
+
+  TemporalFilter filter(3, 0.1f, 0.2);
+  for (int k = 0; k < 3; ++k)
+    filter.detect(scan);
+
+  // the whole scene moved
+  for (unsigned int i = 0; i < 91; ++i)
+    scan.ranges[i] = 3.5;
+
+  EXPECT_EQ(0u, filter.detect(scan));
+  EXPECT_FALSE(filter.stationary());
+
+  // the history holds the moved scan only, and fills up again
+  EXPECT_EQ(0u, filter.detect(scan));
+  EXPECT_EQ(0u, filter.detect(scan));
+  scan.ranges[10] = 1.0;
+  EXPECT_EQ(1u, filter.detect(scan));
+  EXPECT_TRUE(filter.outlier(10));
+  EXPECT_TRUE(filter.stationary());
+
+  // a change of size starts over too
+  scan.ranges.resize(50);
+  EXPECT_EQ(0u, filter.detect(scan));
+  EXPECT_FALSE(filter.stationary());
+}
+
+TEST(TemporalFilter, rollsBackTornScans)
+{
+  sensor_msgs::LaserScan scan, torn;
+  makeScan(scan);
+  makeScan(torn);
+  for (unsigned int i = 0; i < 50; ++i)
+    torn.ranges[i] = 1.0;
+
+  // a single scan of history, which is never taken to move
+  TemporalFilter filter(1, 0.1f, 1.0);
+  EXPECT_EQ(0u, filter.detect(scan));
+  EXPECT_EQ(50u, filter.detect(torn));
+
+  // without the torn scan, the history is empty again
+  filter.rollback();
+  EXPECT_EQ(0u, filter.detect(scan));
+
+  scan.ranges[10] = 1.0;
+  EXPECT_EQ(1u, filter.detect(scan));
+  EXPECT_TRUE(filter.outlier(10));
+}
+
+TEST(TemporalFilter, matchesReference)
+{
+  srand(42);
+
+  for (int history = 1; history <= 7; ++history)
+  for (unsigned int size = 1; size < 20; ++size)
+  {
+    TemporalFilter filter(history, 0.3f, 1.0);
+    std::deque<std::vector<float> > past;
+
+    for (int k = 0; k < 12; ++k)
+    {
+      sensor_msgs::LaserScan scan;
+      makeScan(scan);
+      scan.ranges.resize(size);
+
+      for (unsigned int i = 0; i < size; ++i)
+      {
+        int c = rand() % 10;
+        if      (c == 0) scan.ranges[i] = std::numeric_limits<float>::quiet_NaN();
+        else if (c == 1) scan.ranges[i] = std::numeric_limits<float>::infinity();
+        else             scan.ranges[i] = 2.0 + 1.0 * rand() / RAND_MAX;
+      }
+
+      unsigned int count = filter.detect(scan);
+      unsigned int expected = 0;
+
+      for (unsigned int i = 0; i < size; ++i)
+      {
+        bool valid = scan.ranges[i] >= scan.range_min && scan.ranges[i] <= scan.range_max;
+        bool out = false;
+
+        if ((int)past.size() == history && valid)
+        {
+          std::vector<float> v;
+          for (unsigned int j = 0; j < past.size(); ++j)
+            v.push_back(past[j][i]);
+          std::sort(v.begin(), v.end());
+          out = !(std::fabs(scan.ranges[i] - v[history / 2]) <= 0.3f);
+        }
+
+        EXPECT_EQ(out, filter.outlier(i)) << "history " << history << " size " << size << " beam " << i;
+        if (out) expected++;
+      }
+      EXPECT_EQ(expected, count);
+
+      std::vector<float> row(size);
+      for (unsigned int i = 0; i < size; ++i)
+      {
+        bool valid = scan.ranges[i] >= scan.range_min && scan.ranges[i] <= scan.range_max;
+        row[i] = valid ? scan.ranges[i] : std::numeric_limits<float>::infinity();
+      }
+      past.push_back(row);
+      if ((int)past.size() > history) past.pop_front();
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
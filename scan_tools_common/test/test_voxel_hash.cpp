@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2011, Ivan Dryanovski, William Morris
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the CCNY Robotics Lab nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <utility>
+#include <gtest/gtest.h>
+
+#include <scan_tools_common/voxel_hash.h>
+
+using namespace scan_tools;
+
+typedef std::pair<int, int> CellIndex;
+
+static CellIndex cellOf(float x, float y, double leaf_size)
+{
+  return CellIndex((int)std::floor(x * (float)(1.0 / leaf_size)),
+                   (int)std::floor(y * (float)(1.0 / leaf_size)));
+}
+
+// Points spread over 20 x 20 m, so that the table has to grow
+static void makePoints(unsigned int n, std::vector<float>& xs, std::vector<float>& ys)
+{
+  srand(42);
+  xs.resize(n);
+  ys.resize(n);
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    xs[i] = -10.0 + 20.0 * rand() / RAND_MAX;
+    ys[i] = -10.0 + 20.0 * rand() / RAND_MAX;
+  }
+}
+
+TEST(VoxelHash2D, centroid)
+{
+  std::vector<float> xs, ys;
+  makePoints(20000, xs, ys);
+
+  VoxelHash2D voxels(0.25, VoxelHash2D::CENTROID);
+
+  // twice, the second time with the table reused
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    std::map<CellIndex, std::pair<double, double> > sums;
+    std::map<CellIndex, int> counts;
+
+    voxels.clear();
+    for (unsigned int i = 0; i < xs.size(); ++i)
+    {
+      voxels.add(xs[i], ys[i]);
+
+      CellIndex c = cellOf(xs[i], ys[i], 0.25);
+      sums[c].first += xs[i];
+      sums[c].second += ys[i];
+      counts[c]++;
+    }
+
+    ASSERT_EQ(counts.size(), voxels.size());
+
+    for (unsigned int i = 0; i < voxels.size(); ++i)
+    {
+      float x, y;
+      voxels.point(i, x, y);
+
+      CellIndex c = cellOf(x, y, 0.25);
+      ASSERT_EQ(1u, counts.count(c));
+      EXPECT_NEAR(sums[c].first / counts[c], x, 1e-4);
+      EXPECT_NEAR(sums[c].second / counts[c], y, 1e-4);
+    }
+  }
+}
+
+TEST(VoxelHash2D, nearest)
+{
+  VoxelHash2D voxels(1.0, VoxelHash2D::NEAREST);
+
+  voxels.add(0.1, 0.1);
+  voxels.add(0.6, 0.4);     // closest to the center at 0.5, 0.5
+  voxels.add(0.9, 0.9);
+  voxels.add(-0.5, 0.5);    // another cell
+  voxels.add(std::numeric_limits<float>::quiet_NaN(), 0.0);
+
+  ASSERT_EQ(2u, voxels.size());
+
+  float x, y;
+  voxels.point(0, x, y);
+  EXPECT_FLOAT_EQ(0.6, x);
+  EXPECT_FLOAT_EQ(0.4, y);
+
+  voxels.point(1, x, y);
+  EXPECT_FLOAT_EQ(-0.5, x);
+  EXPECT_FLOAT_EQ( 0.5, y);
+
+  voxels.clear();
+  EXPECT_EQ(0u, voxels.size());
+}
+
+TEST(VoxelHash2D, dropsPointsBeyondCellIndex)
+{
+  // a fine leaf size puts a point 1000 km out beyond any int32 cell index
+  VoxelHash2D voxels(1e-4, VoxelHash2D::CENTROID);
+
+  voxels.add(1e6, 0.0);
+  voxels.add(0.0, -1e6);
+  voxels.add(std::numeric_limits<float>::infinity(), 0.0);
+  voxels.add(10.0, 10.0);
+
+  ASSERT_EQ(1u, voxels.size());
+
+  float x, y;
+  voxels.point(0, x, y);
+  EXPECT_FLOAT_EQ(10.0, x);
+  EXPECT_FLOAT_EQ(10.0, y);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}